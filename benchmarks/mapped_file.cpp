@@ -0,0 +1,102 @@
+#include "utils/json.hpp"
+#include "utils/mapped_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <string>
+#include <system_error>
+
+namespace {
+
+constexpr std::size_t MiB{1024 * 1024};
+/// the number of times each parse is timed, of which the fastest counts
+constexpr std::size_t Repetitions{3};
+
+///
+/// @brief Write a diagram of one-field classes which is at least a given size
+///
+/// @param file
+/// @param size the size in bytes
+///
+void WriteDiagram(std::string const& file, std::size_t size) {
+  std::ofstream out{file};
+  out << R"({"classes": [)";
+  for (std::size_t i{0}, written{0}; written < size; ++i) {
+    auto const entry = std::format(R"({}{{"name": "C{}", "fields": [{{"name": "f", "type": "int"}}], )"
+                                   R"("methods": [], "position": {{"x": {}, "y": 0}}}})",
+                                   i == 0 ? "" : ", ",
+                                   i,
+                                   i);
+    out << entry;
+    written += entry.size();
+  }
+  out << R"(], "relationships": []})";
+}
+
+///
+/// @brief Time a parse, including freeing the document, several times
+///
+/// @param parse returns whether the document was parsed
+/// @return the fewest elapsed milliseconds, or nullopt if a parse failed
+///
+template <typename Parse> std::optional<double> Measure(Parse&& parse) {
+  std::optional<double> fastest;
+  for (std::size_t i{0}; i < Repetitions; ++i) {
+    auto const start = std::chrono::steady_clock::now();
+    if (not parse()) {
+      return std::nullopt;
+    }
+    double const elapsed{std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count()};
+    fastest = std::min(fastest.value_or(elapsed), elapsed);
+  }
+  return fastest;
+}
+
+} // namespace
+
+///
+/// Compares parsing a saved diagram read through std::ifstream with parsing it straight from a MappedFile, for
+/// diagrams from 1 MiB up to a limit (1 GiB unless a number of MiB is passed).
+///
+/// A parsed document takes about twelve times the size of its text in memory, so the 1 GiB diagram needs 12 GiB.
+///
+// NOLINTNEXTLINE(bugprone-exception-escape)
+int main(int argc, char** argv) {
+  std::size_t limit{1024};
+  if (argc > 2 or (argc == 2 and std::from_chars(argv[1], argv[1] + std::strlen(argv[1]), limit).ec != std::errc{})) {
+    std::println(stderr, "Usage: {} [largest size in MiB]", argv[0]);
+    return 1;
+  }
+  auto const file = (std::filesystem::temp_directory_path() / "mapped-benchmark.json").string();
+  int status{0};
+  for (std::size_t const size : std::array{1ZU, 16ZU, 128ZU, 1024ZU}) {
+    if (size > limit) {
+      break;
+    }
+    WriteDiagram(file, size * MiB);
+    auto const streamed = Measure([&] {
+      std::ifstream in{file};
+      return ParseJson(in).has_value();
+    });
+    auto const mapped = Measure([&] {
+      return MappedFile::Open(file).and_then([](MappedFile const& m) { return ParseJson(m.Contents()); }).has_value();
+    });
+    if (not streamed or not mapped) {
+      std::println(stderr, "{:>5} MiB: cannot parse the diagram", size);
+      status = 1;
+      break;
+    }
+    std::println("{:>5} MiB: ifstream {:9.1f} ms, mmap {:9.1f} ms", size, *streamed, *mapped);
+  }
+  std::filesystem::remove(file);
+  return status;
+}
@@ -11,6 +11,7 @@
 #include <editline/readline.h>
 
 #include <cstring>
+#include <memory>
 
 #include <algorithm>
 #include <print>
@@ -54,6 +55,8 @@ static CommandTree& GetTree() {
 
 static CommandTree* curr_command = nullptr;
 static commands::Completer completer = std::monostate{};
+/// the snapshot the completer refers to, held for the duration of a completion
+static std::shared_ptr<commands::CompletionSnapshot const> snapshot{};
 
 static std::vector<std::string> candidates{};
 static std::size_t candidate_index{0};
@@ -114,6 +117,8 @@ char** RegisterCompletions(char const* text, int start, int end) {
   // always start at the root
   curr_command = std::addressof(GetTree());
   completer = std::monostate{};
+  // completion only lists candidates published after the previous change, so it never waits on the diagram
+  snapshot = commands::CompletionPublisher::GetInstance().Latest();
   for (auto [index, word] : std::views::zip(std::views::iota(0), completed)) {
     if (auto i = std::ranges::find_if(
             curr_command->subcommands,
@@ -131,24 +136,31 @@ char** RegisterCompletions(char const* text, int start, int end) {
       // we have a match -- act upon it
       if (token.starts_with('[')) {
         if (token == "[class_name]") {
-          completer = commands::ClassCompleter{.diagram = model::Diagram::GetInstance(), .name = word};
+          completer = commands::ClassCompleter{
+              .diagram = model::Diagram::GetInstance(), .snapshot = *snapshot, .name = word};
         } else if (token == "[field_name]") {
           auto prev = std::get<commands::ClassCompleter>(completer);
-          completer = commands::FieldCompleter{.iter = prev.Get(), .name = word};
+          completer = commands::FieldCompleter{.diagram = prev.diagram, .cls = prev.Get(), .name = word};
         } else if (token == "[method_signature]") {
           auto prev = std::get<commands::ClassCompleter>(completer);
-          completer = commands::MethodCompleter{.iter = prev.Get(), .signature = word};
+          completer = commands::MethodCompleter{.diagram = prev.diagram, .cls = prev.Get(), .signature = word};
         } else if (token == "[param_name]") {
           auto prev = std::get<commands::MethodCompleter>(completer);
-          completer = commands::ParameterCompleter{.iter = prev.Get(), .name = word};
+          completer = commands::ParameterCompleter{
+              .diagram = prev.diagram, .cls = prev.cls, .method = prev.Get(), .name = word};
         } else if (token == "[class_source]") {
-          completer = commands::RelationshipSourceCompleter{.diagram = model::Diagram::GetInstance(), .source = word};
+          completer = commands::RelationshipSourceCompleter{
+              .diagram = model::Diagram::GetInstance(), .snapshot = *snapshot, .source = word};
         } else if (token == "[class_destination]") {
           auto prev = std::get<commands::RelationshipSourceCompleter>(completer);
-          completer =
-              commands::RelationshipDestinationCompleter{.diagram = prev.diagram, .source = prev.source, .dest = word};
+          completer = commands::RelationshipDestinationCompleter{
+              .diagram = prev.diagram, .snapshot = prev.snapshot, .source = prev.source, .dest = word};
         } else if (token == "[relationship_type]") {
           completer = commands::RelationshipTypeCompleter{};
+        } else if (token == "[type]") {
+          completer = commands::TypeCompleter{.snapshot = *snapshot, .prefix = word};
+        } else if (token == "[setting]") {
+          completer = commands::SettingCompleter{};
         } else if (token == "[filename]") {
           completer = std::monostate{};
           // fall back to file autocomplete
@@ -236,36 +248,59 @@ DOCTEST_TEST_SUITE("cli") {
     std::vector<std::string> list;
 
     ENABLE_IF_TEST(list = GetCompletionsForLine(""));
+    CHECK(std::ranges::contains(list, "at"));
+    CHECK(std::ranges::contains(list, "blame"));
     CHECK(std::ranges::contains(list, "class"));
+    CHECK(std::ranges::contains(list, "clones"));
+    CHECK(std::ranges::contains(list, "compact"));
     CHECK(std::ranges::contains(list, "exit"));
+    CHECK(std::ranges::contains(list, "extract"));
+    CHECK(std::ranges::contains(list, "extract-with-types"));
     CHECK(std::ranges::contains(list, "field"));
     CHECK(std::ranges::contains(list, "help"));
+    CHECK(std::ranges::contains(list, "invariant"));
+    CHECK(std::ranges::contains(list, "lint"));
     CHECK(std::ranges::contains(list, "list"));
     CHECK(std::ranges::contains(list, "load"));
     CHECK(std::ranges::contains(list, "method"));
     CHECK(std::ranges::contains(list, "parameter"));
     CHECK(std::ranges::contains(list, "parameters"));
+    CHECK(std::ranges::contains(list, "path"));
+    CHECK(std::ranges::contains(list, "path-via"));
+    CHECK(std::ranges::contains(list, "paths"));
+    CHECK(std::ranges::contains(list, "query"));
     CHECK(std::ranges::contains(list, "redo"));
     CHECK(std::ranges::contains(list, "relationship"));
     CHECK(std::ranges::contains(list, "save"));
+    CHECK(std::ranges::contains(list, "search"));
+    CHECK(std::ranges::contains(list, "set"));
     CHECK(std::ranges::contains(list, "undo"));
-    CHECK_EQ(list.size(), 13);
+    CHECK_EQ(list.size(), 27);
 
     ENABLE_IF_TEST(list = GetCompletionsForLine("p"));
     CHECK(std::ranges::contains(list, "parameter"));
     CHECK(std::ranges::contains(list, "parameters"));
-    CHECK_EQ(list.size(), 2);
+    CHECK(std::ranges::contains(list, "paths"));
+    CHECK_EQ(list.size(), 5);
 
     ENABLE_IF_TEST(list = GetCompletionsForLine("class "));
     CHECK(std::ranges::contains(list, "add"));
     CHECK(std::ranges::contains(list, "remove"));
     CHECK(std::ranges::contains(list, "rename"));
-    CHECK_EQ(list.size(), 3);
+    CHECK(std::ranges::contains(list, "move-all"));
+    CHECK(std::ranges::contains(list, "export-positions"));
+    CHECK_EQ(list.size(), 5);
 
     auto& d = model::Diagram::GetInstance();
     REQUIRE(d.AddClass("alpha"));
     REQUIRE(d.AddClass("artist"));
     REQUIRE(d.AddClass("beta"));
+    // completion only sees what was published after the latest change
+    auto const publish = [&] {
+      commands::CompletionPublisher::GetInstance().Refresh(d);
+      commands::CompletionPublisher::GetInstance().Wait();
+    };
+    publish();
 
     ENABLE_IF_TEST(list = GetCompletionsForLine("class remove "));
     CHECK(std::ranges::contains(list, "alpha"));
@@ -278,17 +313,23 @@ DOCTEST_TEST_SUITE("cli") {
     CHECK(std::ranges::contains(list, "artist"));
     CHECK_EQ(list.size(), 2);
 
-    [[maybe_unused]] auto alpha = d.GetClass("alpha").value();
+    auto const edit_alpha = [&](std::function<Result<void>(model::Class&)> const& edit) {
+      REQUIRE(d.EditClass("alpha", edit));
+    };
 
-    REQUIRE(alpha->AddField("x", "int"));
-    REQUIRE(alpha->AddField("y", "int"));
+    edit_alpha([](model::Class& c) { return c.AddField("x", "int"); });
+    edit_alpha([](model::Class& c) { return c.AddField("y", "int"); });
+    publish();
     ENABLE_IF_TEST(list = GetCompletionsForLine("field remove alpha "));
     CHECK(std::ranges::contains(list, "x"));
     CHECK(std::ranges::contains(list, "y"));
     CHECK_EQ(list.size(), 2);
 
-    REQUIRE(alpha->AddMethod("fun", "void", *model::Parameter::MultipleFromString("enable:bool,flag:bool")));
-    REQUIRE(alpha->AddMethod("fun", "int", {}));
+    edit_alpha([](model::Class& c) {
+      return c.AddMethod("fun", "void", *model::Parameter::MultipleFromString("enable:bool,flag:bool"));
+    });
+    edit_alpha([](model::Class& c) { return c.AddMethod("fun", "int", {}); });
+    publish();
     ENABLE_IF_TEST(list = GetCompletionsForLine("method remove alpha "));
     CHECK(std::ranges::contains(list, "fun()"));
     CHECK(std::ranges::contains(list, "fun(bool,bool)"));
@@ -308,6 +349,7 @@ DOCTEST_TEST_SUITE("cli") {
 
     REQUIRE(d.AddRelationship("alpha", "alpha", model::RelationshipType::Composition));
     REQUIRE(d.AddRelationship("alpha", "beta", model::RelationshipType::Inheritance));
+    publish();
     ENABLE_IF_TEST(list = GetCompletionsForLine("relationship remove "));
     CHECK(std::ranges::contains(list, "alpha"));
     CHECK_EQ(list.size(), 1);
@@ -317,6 +359,10 @@ DOCTEST_TEST_SUITE("cli") {
     CHECK(std::ranges::contains(list, "beta"));
     CHECK_EQ(list.size(), 2);
 
+    // types are offered most used first
+    ENABLE_IF_TEST(list = GetCompletionsForLine("field add alpha z "));
+    CHECK_EQ(list, std::vector<std::string>{"int", "bool", "void"});
+
     ENABLE_IF_TEST(list = GetCompletionsForLine("load b"));
     CHECK(list.empty());
 
@@ -1,5 +1,10 @@
+#include "readline_view.hpp"
+
 #include "cli/readline_controller.hpp"
 #include "commands/base_commands.hpp"
+#include "commands/commands.hpp"
+#include "commands/completers.hpp"
+#include "commands/session.hpp"
 #include "commands/timeline.hpp"
 #include "model/diagram.hpp"
 #include "utils/io_context.hpp"
@@ -8,14 +13,30 @@
 
 namespace cli {
 
-int CLI() {
+int CLI(std::string_view session, bool resume) {
   model::Diagram& diagram = model::Diagram::GetInstance();
+  auto& completions = commands::CompletionPublisher::GetInstance();
   ReadlineInterface repl{"UML> "};
+  if (resume) {
+    if (auto resumed = commands::ResumeSession(session, diagram); not resumed) {
+      repl.DisplayMessage(resumed.error());
+    }
+  }
+  // completion candidates are prepared while the user types, and the diagram is left alone until they are
+  completions.Refresh(diagram);
   while (repl.ReadCommand()) {
     auto tokens = repl.GetTokenizedCommand();
     auto res = commands::Command::From(tokens).and_then([&]<typename Cmd>(Cmd&& cmd) {
       repl.AddCommandToHistory();
-      return cmd->Commit(diagram).transform([&] { commands::Timeline::GetInstance().Add(std::forward<Cmd>(cmd)); });
+      completions.Wait();
+      return cmd->Commit(diagram).transform([&] {
+        // only a change to the diagram (including undoing or redoing one) changes what there is to complete
+        if (cmd->Trackable() or cmd->Text() == commands::UndoCommand::CommandName or
+            cmd->Text() == commands::RedoCommand::CommandName) {
+          completions.Refresh(diagram);
+        }
+        commands::Timeline::GetInstance().Add(std::forward<Cmd>(cmd));
+      });
     });
     if (res.has_value()) {
       if (tokens[0] == "exit") {
@@ -25,6 +46,12 @@ int CLI() {
       repl.DisplayMessage(res.error());
     }
   }
+  completions.Wait();
+  if (not session.empty()) {
+    if (auto saved = commands::SaveSession(session, diagram); not saved) {
+      repl.DisplayMessage(saved.error());
+    }
+  }
   return 0;
 }
 
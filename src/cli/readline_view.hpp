@@ -1,5 +1,16 @@
 #pragma once
 
+#include <string_view>
+
 namespace cli {
-int CLI();
-}
+
+///
+/// @brief Read and run commands until exit
+///
+/// @param session the session file written on exit (no session is written if empty)
+/// @param resume whether to restore the session file before reading any command
+/// @return the exit code of the program
+///
+int CLI(std::string_view session = {}, bool resume = false);
+
+} // namespace cli
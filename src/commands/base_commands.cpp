@@ -1,14 +1,23 @@
 #include "base_commands.hpp"
 
 #include "commands/commands.hpp"
+#include "commands/timeline.hpp"
 #include "model/diagram.hpp"
+#include "model/invariants.hpp"
+#include "utils/settings.hpp"
 #include "utils/utils.hpp"
 
 #include <doctest/doctest.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <expected>
+#include <format>
 #include <memory>
+#include <optional>
 #include <ranges>
+#include <set>
+#include <string>
 #include <tuple>
 #include <utility>
 
@@ -104,24 +113,143 @@ Result<std::shared_ptr<Command>> Command::From(std::span<std::string_view> token
   }
 }
 
-Result<void> Command::Undo(model::Diagram& diagram) const {
+Result<void> Command::Undo(model::Diagram& diagram) {
   if (not Trackable()) {
     return {};
-  } else if (prior_state_) {
-    diagram = *prior_state_;
+  } else if (prior_delta_) {
+    diagram.Apply(*prior_delta_);
     return {};
-  } else {
+  } else if (not prior_state_) {
     return std::unexpected{"No prior state to restore"};
+  } else if (Replaces()) {
+    std::swap(diagram, *prior_state_);
+    swapped_ = true;
+    return {};
+  } else if (changed_) {
+    // only what the command changed differs, so consumers of the change log need not look at anything else
+    diagram.Restore(*prior_state_, *changed_);
+    return {};
+  } else {
+    diagram = *prior_state_;
+    return {};
   }
 }
 
+Result<void> Command::Redo(model::Diagram& diagram) {
+  model::ProvenanceScope const scope{provenance_};
+  if (swapped_) {
+    std::swap(diagram, *prior_state_);
+    swapped_ = false;
+    return {};
+  } else if (after_) {
+    diagram.Apply(*after_);
+    return {};
+  }
+  return Execute(diagram);
+}
+
 bool Command::Trackable() const noexcept {
   return true;
 }
 
+bool Command::Replaces() const noexcept {
+  return false;
+}
+
+bool Command::Expensive() const noexcept {
+  return false;
+}
+
+std::string_view Command::Name() const noexcept {
+  std::string_view const text{Text()};
+  return text.substr(0, text.find(" ["));
+}
+
+model::Provenance const& Command::GetProvenance() const noexcept {
+  return provenance_;
+}
+
+model::Diagram const* Command::PriorState() const noexcept {
+  return swapped_ ? nullptr : prior_state_.get();
+}
+
+model::Delta const* Command::PriorDelta() const noexcept {
+  return prior_delta_ ? &*prior_delta_ : nullptr;
+}
+
+std::optional<std::vector<std::string>> const& Command::Changed() const noexcept {
+  return changed_;
+}
+
+void Command::Adopt(model::Delta prior, std::uint32_t step) {
+  prior_state_.reset();
+  swapped_ = false;
+  changed_ = std::ranges::to<std::vector<std::string>>(std::views::keys(prior.classes));
+  after_.reset();
+  prior_delta_ = std::move(prior);
+  provenance_ = {.step = step, .command = Name()};
+}
+
 Result<void> Command::Commit(model::Diagram& diagram) {
-  prior_state_ = std::make_unique<model::Diagram>(diagram);
-  return Execute(diagram);
+  // commands and whatever reads the diagram after them (possibly on other threads) only ever read the indexes, so
+  // they are refreshed here, on the mutating side
+  diagram.RefreshIndexes();
+  if (not Trackable()) {
+    return Execute(diagram).transform([&] { diagram.RefreshIndexes(); });
+  }
+  provenance_ = {.step = static_cast<std::uint32_t>(Timeline::GetInstance().Position() + 1), .command = Name()};
+  swapped_ = false;
+  changed_.reset();
+  after_.reset();
+  prior_delta_.reset();
+  model::ProvenanceScope const scope{provenance_};
+  auto& invariants = model::InvariantEngine::GetInstance();
+  bool const strict{Settings::GetInstance().StrictTypes()};
+  bool const checked{not invariants.Empty()};
+  // catch up with any changes made outside of commands so that only this command's violations are reported
+  if (checked) {
+    std::ignore = invariants.Check(diagram);
+  }
+  auto const unresolved = strict ? diagram.GetTypeIndex().Unresolved() : std::set<std::string, std::less<>>{};
+  if (Replaces()) {
+    prior_state_ = std::make_unique<model::Diagram>(std::exchange(diagram, model::Diagram{}));
+  } else {
+    prior_state_ = std::make_unique<model::Diagram>(diagram);
+  }
+  auto const before = diagram.GetChangeLog().Now();
+  if (auto r = Execute(diagram); not r) {
+    if (Replaces()) {
+      std::swap(diagram, *prior_state_);
+    }
+    return r;
+  }
+  diagram.RefreshIndexes();
+  std::string rejected;
+  if (strict) {
+    for (std::string const& identifier : diagram.GetTypeIndex().Unresolved()) {
+      if (not unresolved.contains(identifier)) {
+        rejected.append(std::format("\n  type '{}' does not name a class or builtin", identifier));
+      }
+    }
+  }
+  if (checked) {
+    for (auto const& violation : invariants.Check(diagram)) {
+      rejected.append(std::format("\n  {}", violation));
+    }
+  }
+  if (not rejected.empty()) {
+    // a rejected command is never added to the timeline, so its prior state can be given back rather than copied
+    std::swap(diagram, *prior_state_);
+    if (checked) {
+      invariants.Revert(diagram);
+    }
+    return std::unexpected{std::format("Command rejected:{}", rejected)};
+  }
+  changed_ = diagram.GetChangeLog().Since(before);
+  if (Expensive() and changed_) {
+    after_ = diagram.Capture(*changed_);
+  }
+  return {};
 }
 
 UntrackableCommand::~UntrackableCommand() noexcept = default;
@@ -130,6 +258,18 @@ bool UntrackableCommand::Trackable() const noexcept {
   return false;
 }
 
+ReplacingCommand::~ReplacingCommand() noexcept = default;
+
+bool ReplacingCommand::Replaces() const noexcept {
+  return true;
+}
+
+ExpensiveCommand::~ExpensiveCommand() noexcept = default;
+
+bool ExpensiveCommand::Expensive() const noexcept {
+  return true;
+}
+
 } // namespace commands
 
 DOCTEST_TEST_SUITE("commands::Command") {
@@ -183,6 +323,86 @@ DOCTEST_TEST_SUITE("commands::Command") {
       CHECK(commands::Command::From(cmd));
       cmd = Split("redo x");
       CHECK_FALSE(commands::Command::From(cmd));
+
+      cmd = Split("query");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("query bogus");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("query classes:name=x");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("query classes x");
+      CHECK_FALSE(commands::Command::From(cmd));
+
+      cmd = Split("search");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("search x");
+      CHECK(commands::Command::From(cmd));
+
+      cmd = Split("clones");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("clones x");
+      CHECK_FALSE(commands::Command::From(cmd));
+
+      cmd = Split("lint");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("lint x");
+      CHECK_FALSE(commands::Command::From(cmd));
+
+      cmd = Split("invariant");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("invariant add x");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("invariant add x bogus");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("invariant add x classes:name=x");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("invariant remove x");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("list invariants");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("list unresolved");
+      CHECK(commands::Command::From(cmd));
+
+      cmd = Split("extract a 1");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("extract a x file");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("extract a 1 file");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("extract-with-types a 2 file");
+      CHECK(commands::Command::From(cmd));
+
+      cmd = Split("blame");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("blame a");
+      CHECK(commands::Command::From(cmd));
+
+      cmd = Split("at 1 list class");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("at x list class a");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("at 1 list class a");
+      CHECK(commands::Command::From(cmd));
+
+      cmd = Split("path a");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("path a b");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("path-via bogus a b");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("path-via Inheritance a b");
+      CHECK(commands::Command::From(cmd));
+      cmd = Split("paths a b");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("paths a b x");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("paths a b 3");
+      CHECK(commands::Command::From(cmd));
+
+      cmd = Split("set hash-consing");
+      CHECK_FALSE(commands::Command::From(cmd));
+      cmd = Split("set hash-consing on");
+      CHECK(commands::Command::From(cmd));
     }
     DOCTEST_SUBCASE("commands::Command.From.Class") {
       auto cmd = Split("class");
@@ -436,4 +656,40 @@ DOCTEST_TEST_SUITE("commands::Command") {
     CHECK((*add)->Commit(d));
     CHECK((*add)->Undo(d));
   }
+  DOCTEST_TEST_CASE("commands::Command::Undo.ChangeLog") {
+    auto cmd = Split("class add x");
+    auto add = commands::Command::From(cmd);
+    REQUIRE(add);
+    model::Diagram d;
+    REQUIRE(d.AddClass("y"));
+    REQUIRE((*add)->Commit(d));
+    // undo carries on with the change log rather than starting a new epoch, recording only what the command changed
+    auto const cursor = d.GetChangeLog().Now();
+    REQUIRE((*add)->Undo(d));
+    CHECK_EQ(d.GetChangeLog().Since(cursor), std::vector<std::string>{"x"});
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"y"});
+    CHECK_EQ((*add)->Changed(), std::vector<std::string>{"x"});
+  }
+  DOCTEST_TEST_CASE("commands::Command::Adopt") {
+    auto cmd = Split("class add x");
+    auto add = commands::Command::From(cmd);
+    REQUIRE(add);
+    model::Diagram before;
+    REQUIRE(before.AddClass("y"));
+    model::Diagram d{before};
+    REQUIRE(d.AddClass("x"));
+    // an adopted command holds only the classes it changed, undoes to them, and redoes by executing again
+    std::vector<std::string> const changed{"x"};
+    (*add)->Adopt(before.Capture(changed), 3);
+    CHECK_EQ((*add)->Name(), "class add");
+    CHECK_EQ((*add)->GetProvenance(), model::Provenance{3, "class add"});
+    CHECK_EQ((*add)->Changed(), changed);
+    CHECK_EQ((*add)->PriorState(), nullptr);
+    REQUIRE_NE((*add)->PriorDelta(), nullptr);
+    CHECK_FALSE((*add)->PriorDelta()->classes.at("x"));
+    REQUIRE((*add)->Undo(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"y"});
+    REQUIRE((*add)->Redo(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"x", "y"});
+  }
 }
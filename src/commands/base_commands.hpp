@@ -1,11 +1,16 @@
 #pragma once
 
 #include "model/diagram.hpp"
+#include "model/provenance.hpp"
 #include "utils/utils.hpp"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace commands {
 
@@ -15,6 +20,16 @@ namespace commands {
 ///
 class Command {
   std::unique_ptr<model::Diagram> prior_state_{nullptr};
+  /// whether prior_state_ currently holds the state after the command (a replacing command which was undone)
+  bool swapped_{false};
+  /// the classes changed by the previous commit, or nullopt if the change log lost track of them (e.g. by a load)
+  std::optional<std::vector<std::string>> changed_{std::nullopt};
+  /// the classes changed by the previous commit of an expensive command, as they were afterwards
+  std::optional<model::Delta> after_{std::nullopt};
+  /// the classes changed by the previous commit as they were before it, held instead of prior_state_ by an adopted
+  /// command
+  std::optional<model::Delta> prior_delta_{std::nullopt};
+  model::Provenance provenance_{};
 
 public:
   virtual ~Command() noexcept;
@@ -33,7 +48,18 @@ public:
   /// @param diagram
   /// @return error IFF an error occurred
   ///
-  [[nodiscard]] Result<void> Undo(model::Diagram& diagram) const;
+  [[nodiscard]] Result<void> Undo(model::Diagram& diagram);
+
+  ///
+  /// @brief Reapply an undone command to the diagram
+  ///
+  /// A replacing command swaps back the state it was undone from and an expensive command applies the delta captured
+  /// when it was committed; any other command is executed again.
+  ///
+  /// @param diagram
+  /// @return error IFF an error occurred during execution
+  ///
+  [[nodiscard]] Result<void> Redo(model::Diagram& diagram);
 
   ///
   /// @brief Apply the command to the diagram
@@ -51,9 +77,82 @@ public:
   ///
   [[nodiscard]] virtual bool Trackable() const noexcept;
 
+  ///
+  /// @brief Check whether a command replaces the whole diagram rather than modifying it
+  ///
+  /// The prior state of a replacing command is moved out of the diagram instead of copied, and undoing or redoing it
+  /// swaps the two states, so neither costs time proportional to the size of the diagram being replaced.
+  ///
+  /// @return true if Execute() discards the diagram it is given
+  ///
+  [[nodiscard]] virtual bool Replaces() const noexcept;
+
+  ///
+  /// @brief Check whether a command is costly enough to execute that it should not be executed again by redo
+  ///
+  /// An expensive command captures the classes it changed when it is committed, and redo applies them directly.
+  ///
+  /// @return true if redo should apply the captured change instead of executing the command
+  ///
+  [[nodiscard]] virtual bool Expensive() const noexcept;
+
+  ///
+  /// @brief Get the text describing the command's syntax, e.g. "class add [name]"
+  ///
+  /// The text must have static storage, since every entity the command modifies records its name as its provenance.
+  ///
+  [[nodiscard]] virtual std::string_view Text() const noexcept = 0;
+
+  ///
+  /// @brief Get the name of the command: the words of its syntax before the first argument, e.g. "class add"
+  ///
+  [[nodiscard]] std::string_view Name() const noexcept;
+
+  ///
+  /// @brief Get the provenance recorded for every entity modified by the previous commit
+  ///
+  [[nodiscard]] model::Provenance const& GetProvenance() const noexcept;
+
+  ///
+  /// @brief Get the diagram as it was immediately before the previous commit
+  ///
+  /// @return the held state, or nullptr if the command was never committed, was adopted (see PriorDelta), or the
+  ///         state is not currently held
+  ///
+  [[nodiscard]] model::Diagram const* PriorState() const noexcept;
+
+  ///
+  /// @brief Get the classes changed by the previous commit as they were before it, which an adopted command holds
+  ///        instead of the whole prior state
+  ///
+  /// @return the held delta, or nullptr if the command was not adopted
+  ///
+  [[nodiscard]] model::Delta const* PriorDelta() const noexcept;
+
+  ///
+  /// @brief Get the classes changed by the previous commit
+  ///
+  /// @return the names of the classes, or nullopt if the command was never committed or the change log lost track of
+  ///         them (e.g. because the command replaced the diagram)
+  ///
+  [[nodiscard]] std::optional<std::vector<std::string>> const& Changed() const noexcept;
+
+  ///
+  /// @brief Take the command as committed without executing or checking it again, e.g. when resuming a session
+  ///
+  /// Only what the command changed is held to undo it, so adopting a long history does not copy the diagram once per
+  /// command, and the classes held share the storage of their fields and methods with the diagram they came from.
+  ///
+  /// @param prior the classes the command changed, as they were immediately before it
+  /// @param step the position of the command in the timeline (1 for the first command)
+  ///
+  void Adopt(model::Delta prior, std::uint32_t step);
+
   ///
   /// @brief Commit the passed diagram as the held state of the command to be reverted during undo
   ///
+  /// A trackable command which introduces invariant violations (or unresolved types, in strict mode) is rolled back.
+  ///
   /// @param diagram
   /// @return Result<void>
   ///
@@ -71,4 +170,26 @@ public:
   [[nodiscard]] bool Trackable() const noexcept override;
 };
 
+///
+/// @brief A command which will always have Replaces() return true
+///
+///
+class ReplacingCommand : public Command {
+public:
+  ~ReplacingCommand() noexcept override;
+
+  [[nodiscard]] bool Replaces() const noexcept override;
+};
+
+///
+/// @brief A command which will always have Expensive() return true
+///
+///
+class ExpensiveCommand : public Command {
+public:
+  ~ExpensiveCommand() noexcept override;
+
+  [[nodiscard]] bool Expensive() const noexcept override;
+};
+
 } // namespace commands
@@ -1,20 +1,34 @@
 #include "commands.hpp"
 
+#include "model/clones.hpp"
 #include "model/diagram.hpp"
+#include "model/invariants.hpp"
+#include "model/lint.hpp"
 #include "model/method.hpp"
 #include "model/method_signature.hpp"
+#include "model/name_index.hpp"
 #include "model/parameter.hpp"
+#include "model/paths.hpp"
+#include "model/provenance.hpp"
+#include "model/query.hpp"
 #include "model/relationship_type.hpp"
 #include "timeline.hpp"
 #include "utils/io_context.hpp"
+#include "utils/json.hpp"
+#include "utils/settings.hpp"
 #include "utils/utils.hpp"
 
 #include <cstdio>
 
 #include <doctest/doctest.h>
 
+#include <filesystem>
 #include <functional>
 #include <print>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
 
 namespace commands {
 
@@ -26,27 +40,309 @@ Result<void> SaveCommand::Execute(model::Diagram& diagram) const {
   return std::apply(std::bind_front(&model::Diagram::Save, std::ref(diagram)), args);
 }
 
+static Result<void> Extract(model::Diagram const& diagram,
+                            std::string_view class_name,
+                            int hops,
+                            std::string_view file_name,
+                            bool with_types) {
+  if (hops < 0) {
+    return std::unexpected{"the number of hops cannot be negative"};
+  }
+  return diagram.Extract(class_name, static_cast<std::size_t>(hops), with_types)
+      .and_then([&](model::Diagram sub) { return sub.Save(file_name); });
+}
+
+Result<void> ExtractCommand::Execute(model::Diagram& diagram) const {
+  auto const& [cls, hops, file] = args;
+  return Extract(diagram, cls, hops, file, false);
+}
+
+Result<void> ExtractWithTypesCommand::Execute(model::Diagram& diagram) const {
+  auto const& [cls, hops, file] = args;
+  return Extract(diagram, cls, hops, file, true);
+}
+
+static bool JsonOutput() noexcept {
+  return Settings::GetInstance().Output() == OutputFormat::Json;
+}
+
+///
+/// @brief Stream the classes and/or relationships of a diagram as a JSON object with an array of each
+///
+/// @param diagram
+/// @param classes whether to write the classes
+/// @param relationships whether to write the relationships
+///
+static void PrintJson(model::Diagram const& diagram, bool classes, bool relationships) {
+  JsonWriter out{stdout};
+  out.BeginObject();
+  if (classes) {
+    out.Key("classes");
+    out.BeginArray();
+    for (model::Class const& c : diagram.GetClasses()) {
+      out.Value(c);
+    }
+    out.EndArray();
+  }
+  if (relationships) {
+    out.Key("relationships");
+    out.BeginArray();
+    for (model::Relationship const& r : diagram.GetRelationships()) {
+      out.Value(r);
+    }
+    out.EndArray();
+  }
+  out.EndObject();
+}
+
+static void PrintClass(model::Class const& c) {
+  if (JsonOutput()) {
+    JsonWriter{stdout}.Value(c);
+  } else {
+    std::print("{}", c);
+  }
+}
+
 Result<void> ListAllCommand::Execute(model::Diagram& diagram) const {
-  std::println(stdout, "{:cr}", diagram);
+  if (JsonOutput()) {
+    PrintJson(diagram, true, true);
+  } else {
+    std::println(stdout, "{:cr}", diagram);
+  }
   return {};
 }
 
 Result<void> ListClassesCommand::Execute(model::Diagram& diagram) const {
-  std::println(stdout, "{:c}", diagram);
+  if (JsonOutput()) {
+    PrintJson(diagram, true, false);
+  } else {
+    std::println(stdout, "{:c}", diagram);
+  }
   return {};
 }
 
 Result<void> ListRelationshipsCommand::Execute(model::Diagram& diagram) const {
-  std::println(stdout, "{:r}", diagram);
+  if (JsonOutput()) {
+    PrintJson(diagram, false, true);
+  } else {
+    std::println(stdout, "{:r}", diagram);
+  }
   return {};
 }
 
 Result<void> ListClassCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
-      [&](std::string_view cls) { return diagram.GetClass(cls).transform([](auto c) { std::print("{}", *c); }); },
+      [&](std::string_view cls) { return diagram.GetClass(cls).transform([](auto c) { PrintClass(*c); }); },
       args);
 }
 
+Result<void> AtListClassCommand::Execute(model::Diagram& diagram) const {
+  auto const& [index, cls] = args;
+  if (index < 0) {
+    return std::unexpected{"the history index cannot be negative"};
+  }
+  return Timeline::GetInstance()
+      .StateAt(static_cast<std::size_t>(index), diagram)
+      .and_then([&](model::Diagram const* past) { return past->GetClass(cls); })
+      .transform([](auto c) { PrintClass(*c); });
+}
+
+Result<void> ListInvariantsCommand::Execute(model::Diagram&) const {
+  if (auto invariants = model::InvariantEngine::GetInstance().Invariants(); invariants.empty()) {
+    std::println(stdout, "No invariants defined");
+  } else {
+    for (auto const& [name, text] : invariants) {
+      std::println(stdout, "{}: {}", name, text);
+    }
+  }
+  return {};
+}
+
+Result<void> ListUnresolvedCommand::Execute(model::Diagram& diagram) const {
+  model::TypeIndex const& index = std::as_const(diagram).GetTypeIndex();
+  if (index.Unresolved().empty()) {
+    std::println(stdout, "No unresolved types");
+  }
+  for (std::string const& identifier : index.Unresolved()) {
+    auto const users =
+        std::ranges::to<std::string>(std::views::join_with(index.UsersOf(identifier), std::string_view{", "}));
+    std::println(stdout, "{} (used by {})", identifier, users);
+  }
+  return {};
+}
+
+static nlohmann::json ToJson(model::QueryMatch const& match) {
+  struct {
+    nlohmann::json operator()(model::Class const* c) const {
+      return {{"class", c->Name()}};
+    }
+    nlohmann::json operator()(model::FieldMatch const& m) const {
+      return {{"class", m.owner->Name()}, {"field", *m.field}};
+    }
+    nlohmann::json operator()(model::MethodMatch const& m) const {
+      return {{"class", m.owner->Name()}, {"method", *m.method}};
+    }
+    nlohmann::json operator()(model::Relationship const* r) const {
+      return {{"relationship", *r}};
+    }
+  } visitor;
+  return std::visit(visitor, match);
+}
+
+static nlohmann::json ToJson(model::NameMatch const& match) {
+  nlohmann::json json{{"class", match.owner->Name()}};
+  if (match.field != nullptr) {
+    json["field"] = *match.field;
+  }
+  if (match.method != nullptr) {
+    json["method"] = *match.method;
+  }
+  if (match.parameter != nullptr) {
+    json["parameter"] = *match.parameter;
+  }
+  return json;
+}
+
+///
+/// @brief Print every match passed to a sink, streaming them as a JSON array if the session asks for JSON output
+///
+/// @tparam Match the type of match passed to the sink
+/// @param produce invoked with the sink, which it calls once per match
+///
+template <typename Match> static void PrintMatches(auto const& produce) {
+  if (JsonOutput()) {
+    JsonWriter out{stdout};
+    out.BeginArray();
+    produce(std::function<void(Match const&)>{[&](Match const& match) { out.Value(ToJson(match)); }});
+    out.EndArray();
+  } else {
+    produce(std::function<void(Match const&)>{[](Match const& match) { std::println(stdout, "{}", match); }});
+  }
+}
+
+Result<void> QueryCommand::Execute(model::Diagram& diagram) const {
+  PrintMatches<model::QueryMatch>([&](auto const& sink) { std::get<0>(args).Execute(diagram, sink); });
+  return {};
+}
+
+Result<void> SearchCommand::Execute(model::Diagram& diagram) const {
+  PrintMatches<model::NameMatch>([&](auto const& sink) { model::Search(diagram, std::get<0>(args), sink); });
+  return {};
+}
+
+Result<void> ClonesCommand::Execute(model::Diagram& diagram) const {
+  if (auto report = model::FindClones(diagram.GetClasses()); report.identical.empty() and report.similar.empty()) {
+    std::println(stdout, "No clones found");
+  } else {
+    std::print(stdout, "{}", report);
+  }
+  return {};
+}
+
+Result<void> LintCommand::Execute(model::Diagram& diagram) const {
+  if (auto diagnostics = model::Linter::GetInstance().Run(diagram, diagram.GetTypeIndex()); diagnostics.empty()) {
+    std::println(stdout, "No problems found");
+  } else {
+    for (model::Diagnostic const& d : diagnostics) {
+      std::println(stdout, "{}", d);
+    }
+  }
+  return {};
+}
+
+Result<void> AddInvariantCommand::Execute(model::Diagram& diagram) const {
+  auto const& [name, query] = args;
+  auto& invariants = model::InvariantEngine::GetInstance();
+  return invariants.Add(name, query).transform([&] {
+    std::ignore = invariants.Check(diagram);
+    for (model::Violation const& v : invariants.Violations()) {
+      if (v.invariant == name) {
+        std::println(stdout, "{}", v);
+      }
+    }
+  });
+}
+
+Result<void> RemoveInvariantCommand::Execute(model::Diagram&) const {
+  return model::InvariantEngine::GetInstance().Remove(std::get<0>(args));
+}
+
+static std::string Describe(model::Provenance const& provenance) {
+  if (not provenance.Known()) {
+    return "unknown";
+  }
+  return std::format("#{} {}", provenance.step, provenance.command);
+}
+
+Result<void> BlameCommand::Execute(model::Diagram& diagram) const {
+  auto const& self = std::as_const(diagram);
+  return self.GetClass(std::get<0>(args)).transform([&](auto c) {
+    std::println(stdout, "class {}: {}", c->Name(), Describe(c->LastModified()));
+    for (model::Field const& f : c->Fields()) {
+      std::println(stdout, "  field {: }: {}", f, Describe(f.LastModified()));
+    }
+    for (model::Method const& m : c->Methods()) {
+      std::println(stdout, "  method {: }: {}", m, Describe(m.LastModified()));
+    }
+    auto const print_relationship = [&](std::string_view src, std::string_view dst) {
+      if (auto r = self.GetReadOnlyRelationship(src, dst); r) {
+        std::println(stdout, "  relationship {}: {}", **r, Describe((*r)->LastModified()));
+      }
+    };
+    for (std::string const& dst : self.GetAdjacency().Successors(c->Name())) {
+      print_relationship(c->Name(), dst);
+    }
+    for (std::string const& src : self.GetAdjacency().Predecessors(c->Name())) {
+      if (src != c->Name()) {
+        print_relationship(src, c->Name());
+      }
+    }
+  });
+}
+
+static Result<void> PrintPaths(Result<std::vector<model::Path>> paths) {
+  return paths.transform([](std::vector<model::Path> const& found) {
+    if (found.empty()) {
+      std::println(stdout, "No path found");
+    }
+    for (model::Path const& path : found) {
+      std::println(stdout, "{}", path);
+    }
+  });
+}
+
+Result<void> PathCommand::Execute(model::Diagram& diagram) const {
+  auto const& [src, dst] = args;
+  return PrintPaths(model::ShortestPaths(diagram, src, dst));
+}
+
+Result<void> PathViaCommand::Execute(model::Diagram& diagram) const {
+  auto const& [type, src, dst] = args;
+  return PrintPaths(model::ShortestPaths(diagram, src, dst, 1, type));
+}
+
+Result<void> PathsCommand::Execute(model::Diagram& diagram) const {
+  auto const& [src, dst, k] = args;
+  if (k < 1) {
+    return std::unexpected{"the number of paths must be positive"};
+  }
+  return PrintPaths(model::ShortestPaths(diagram, src, dst, static_cast<std::size_t>(k)));
+}
+
+Result<void> SetCommand::Execute(model::Diagram& diagram) const {
+  auto const& [setting, value] = args;
+  return Settings::GetInstance().Set(setting, value).transform([&] {
+    if (Settings::GetInstance().HashConsing()) {
+      diagram.Share();
+    }
+  });
+}
+
+Result<void> CompactCommand::Execute(model::Diagram& diagram) const {
+  diagram.Compact();
+  return {};
+}
+
 Result<void> ExitCommand::Execute(model::Diagram&) const {
   return {};
 }
@@ -63,7 +359,7 @@ Result<void> UndoCommand::Execute(model::Diagram& diagram) const {
 }
 
 Result<void> RedoCommand::Execute(model::Diagram& diagram) const {
-  return Timeline::GetInstance().Redo().and_then([&](auto&& cmd) { return cmd->Execute(diagram); });
+  return Timeline::GetInstance().Redo().and_then([&](auto&& cmd) { return cmd->Redo(diagram); });
 }
 
 Result<void> AddClassCommand::Execute(model::Diagram& diagram) const {
@@ -79,16 +375,28 @@ Result<void> RenameClassCommand::Execute(model::Diagram& diagram) const {
 }
 
 Result<void> MoveClassCommand::Execute(model::Diagram& diagram) const {
-  return std::apply([&](std::string_view cls,
-                        int x,
-                        int y) { return diagram.GetClass(cls).transform([&](auto c) { c->Move(x, y); }); },
-                    args);
+  return std::apply(
+      [&](std::string_view cls, int x, int y) {
+        return diagram.EditClass(cls, [&](model::Class& c) {
+          c.Move(x, y);
+          return Result<void>{};
+        });
+      },
+      args);
+}
+
+Result<void> MoveAllClassesCommand::Execute(model::Diagram& diagram) const {
+  return std::apply(std::bind_front(&model::Diagram::LoadPositions, std::ref(diagram)), args);
+}
+
+Result<void> ExportPositionsCommand::Execute(model::Diagram& diagram) const {
+  return std::apply(std::bind_front(&model::Diagram::SavePositions, std::ref(diagram)), args);
 }
 
 Result<void> AddFieldCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, std::string_view name, std::string_view type) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->AddField(name, type); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.AddField(name, type); });
       },
       args);
 }
@@ -96,7 +404,7 @@ Result<void> AddFieldCommand::Execute(model::Diagram& diagram) const {
 Result<void> RemoveFieldCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, std::string_view field) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->DeleteField(field); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.DeleteField(field); });
       },
       args);
 }
@@ -104,7 +412,7 @@ Result<void> RemoveFieldCommand::Execute(model::Diagram& diagram) const {
 Result<void> RenameFieldCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, std::string_view field, std::string_view name) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->RenameField(field, name); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.RenameField(field, name); });
       },
       args);
 }
@@ -112,8 +420,8 @@ Result<void> RenameFieldCommand::Execute(model::Diagram& diagram) const {
 Result<void> RetypeFieldCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, std::string_view field, std::string_view type) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->GetField(field); }).and_then([&](auto f) {
-          return f->ChangeType(type);
+        return diagram.EditClass(cls, [&](model::Class& c) {
+          return c.GetField(field).and_then([&](auto f) { return f->ChangeType(type); });
         });
       },
       args);
@@ -122,8 +430,9 @@ Result<void> RetypeFieldCommand::Execute(model::Diagram& diagram) const {
 Result<void> AddMethodCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::Method const& definition) {
-        return diagram.GetClass(cls).and_then(
-            [&](auto c) { return c->AddMethod(definition.Name(), definition.ReturnType(), definition.Parameters()); });
+        return diagram.EditClass(cls, [&](model::Class& c) {
+          return c.AddMethod(definition.Name(), definition.ReturnType(), definition.Parameters());
+        });
       },
       args);
 }
@@ -131,7 +440,7 @@ Result<void> AddMethodCommand::Execute(model::Diagram& diagram) const {
 Result<void> RemoveMethodCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->DeleteMethod(sig); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.DeleteMethod(sig); });
       },
       args);
 }
@@ -139,7 +448,7 @@ Result<void> RemoveMethodCommand::Execute(model::Diagram& diagram) const {
 Result<void> RenameMethodCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig, std::string_view name) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->RenameMethod(sig, name); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.RenameMethod(sig, name); });
       },
       args);
 }
@@ -147,9 +456,9 @@ Result<void> RenameMethodCommand::Execute(model::Diagram& diagram) const {
 Result<void> ChangeReturnTypeCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig, std::string_view type) {
-        return diagram.GetClass(cls)
-            .and_then([&](auto c) { return c->GetMethodFromSignature(sig); })
-            .and_then([&](auto m) { return m->ChangeReturnType(type); });
+        return diagram.EditClass(cls, [&](model::Class& c) {
+          return c.GetMethodFromSignature(sig).and_then([&](auto m) { return m->ChangeReturnType(type); });
+        });
       },
       args);
 }
@@ -157,7 +466,7 @@ Result<void> ChangeReturnTypeCommand::Execute(model::Diagram& diagram) const {
 Result<void> AddParameterCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig, std::string_view param, std::string_view type) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->AddParameter(sig, param, type); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.AddParameter(sig, param, type); });
       },
       args);
 }
@@ -165,7 +474,7 @@ Result<void> AddParameterCommand::Execute(model::Diagram& diagram) const {
 Result<void> RemoveParameterCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig, std::string_view param) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->DeleteParameter(sig, param); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.DeleteParameter(sig, param); });
       },
       args);
 }
@@ -173,9 +482,9 @@ Result<void> RemoveParameterCommand::Execute(model::Diagram& diagram) const {
 Result<void> RenameParameterCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig, std::string_view param, std::string_view name) {
-        return diagram.GetClass(cls)
-            .and_then([&](auto c) { return c->GetMethodFromSignature(sig); })
-            .and_then([&](auto m) { return m->RenameParameter(param, name); });
+        return diagram.EditClass(cls, [&](model::Class& c) {
+          return c.GetMethodFromSignature(sig).and_then([&](auto m) { return m->RenameParameter(param, name); });
+        });
       },
       args);
 }
@@ -183,7 +492,7 @@ Result<void> RenameParameterCommand::Execute(model::Diagram& diagram) const {
 Result<void> RetypeParameterCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig, std::string_view param, std::string_view type) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->ChangeParameterType(sig, param, type); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.ChangeParameterType(sig, param, type); });
       },
       args);
 }
@@ -191,7 +500,7 @@ Result<void> RetypeParameterCommand::Execute(model::Diagram& diagram) const {
 Result<void> ClearParametersCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->DeleteParameters(sig); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.DeleteParameters(sig); });
       },
       args);
 }
@@ -199,7 +508,7 @@ Result<void> ClearParametersCommand::Execute(model::Diagram& diagram) const {
 Result<void> SetParametersCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view cls, model::MethodSignature const& sig, std::vector<model::Parameter> const& params) {
-        return diagram.GetClass(cls).and_then([&](auto c) { return c->ChangeParameters(sig, params); });
+        return diagram.EditClass(cls, [&](model::Class& c) { return c.ChangeParameters(sig, params); });
       },
       args);
 }
@@ -223,7 +532,10 @@ Result<void> ChangeDestinationCommand::Execute(model::Diagram& diagram) const {
 Result<void> ChangeTypeCommand::Execute(model::Diagram& diagram) const {
   return std::apply(
       [&](std::string_view src, std::string_view dst, model::RelationshipType type) {
-        return diagram.GetRelationship(src, dst).transform([&](auto r) { return r->ChangeType(type); });
+        return diagram.EditRelationship(src, dst, [&](model::Relationship& r) {
+          r.ChangeType(type);
+          return Result<void>{};
+        });
       },
       args);
 }
@@ -237,6 +549,32 @@ DOCTEST_TEST_SUITE("commands") {
     CHECK_FALSE(cmd->Commit(d));
     CHECK(cmd->Undo(d));
   }
+  DOCTEST_TEST_CASE("commands::LoadCommand.Swap") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("loaded"));
+    auto const file = (std::filesystem::temp_directory_path() / "load-swap.json").string();
+    REQUIRE(d.Save(file));
+    d = model::Diagram{};
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    auto cmd = std::make_unique<commands::LoadCommand>(std::tuple{file});
+    REQUIRE(cmd->Commit(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"loaded"});
+    CHECK_EQ(cmd->PriorState()->GetClassNames(), std::vector<std::string>{"a", "b"});
+    REQUIRE(cmd->Undo(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"a", "b"});
+    // while undone, the held state is the loaded diagram
+    CHECK_EQ(cmd->PriorState(), nullptr);
+    REQUIRE(cmd->Redo(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"loaded"});
+    REQUIRE(cmd->Undo(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"a", "b"});
+
+    // a failed load leaves the diagram untouched
+    auto bad = std::make_unique<commands::LoadCommand>(std::tuple{"/nonexistent.json"});
+    CHECK_FALSE(bad->Commit(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"a", "b"});
+  }
   DOCTEST_TEST_CASE("commands::SaveCommand") {
     [[maybe_unused]] model::Diagram d;
     auto cmd = std::make_unique<commands::SaveCommand>(std::tuple{"/invalid.txt"});
@@ -300,6 +638,313 @@ DOCTEST_TEST_SUITE("commands") {
     CHECK(res);
     CHECK(cmd->Undo(d));
   }
+  DOCTEST_TEST_CASE("commands::AtListClassCommand") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    auto const position = static_cast<int>(commands::Timeline::GetInstance().Position());
+    auto cmd = std::make_unique<commands::AtListClassCommand>(std::tuple{position, "a"});
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+    CHECK_FALSE(std::make_unique<commands::AtListClassCommand>(std::tuple{position, "z"})->Commit(d));
+    CHECK_FALSE(std::make_unique<commands::AtListClassCommand>(std::tuple{-1, "a"})->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::ListUnresolvedCommand") {
+    [[maybe_unused]] model::Diagram d;
+    auto cmd = std::make_unique<commands::ListUnresolvedCommand>(std::tuple<>{});
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "Missing"); }));
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+  }
+  DOCTEST_TEST_CASE("commands::Command.Commit.StrictTypes") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "Missing"); }));
+    ScopedSettings const scope;
+    REQUIRE(Settings::GetInstance().Set("strict-types", "on"));
+    // existing unresolved types are tolerated, but a command may not introduce new ones
+    CHECK_FALSE(std::make_unique<commands::AddFieldCommand>(std::tuple{"a", "y", "Other"})->Commit(d));
+    CHECK(std::make_unique<commands::AddFieldCommand>(std::tuple{"a", "y", "vector<int>"})->Commit(d));
+    CHECK(std::make_unique<commands::AddFieldCommand>(std::tuple{"a", "z", "Missing"})->Commit(d));
+    CHECK(std::make_unique<commands::AddClassCommand>(std::tuple{"Other"})->Commit(d));
+    CHECK(std::make_unique<commands::AddFieldCommand>(std::tuple{"a", "w", "Other"})->Commit(d));
+    CHECK_FALSE(std::make_unique<commands::RemoveClassCommand>(std::tuple{"Other"})->Commit(d));
+    CHECK_FALSE(std::make_unique<commands::RenameClassCommand>(std::tuple{"Other", "Renamed"})->Commit(d));
+    CHECK(std::as_const(d).GetClass("Other"));
+    CHECK_EQ(d.GetTypeIndex().Unresolved(), std::set<std::string, std::less<>>{"Missing"});
+    REQUIRE(Settings::GetInstance().Set("strict-types", "off"));
+    CHECK(std::make_unique<commands::RemoveClassCommand>(std::tuple{"Other"})->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::QueryCommand") {
+    [[maybe_unused]] model::Diagram d;
+    auto query = model::Query::FromString("classes:name=a");
+    REQUIRE(query);
+    auto cmd = std::make_unique<commands::QueryCommand>(std::tuple{*query});
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+  }
+  DOCTEST_TEST_CASE("commands::QueryCommand.Json") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Inheritance));
+    auto query = model::Query::FromString("classes:name=a");
+    REQUIRE(query);
+    ScopedSettings const scope;
+    REQUIRE(Settings::GetInstance().Set("output", "json"));
+    [[maybe_unused]] std::string listed;
+    [[maybe_unused]] std::string matched;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      CHECK(std::make_unique<commands::ListAllCommand>(std::tuple<>{})->Commit(d));
+      CHECK(std::make_unique<commands::QueryCommand>(std::tuple{*query})->Commit(d));
+      std::ignore = fflush(stdout);
+      auto const out = ctx.StdOut();
+      auto const newline = out.find('\n');
+      listed = out.substr(0, newline);
+      matched = out.substr(newline + 1);
+    });
+    REQUIRE(Settings::GetInstance().Set("output", "text"));
+    ENABLE_IF_TEST({
+      nlohmann::json const expected = d;
+      CHECK_EQ(nlohmann::json::parse(listed), expected);
+      CHECK_EQ(matched, "[{\"class\":\"a\"}]\n");
+    });
+  }
+  DOCTEST_TEST_CASE("commands::SearchCommand") {
+    [[maybe_unused]] model::Diagram d;
+    auto cmd = std::make_unique<commands::SearchCommand>(std::tuple{"lass"});
+    REQUIRE(d.AddClass("AClass"));
+    REQUIRE(d.AddClass("b"));
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+  }
+  DOCTEST_TEST_CASE("commands::ClonesCommand") {
+    [[maybe_unused]] model::Diagram d;
+    auto cmd = std::make_unique<commands::ClonesCommand>(std::tuple<>{});
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "int"); }));
+    REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("x", "int"); }));
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+  }
+  DOCTEST_TEST_CASE("commands::LintCommand") {
+    [[maybe_unused]] model::Diagram d;
+    auto cmd = std::make_unique<commands::LintCommand>(std::tuple<>{});
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("B"));
+    REQUIRE(d.EditClass("B", [](model::Class& c) { return c.AddField("x", "Missing"); }));
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+  }
+  DOCTEST_TEST_CASE("commands::AddInvariantCommand") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("A"));
+    REQUIRE(d.AddClass("B"));
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.AddField("x", "int"); }));
+    auto query = model::Query::FromString("fields:type=int");
+    REQUIRE(query);
+    auto cmd = std::make_unique<commands::AddInvariantCommand>(std::tuple{"no-int", *query});
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK_FALSE(std::make_unique<commands::AddInvariantCommand>(std::tuple{"no-int", *query})->Commit(d));
+
+    // existing violations are tolerated, but a command may not introduce new ones
+    auto add = std::make_unique<commands::AddFieldCommand>(std::tuple{"B", "y", "int"});
+    CHECK_FALSE(add->Commit(d));
+    CHECK((*d.GetClass("B"))->Fields().empty());
+    CHECK(std::make_unique<commands::AddFieldCommand>(std::tuple{"B", "z", "bool"})->Commit(d));
+    CHECK(std::make_unique<commands::RemoveFieldCommand>(std::tuple{"A", "x"})->Commit(d));
+    CHECK(model::InvariantEngine::GetInstance().Violations().empty());
+
+    auto remove = std::make_unique<commands::RemoveInvariantCommand>(std::tuple{"no-int"});
+    CHECK(remove->Commit(d));
+    CHECK_FALSE(remove->Commit(d));
+    CHECK(add->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::ListInvariantsCommand") {
+    [[maybe_unused]] model::Diagram d;
+    auto cmd = std::make_unique<commands::ListInvariantsCommand>(std::tuple<>{});
+    REQUIRE(model::InvariantEngine::GetInstance().Add("named", *model::Query::FromString("classes:name=x")));
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+    REQUIRE(model::InvariantEngine::GetInstance().Remove("named"));
+  }
+  DOCTEST_TEST_CASE("commands::BlameCommand") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(std::make_unique<commands::AddClassCommand>(std::tuple{"a"})->Commit(d));
+    REQUIRE(std::make_unique<commands::AddClassCommand>(std::tuple{"b"})->Commit(d));
+    auto add_field = std::make_unique<commands::AddFieldCommand>(std::tuple{"a", "x", "int"});
+    REQUIRE(add_field->Commit(d));
+    REQUIRE(std::make_unique<commands::AddRelationshipCommand>(
+                std::tuple{"a", "b", model::RelationshipType::Aggregation})
+                ->Commit(d));
+    auto const& field = std::as_const(d).GetClass("a").value()->Fields().front();
+    CHECK_EQ(field.LastModified(), add_field->GetProvenance());
+    CHECK_EQ(field.LastModified().command, "field add");
+
+    auto cmd = std::make_unique<commands::BlameCommand>(std::tuple{"a"});
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK_FALSE(std::make_unique<commands::BlameCommand>(std::tuple{"z"})->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::PathCommand") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    auto cmd = std::make_unique<commands::PathCommand>(std::tuple{"a", "b"});
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+    CHECK_FALSE(std::make_unique<commands::PathCommand>(std::tuple{"a", "z"})->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::PathViaCommand") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    auto cmd =
+        std::make_unique<commands::PathViaCommand>(std::tuple{model::RelationshipType::Inheritance, "a", "b"});
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+  }
+  DOCTEST_TEST_CASE("commands::PathsCommand") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    auto cmd = std::make_unique<commands::PathsCommand>(std::tuple{"a", "b", 3});
+    [[maybe_unused]] Result<void> res;
+    ENABLE_IF_TEST({
+      IOContext ctx;
+      res = cmd->Commit(d);
+      std::ignore = fflush(stdout);
+    });
+    CHECK(res);
+    CHECK(cmd->Undo(d));
+    CHECK_FALSE(std::make_unique<commands::PathsCommand>(std::tuple{"a", "b", 0})->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::ExtractCommand") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddClass("c"));
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("x", "c"); }));
+    auto const file = (std::filesystem::temp_directory_path() / "extract.json").string();
+
+    CHECK(std::make_unique<commands::ExtractCommand>(std::tuple{"a", 1, file})->Commit(d));
+    model::Diagram sub;
+    REQUIRE(sub.Load(file));
+    CHECK_EQ(sub.GetClassNames(), std::vector<std::string>{"a", "b"});
+    CHECK_EQ(sub.GetRelationships(), d.GetRelationships());
+
+    CHECK(std::make_unique<commands::ExtractWithTypesCommand>(std::tuple{"a", 1, file})->Commit(d));
+    REQUIRE(sub.Load(file));
+    CHECK_EQ(sub.GetClassNames(), std::vector<std::string>{"a", "b", "c"});
+
+    CHECK_FALSE(std::make_unique<commands::ExtractCommand>(std::tuple{"z", 1, file})->Commit(d));
+    CHECK_FALSE(std::make_unique<commands::ExtractCommand>(std::tuple{"a", -1, file})->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::SetCommand") {
+    ScopedSettings const scope;
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "int"); }));
+    REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("x", "int"); }));
+    auto field_of = [&](std::string_view name) -> model::Field const& {
+      return std::as_const(d).GetClass(name).value()->Fields().front();
+    };
+    CHECK_FALSE(field_of("a").SharesWith(field_of("b")));
+
+    auto cmd = std::make_unique<commands::SetCommand>(std::tuple{"hash-consing", "on"});
+    CHECK(cmd->Commit(d));
+    CHECK(field_of("a").SharesWith(field_of("b")));
+    CHECK(cmd->Undo(d));
+    CHECK(std::make_unique<commands::SetCommand>(std::tuple{"hash-consing", "off"})->Commit(d));
+    CHECK_FALSE(std::make_unique<commands::SetCommand>(std::tuple{"hash-consing", "maybe"})->Commit(d));
+    CHECK_FALSE(std::make_unique<commands::SetCommand>(std::tuple{"bogus", "on"})->Commit(d));
+  }
+  DOCTEST_TEST_CASE("commands::CompactCommand") {
+    [[maybe_unused]] model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    REQUIRE(d.DeleteClass("b"));
+    auto cmd = std::make_unique<commands::CompactCommand>(std::tuple<>{});
+    CHECK(cmd->Commit(d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"a"});
+    CHECK(d.GetRelationships().empty());
+    CHECK_EQ(d.GetClasses().size(), 1);
+  }
   DOCTEST_TEST_CASE("commands::ExitCommand") {
     [[maybe_unused]] model::Diagram d;
     auto cmd = std::make_unique<commands::ExitCommand>(std::tuple<>{});
@@ -358,11 +1003,21 @@ DOCTEST_TEST_SUITE("commands") {
     [[maybe_unused]] model::Diagram d;
     auto cmd = std::make_unique<commands::RenameClassCommand>(std::tuple{"a", "b"});
     REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("c"));
+    REQUIRE(d.AddRelationship("c", "a", model::RelationshipType::Aggregation));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     REQUIRE(d.GetClass("b"));
+    auto const renamed = d;
     CHECK(cmd->Undo(d));
     REQUIRE(d.GetClass("a"));
+    // redo applies the captured change rather than renaming again
+    CHECK(cmd->Redo(d));
+    CHECK_EQ(d.GetClasses(), renamed.GetClasses());
+    CHECK_EQ(d.GetRelationships(), renamed.GetRelationships());
+    CHECK(d.GetReadOnlyRelationship("c", "b"));
+    CHECK_FALSE(d.GetClass("a"));
+    CHECK(d.Valid(d.GetHandle("b").value()));
   }
   DOCTEST_TEST_CASE("commands::MoveClassCommand") {
     [[maybe_unused]] model::Diagram d;
@@ -374,6 +1029,35 @@ DOCTEST_TEST_SUITE("commands") {
     CHECK(cmd->Undo(d));
     CHECK_NE(d.GetClasses().front().Position(), model::Point{420, 69});
   }
+  DOCTEST_TEST_CASE("commands::MoveAllClassesCommand") {
+    [[maybe_unused]] model::Diagram d;
+    auto const file = (std::filesystem::temp_directory_path() / "move-all.txt").string();
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      c.Move(1, 2);
+      return Result<void>{};
+    }));
+    auto exported = std::make_unique<commands::ExportPositionsCommand>(std::tuple{file});
+    REQUIRE(exported->Commit(d));
+    auto const exported_state = d;
+
+    for (auto const& [name, x] : {std::pair{"a", 0}, std::pair{"b", 5}}) {
+      REQUIRE(d.EditClass(name, [&](model::Class& c) {
+        c.Move(x, x);
+        return Result<void>{};
+      }));
+    }
+    auto const before = d;
+    auto cmd = std::make_unique<commands::MoveAllClassesCommand>(std::tuple{file});
+    CHECK(cmd->Commit(d));
+    CHECK_EQ(d.GetClasses(), exported_state.GetClasses());
+    // every class moved by the file is restored by a single undo
+    CHECK(cmd->Undo(d));
+    CHECK_EQ(d.GetClasses(), before.GetClasses());
+    CHECK(cmd->Redo(d));
+    CHECK_EQ(d.GetClasses(), exported_state.GetClasses());
+  }
 
   DOCTEST_TEST_CASE("commands::AddFieldCommand") {
     [[maybe_unused]] model::Diagram d;
@@ -390,7 +1074,7 @@ DOCTEST_TEST_SUITE("commands") {
     [[maybe_unused]] model::Diagram d;
     auto cmd = std::make_unique<commands::RemoveFieldCommand>(std::tuple{"a", "x"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE((*d.GetClass("a"))->AddField("x", "int"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "int"); }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK(d.GetClasses().front().Fields().empty());
@@ -402,7 +1086,7 @@ DOCTEST_TEST_SUITE("commands") {
     [[maybe_unused]] model::Diagram d;
     auto cmd = std::make_unique<commands::RenameFieldCommand>(std::tuple{"a", "x", "y"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE((*d.GetClass("a"))->AddField("x", "int"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "int"); }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Fields().front().Name(), "y");
@@ -415,7 +1099,7 @@ DOCTEST_TEST_SUITE("commands") {
     [[maybe_unused]] model::Diagram d;
     auto cmd = std::make_unique<commands::RetypeFieldCommand>(std::tuple{"a", "x", "str"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE((*d.GetClass("a"))->AddField("x", "int"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "int"); }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Fields().front().Name(), "x");
@@ -442,8 +1126,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::RemoveMethodCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)")});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK(d.GetClasses().front().Methods().empty());
@@ -455,8 +1140,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::RenameMethodCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)"), "g"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Methods().front().Name(), "g");
@@ -468,8 +1154,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::ChangeReturnTypeCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)"), "int"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Methods().front().ReturnType(), "int");
@@ -482,8 +1169,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::AddParameterCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)"), "c", "any"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Methods().front().Parameters().back().Name(), "c");
@@ -495,8 +1183,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::RemoveParameterCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)"), "b"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Methods().front().Parameters().back().Name(), "a");
@@ -508,8 +1197,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::RenameParameterCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)"), "b", "c"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Methods().front().Parameters().back().Name(), "c");
@@ -521,8 +1211,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::RetypeParameterCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)"), "b", "int"});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Methods().front().Parameters().back().Type(), "int");
@@ -535,8 +1226,9 @@ DOCTEST_TEST_SUITE("commands") {
     auto cmd = std::make_unique<commands::ClearParametersCommand>(
         std::tuple{"a", *model::MethodSignature::FromString("f(int,str)")});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK(d.GetClasses().front().Methods().front().Parameters().empty());
@@ -550,8 +1242,9 @@ DOCTEST_TEST_SUITE("commands") {
                    *model::MethodSignature::FromString("f(int,str)"),
                    *model::Parameter::MultipleFromString("a:int,b:int,c:int,d:int")});
     REQUIRE(d.AddClass("a"));
-    REQUIRE(
-        d.GetClass("a").value()->AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value()));
+    REQUIRE(d.EditClass("a", [](model::Class& c) {
+      return c.AddMethod("f", "void", model::Parameter::MultipleFromString("a:int,b:str").value());
+    }));
     CHECK_FALSE(cmd->Undo(d));
     CHECK(cmd->Commit(d));
     CHECK_EQ(d.GetClasses().front().Methods().front().Parameters().size(), 4);
@@ -5,40 +5,57 @@
 
 namespace commands {
 
-#define DefineCommand(Name, Text)                                               \
-  struct Name : public Command {                                                \
-    static constexpr std::string_view CommandName = Text;                       \
+#define DefineCommandFrom(Base, Name, Syntax)                                   \
+  struct Name : public Base {                                                   \
+    static constexpr std::string_view CommandName = Syntax;                     \
     ~Name() override = default;                                                 \
     inline explicit Name(TupleFor<Name> params) : args{std::move(params)} {     \
     }                                                                           \
     [[nodiscard]] Result<void> Execute(model::Diagram& diagram) const override; \
-    TupleFor<Name> args;                                                        \
-  }
-
-#define DefineUntrackableCommand(Name, Text)                                    \
-  struct Name : public UntrackableCommand {                                     \
-    static constexpr std::string_view CommandName = Text;                       \
-    ~Name() override = default;                                                 \
-    inline explicit Name(TupleFor<Name> params) : args{std::move(params)} {     \
+    [[nodiscard]] std::string_view Text() const noexcept override {             \
+      return CommandName;                                                       \
     }                                                                           \
-    [[nodiscard]] Result<void> Execute(model::Diagram& diagram) const override; \
     TupleFor<Name> args;                                                        \
   }
 
-DefineCommand(LoadCommand, "load [filename]");
+#define DefineCommand(Name, Syntax) DefineCommandFrom(Command, Name, Syntax)
+#define DefineUntrackableCommand(Name, Syntax) DefineCommandFrom(UntrackableCommand, Name, Syntax)
+#define DefineReplacingCommand(Name, Syntax) DefineCommandFrom(ReplacingCommand, Name, Syntax)
+#define DefineExpensiveCommand(Name, Syntax) DefineCommandFrom(ExpensiveCommand, Name, Syntax)
+
+DefineReplacingCommand(LoadCommand, "load [filename]");
 DefineUntrackableCommand(SaveCommand, "save [filename]");
+DefineUntrackableCommand(ExtractCommand, "extract [class_name] [int] [filename]");
+DefineUntrackableCommand(ExtractWithTypesCommand, "extract-with-types [class_name] [int] [filename]");
 DefineUntrackableCommand(ListAllCommand, "list all");
 DefineUntrackableCommand(ListClassesCommand, "list classes");
 DefineUntrackableCommand(ListRelationshipsCommand, "list relationships");
 DefineUntrackableCommand(ListClassCommand, "list class [class_name]");
+DefineUntrackableCommand(ListInvariantsCommand, "list invariants");
+DefineUntrackableCommand(ListUnresolvedCommand, "list unresolved");
+DefineUntrackableCommand(AtListClassCommand, "at [int] list class [class_name]");
+DefineUntrackableCommand(QueryCommand, "query [query]");
+DefineUntrackableCommand(SearchCommand, "search [text]");
+DefineUntrackableCommand(ClonesCommand, "clones");
+DefineUntrackableCommand(LintCommand, "lint");
+DefineUntrackableCommand(AddInvariantCommand, "invariant add [name] [query]");
+DefineUntrackableCommand(RemoveInvariantCommand, "invariant remove [name]");
+DefineUntrackableCommand(BlameCommand, "blame [class_name]");
+DefineUntrackableCommand(PathCommand, "path [class_source] [class_destination]");
+DefineUntrackableCommand(PathViaCommand, "path-via [relationship_type] [class_source] [class_destination]");
+DefineUntrackableCommand(PathsCommand, "paths [class_source] [class_destination] [int]");
+DefineUntrackableCommand(SetCommand, "set [setting] [value]");
+DefineUntrackableCommand(CompactCommand, "compact");
 DefineUntrackableCommand(HelpCommand, "help");
 DefineUntrackableCommand(ExitCommand, "exit");
 DefineUntrackableCommand(UndoCommand, "undo");
 DefineUntrackableCommand(RedoCommand, "redo");
 DefineCommand(AddClassCommand, "class add [name]");
-DefineCommand(RemoveClassCommand, "class remove [class_name]");
-DefineCommand(RenameClassCommand, "class rename [class_name] [name]");
+DefineExpensiveCommand(RemoveClassCommand, "class remove [class_name]");
+DefineExpensiveCommand(RenameClassCommand, "class rename [class_name] [name]");
 DefineCommand(MoveClassCommand, "class move [class_name] [int] [int]");
+DefineExpensiveCommand(MoveAllClassesCommand, "class move-all [filename]");
+DefineUntrackableCommand(ExportPositionsCommand, "class export-positions [filename]");
 DefineCommand(AddFieldCommand, "field add [class_name] [name] [type]");
 DefineCommand(RemoveFieldCommand, "field remove [class_name] [field_name]");
 DefineCommand(RenameFieldCommand, "field rename [class_name] [field_name] [name]");
@@ -62,12 +79,17 @@ DefineCommand(ChangeTypeCommand, "relationship change type [class_source] [class
 
 #undef DefineCommand
 #undef DefineUntrackableCommand
+#undef DefineReplacingCommand
+#undef DefineExpensiveCommand
+#undef DefineCommandFrom
 
 using AllCommands = std::tuple<
     // Class Commands
     AddClassCommand,
     RemoveClassCommand,
     RenameClassCommand,
+    MoveAllClassesCommand,
+    ExportPositionsCommand,
     // Fields Commands
     AddFieldCommand,
     RemoveFieldCommand,
@@ -96,9 +118,28 @@ using AllCommands = std::tuple<
     ListClassesCommand,
     ListRelationshipsCommand,
     ListClassCommand,
+    ListInvariantsCommand,
+    ListUnresolvedCommand,
+    AtListClassCommand,
+    // Query Commands
+    QueryCommand,
+    SearchCommand,
+    ClonesCommand,
+    LintCommand,
+    AddInvariantCommand,
+    RemoveInvariantCommand,
+    BlameCommand,
+    PathCommand,
+    PathViaCommand,
+    PathsCommand,
+    // Session Commands
+    SetCommand,
+    CompactCommand,
     // File Commands
     LoadCommand,
     SaveCommand,
+    ExtractCommand,
+    ExtractWithTypesCommand,
     HelpCommand,
     ExitCommand,
     RedoCommand,
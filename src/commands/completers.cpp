@@ -7,50 +7,127 @@
 #include "model/method_signature.hpp"
 #include "model/parameter.hpp"
 #include "model/relationship.hpp"
+#include "model/type_index.hpp"
+#include "utils/settings.hpp"
 
 #include <doctest/doctest.h>
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <ranges>
+#include <tuple>
+#include <utility>
 
 namespace commands {
 
+CompletionSnapshot CompletionSnapshot::From(model::Diagram const& diagram) {
+  CompletionSnapshot snapshot;
+  snapshot.classes = diagram.GetClassNames();
+  // relationships are sorted by source, then destination
+  for (model::Relationship const& r : diagram.GetRelationships()) {
+    snapshot.destinations[r.Source()].push_back(r.Destination());
+  }
+  snapshot.sources = std::ranges::to<std::vector>(std::views::keys(snapshot.destinations));
+  snapshot.types = diagram.GetTypeIndex().Ranking();
+  return snapshot;
+}
+
+CompletionPublisher& CompletionPublisher::GetInstance() noexcept {
+  static CompletionPublisher publisher;
+  return publisher;
+}
+
+void CompletionPublisher::Refresh(model::Diagram& diagram) {
+  Wait();
+  // the indexes are brought up to date here, so the worker only reads the diagram
+  diagram.RefreshIndexes();
+  worker_ = std::jthread{[this, &diagram = std::as_const(diagram)] {
+    latest_.store(std::make_shared<CompletionSnapshot const>(CompletionSnapshot::From(diagram)));
+  }};
+}
+
+void CompletionPublisher::Wait() {
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+std::shared_ptr<CompletionSnapshot const> CompletionPublisher::Latest() const {
+  if (auto latest = latest_.load(); latest != nullptr) {
+    return latest;
+  }
+  static auto const empty = std::make_shared<CompletionSnapshot const>();
+  return empty;
+}
+
 [[nodiscard]] std::vector<std::string> ClassCompleter::Candidates() const {
-  return diagram.get().GetClassNames();
+  return snapshot.get().classes;
+}
+
+[[nodiscard]] Result<model::Handle> ClassCompleter::Get() const {
+  return diagram.get().GetHandle(name);
+}
+
+///
+/// @brief Resolve the class a completer holds a handle to
+///
+/// @param diagram
+/// @param cls
+/// @return the class, or an error if there was none or it no longer exists
+///
+static Result<Iter<model::Class>> Resolve(model::Diagram const& diagram, Result<model::Handle> const& cls) {
+  return cls.and_then([&](model::Handle handle) { return diagram.GetClass(handle); });
 }
 
-[[nodiscard]] Result<Iter<model::Class>> ClassCompleter::Get() const {
-  return diagram.get().GetClass(name);
+///
+/// @brief Resolve the method a completer holds a handle to
+///
+/// @param diagram
+/// @param cls
+/// @param method
+/// @return the method, or an error if there was none or it no longer exists
+///
+static Result<Iter<model::Method>> Resolve(model::Diagram const& diagram,
+                                           Result<model::Handle> const& cls,
+                                           Result<model::Handle> const& method) {
+  return Resolve(diagram, cls).and_then([&](auto c) {
+    return method.and_then([&](model::Handle handle) { return c->GetReadOnlyMethod(handle); });
+  });
 }
 
 [[nodiscard]] std::vector<std::string> FieldCompleter::Candidates() const {
-  return iter
+  return Resolve(diagram, cls)
       .transform([](auto i) {
         return i->Fields() | std::views::transform(&model::Field::Name) | std::ranges::to<std::vector>();
       })
       .value_or(std::vector<std::string>{});
 }
 
-[[nodiscard]] Result<Iter<model::Field>> FieldCompleter::Get() const {
-  return iter.and_then([&](auto i) { return i->GetReadOnlyField(name); });
+[[nodiscard]] Result<model::Handle> FieldCompleter::Get() const {
+  return Resolve(diagram, cls).and_then([&](auto i) { return i->GetReadOnlyField(name); }).transform([](auto f) {
+    return f->GetHandle();
+  });
 }
 
 [[nodiscard]] std::vector<std::string> MethodCompleter::Candidates() const {
-  return iter
+  return Resolve(diagram, cls)
       .transform([](auto i) {
         return i->Methods() | std::views::transform(&model::Method::ToSignatureString) | std::ranges::to<std::vector>();
       })
       .value_or(std::vector<std::string>{});
 }
 
-[[nodiscard]] Result<Iter<model::Method>> MethodCompleter::Get() const {
-  return model::MethodSignature::FromString(signature).and_then(
-      [&](auto sig) { return iter.and_then([&](auto i) { return i->GetReadOnlyMethodFromSignature(sig); }); });
+[[nodiscard]] Result<model::Handle> MethodCompleter::Get() const {
+  return model::MethodSignature::FromString(signature)
+      .and_then([&](auto sig) {
+        return Resolve(diagram, cls).and_then([&](auto i) { return i->GetReadOnlyMethodFromSignature(sig); });
+      })
+      .transform([](auto m) { return m->GetHandle(); });
 }
 
 [[nodiscard]] std::vector<std::string> ParameterCompleter::Candidates() const {
-  return iter
+  return Resolve(diagram, cls, method)
       .transform([](auto i) {
         return i->Parameters() | std::views::transform(&model::Parameter::Name) | std::ranges::to<std::vector>();
       })
@@ -58,21 +135,19 @@ namespace commands {
 }
 
 [[nodiscard]] Result<Iter<model::Parameter>> ParameterCompleter::Get() const {
-  return iter.and_then([&](auto i) { return i->GetReadOnlyParameter(name); });
+  return Resolve(diagram, cls, method).and_then([&](auto i) { return i->GetReadOnlyParameter(name); });
 }
 
 [[nodiscard]] std::vector<std::string> RelationshipSourceCompleter::Candidates() const {
-  std::vector sources = diagram.get().GetRelationships() | std::views::transform(&model::Relationship::Source) |
-                        std::ranges::to<std::vector>();
-  std::ranges::sort(sources);
-  auto r = std::ranges::unique(sources);
-  sources.erase(r.begin(), r.end());
-  return sources;
+  return snapshot.get().sources;
 }
 
 [[nodiscard]] std::vector<std::string> RelationshipDestinationCompleter::Candidates() const {
-  return diagram.get().GetRelationships() | std::views::filter([&](auto const& r) { return r.Source() == source; }) |
-         std::views::transform(&model::Relationship::Destination) | std::ranges::to<std::vector>();
+  if (auto destinations = snapshot.get().destinations.find(source); destinations != snapshot.get().destinations.end()) {
+    return destinations->second;
+  } else {
+    return {};
+  }
 }
 
 [[nodiscard]] Result<Iter<model::Relationship>> RelationshipDestinationCompleter::Get() const {
@@ -83,6 +158,14 @@ namespace commands {
   return {"Aggregation", "Composition", "Inheritance", "Realization"};
 }
 
+[[nodiscard]] std::vector<std::string> TypeCompleter::Candidates() const {
+  return snapshot.get().types->Top(prefix);
+}
+
+[[nodiscard]] std::vector<std::string> SettingCompleter::Candidates() const {
+  return std::ranges::to<std::vector<std::string>>(Settings::Names);
+}
+
 } // namespace commands
 
 DOCTEST_TEST_SUITE("commands::Completers") {
@@ -93,60 +176,66 @@ DOCTEST_TEST_SUITE("commands::Completers") {
     REQUIRE(d.AddClass("a3"));
     REQUIRE(d.AddClass("b1"));
     REQUIRE(d.AddClass("b2"));
-    [[maybe_unused]] commands::ClassCompleter c{.diagram = std::cref(d), .name = "a1"};
+    auto const snapshot = commands::CompletionSnapshot::From(d);
+    [[maybe_unused]] commands::ClassCompleter c{.diagram = std::cref(d), .snapshot = std::cref(snapshot), .name = "a1"};
     CHECK(std::ranges::contains(c.Candidates(), "a1"));
     CHECK(std::ranges::contains(c.Candidates(), "a2"));
     CHECK(std::ranges::contains(c.Candidates(), "a3"));
     CHECK(std::ranges::contains(c.Candidates(), "b1"));
     CHECK(std::ranges::contains(c.Candidates(), "b2"));
     REQUIRE(c.Get());
-    CHECK_EQ(c.Get().value()->Name(), "a1");
+    CHECK_EQ(d.GetClass(c.Get().value()).value()->Name(), "a1");
   }
   DOCTEST_TEST_CASE("commands::FieldCompleter") {
     model::Diagram d;
     REQUIRE(d.AddClass("a"));
-    auto res = d.GetClass("a");
-    REQUIRE(res);
-    auto a = res.value();
-    REQUIRE(a->AddField("x", "int"));
-    REQUIRE(a->AddField("y", "str"));
-    REQUIRE(a->AddField("z", "any"));
-    commands::FieldCompleter c{.iter = a, .name = "x"};
+    for (auto const& [name, type] : {std::pair{"x", "int"}, std::pair{"y", "str"}, std::pair{"z", "any"}}) {
+      REQUIRE(d.EditClass("a", [&](model::Class& a) { return a.AddField(name, type); }));
+    }
+    commands::FieldCompleter c{.diagram = std::cref(d), .cls = d.GetHandle("a"), .name = "x"};
     CHECK(std::ranges::contains(c.Candidates(), "x"));
     CHECK(std::ranges::contains(c.Candidates(), "y"));
     CHECK(std::ranges::contains(c.Candidates(), "z"));
     REQUIRE(c.Get());
-    CHECK_EQ(c.Get().value()->Name(), "x");
+    auto const x = c.Get().value();
+    CHECK_EQ(d.GetClass("a").value()->GetReadOnlyField(x).value()->Name(), "x");
+
+    // the completer holds handles, so it stays valid while classes are added before the class
+    REQUIRE(d.AddClass("A"));
+    CHECK_EQ(c.Candidates().size(), 3);
+    CHECK_EQ(c.Get(), x);
   }
   DOCTEST_TEST_CASE("commands::MethodCompleter") {
     model::Diagram d;
     REQUIRE(d.AddClass("a"));
-    auto res = d.GetClass("a");
-    REQUIRE(res);
-    auto a = res.value();
-    REQUIRE(a->AddMethod("f", "void", {}));
-    REQUIRE(a->AddMethod("f", "int", *model::Parameter::MultipleFromString("a:int")));
-    REQUIRE(a->AddMethod("f", "str", *model::Parameter::MultipleFromString("a:int,b:str")));
-    commands::MethodCompleter c{.iter = a, .signature = "f(int)"};
+    for (auto const& [type, parameters] :
+         {std::pair{"void", ""}, std::pair{"int", "a:int"}, std::pair{"str", "a:int,b:str"}}) {
+      REQUIRE(d.EditClass("a", [&](model::Class& a) {
+        return a.AddMethod("f", type, *model::Parameter::MultipleFromString(parameters));
+      }));
+    }
+    commands::MethodCompleter c{.diagram = std::cref(d), .cls = d.GetHandle("a"), .signature = "f(int)"};
     CHECK(std::ranges::contains(c.Candidates(), "f()"));
     CHECK(std::ranges::contains(c.Candidates(), "f(int)"));
     CHECK(std::ranges::contains(c.Candidates(), "f(int,str)"));
     REQUIRE(c.Get());
-    CHECK_EQ(c.Get().value()->Name(), "f");
-    CHECK_EQ(c.Get().value()->ReturnType(), "int");
-    CHECK_EQ(c.Get().value()->Parameters().size(), 1);
+    auto const m = d.GetClass("a").value()->GetReadOnlyMethod(c.Get().value());
+    REQUIRE(m);
+    CHECK_EQ(m.value()->Name(), "f");
+    CHECK_EQ(m.value()->ReturnType(), "int");
+    CHECK_EQ(m.value()->Parameters().size(), 1);
   }
   DOCTEST_TEST_CASE("commands::ParameterCompleter") {
     model::Diagram d;
     REQUIRE(d.AddClass("a"));
-    auto res = d.GetClass("a");
-    REQUIRE(res);
-    auto a = res.value();
-    REQUIRE(a->AddMethod("f", "str", *model::Parameter::MultipleFromString("a:int,b:str,c:any")));
-    auto res2 = a->GetMethodFromSignature(*model::MethodSignature::FromString("f(int,str,any)"));
-    REQUIRE(res2);
-    auto m = res2.value();
-    commands::ParameterCompleter c{.iter = m, .name = "b"};
+    REQUIRE(d.EditClass("a", [](model::Class& a) {
+      return a.AddMethod("f", "str", *model::Parameter::MultipleFromString("a:int,b:str,c:any"));
+    }));
+    auto const m = d.GetClass("a").value()->GetReadOnlyMethodFromSignature(
+        *model::MethodSignature::FromString("f(int,str,any)"));
+    REQUIRE(m);
+    commands::ParameterCompleter c{
+        .diagram = std::cref(d), .cls = d.GetHandle("a"), .method = m.value()->GetHandle(), .name = "b"};
     CHECK(std::ranges::contains(c.Candidates(), "a"));
     CHECK(std::ranges::contains(c.Candidates(), "b"));
     CHECK(std::ranges::contains(c.Candidates(), "c"));
@@ -162,7 +251,9 @@ DOCTEST_TEST_SUITE("commands::Completers") {
     REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
     REQUIRE(d.AddRelationship("a", "c", model::RelationshipType::Inheritance));
     REQUIRE(d.AddRelationship("b", "c", model::RelationshipType::Composition));
-    [[maybe_unused]] commands::RelationshipSourceCompleter c{.diagram = std::cref(d), .source = "a"};
+    auto const snapshot = commands::CompletionSnapshot::From(d);
+    [[maybe_unused]] commands::RelationshipSourceCompleter c{
+        .diagram = std::cref(d), .snapshot = std::cref(snapshot), .source = "a"};
     CHECK(std::ranges::contains(c.Candidates(), "a"));
     CHECK(std::ranges::contains(c.Candidates(), "b"));
     CHECK_FALSE(std::ranges::contains(c.Candidates(), "c"));
@@ -175,7 +266,9 @@ DOCTEST_TEST_SUITE("commands::Completers") {
     REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
     REQUIRE(d.AddRelationship("a", "c", model::RelationshipType::Inheritance));
     REQUIRE(d.AddRelationship("b", "c", model::RelationshipType::Composition));
-    [[maybe_unused]] commands::RelationshipDestinationCompleter c{.diagram = std::cref(d), .source = "a", .dest = "b"};
+    auto const snapshot = commands::CompletionSnapshot::From(d);
+    [[maybe_unused]] commands::RelationshipDestinationCompleter c{
+        .diagram = std::cref(d), .snapshot = std::cref(snapshot), .source = "a", .dest = "b"};
     CHECK_FALSE(std::ranges::contains(c.Candidates(), "a"));
     CHECK(std::ranges::contains(c.Candidates(), "b"));
     CHECK(std::ranges::contains(c.Candidates(), "c"));
@@ -191,4 +284,44 @@ DOCTEST_TEST_SUITE("commands::Completers") {
     CHECK(std::ranges::contains(c.Candidates(), "Composition"));
     CHECK(std::ranges::contains(c.Candidates(), "Realization"));
   }
+  DOCTEST_TEST_CASE("commands::TypeCompleter") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "string"); }));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("y", "size_t"); }));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("z", "size_t"); }));
+    d.RefreshIndexes();
+    auto const snapshot = commands::CompletionSnapshot::From(d);
+    [[maybe_unused]] commands::TypeCompleter c{.snapshot = std::cref(snapshot), .prefix = "s"};
+    CHECK_EQ(c.Candidates(), std::vector<std::string>{"size_t", "string"});
+    c.prefix = "st";
+    CHECK_EQ(c.Candidates(), std::vector<std::string>{"string"});
+  }
+  DOCTEST_TEST_CASE("commands::CompletionPublisher") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    commands::CompletionPublisher publisher;
+    CHECK(publisher.Latest()->classes.empty());
+    publisher.Refresh(d);
+    publisher.Wait();
+    auto const first = publisher.Latest();
+    CHECK_EQ(first->classes, std::vector<std::string>{"a"});
+
+    REQUIRE(d.AddClass("b"));
+    publisher.Refresh(d);
+    publisher.Wait();
+    CHECK_EQ(publisher.Latest()->classes, std::vector<std::string>{"a", "b"});
+    // a snapshot already handed out stays as it was
+    CHECK_EQ(first->classes, std::vector<std::string>{"a"});
+
+    // the types are ranked as of the change, without waiting for anything else to refresh the indexes
+    REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("x", "int"); }));
+    publisher.Refresh(d);
+    publisher.Wait();
+    CHECK_EQ(publisher.Latest()->types->Top(""), std::vector<std::string>{"int"});
+  }
+  DOCTEST_TEST_CASE("commands::SettingCompleter") {
+    [[maybe_unused]] commands::SettingCompleter c{};
+    CHECK(std::ranges::contains(c.Candidates(), "hash-consing"));
+  }
 }
@@ -1,5 +1,14 @@
 #include "model/diagram.hpp"
+#include "model/type_ranking.hpp"
+#include "utils/shared.hpp"
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <variant>
 #include <vector>
 
@@ -7,54 +16,122 @@ template <typename T> using Iter = std::vector<T>::const_iterator;
 
 namespace commands {
 
+///
+/// @brief Every completion candidate which would otherwise take a scan of the diagram
+///
+/// Completers only read snapshots for their candidates, so listing them never scans the diagram being edited.
+///
+struct CompletionSnapshot {
+  /// every class name, sorted
+  std::vector<std::string> classes;
+  /// every class which is the source of a relationship, sorted
+  std::vector<std::string> sources;
+  /// source -> the destinations of its relationships, sorted
+  std::map<std::string, std::vector<std::string>, std::less<>> destinations;
+  /// every type mentioned anywhere, ranked for every prefix (shared with the type index until it next changes)
+  Shared<model::TypeRanking> types;
+
+  ///
+  /// @brief Gather the candidates of a diagram
+  ///
+  /// @param diagram a diagram whose indexes are up to date
+  /// @return the snapshot
+  ///
+  [[nodiscard]] static CompletionSnapshot From(model::Diagram const& diagram);
+};
+
+///
+/// @brief Takes completion snapshots on a background thread and publishes the latest one
+///
+class CompletionPublisher {
+  std::atomic<std::shared_ptr<CompletionSnapshot const>> latest_;
+  std::jthread worker_;
+
+public:
+  ///
+  /// @brief Singleton for CompletionPublisher
+  ///
+  [[nodiscard]] static CompletionPublisher& GetInstance() noexcept;
+
+  ///
+  /// @brief Bring the indexes of a diagram up to date and start taking a snapshot of it, replacing the published one
+  ///        once done
+  ///
+  /// @param diagram a diagram which must not be modified until Wait() returns
+  ///
+  void Refresh(model::Diagram& diagram);
+
+  ///
+  /// @brief Wait until the snapshot being taken, if any, is published
+  ///
+  void Wait();
+
+  ///
+  /// @brief Get the most recently published snapshot without waiting for one being taken
+  ///
+  /// @return the snapshot, or an empty snapshot if none was published yet
+  ///
+  [[nodiscard]] std::shared_ptr<CompletionSnapshot const> Latest() const;
+};
+
 ///
 /// @brief A completer for classes
 ///
 struct ClassCompleter {
   /// const-reference to a diagram
   std::reference_wrapper<model::Diagram const> diagram;
+  /// const-reference to a completion snapshot
+  std::reference_wrapper<CompletionSnapshot const> snapshot;
   /// held name for match
   std::string_view name;
   /// returns a list of candidates
   [[nodiscard]] std::vector<std::string> Candidates() const;
-  /// get the class' iterator
-  [[nodiscard]] Result<Iter<model::Class>> Get() const;
+  /// get the class' handle
+  [[nodiscard]] Result<model::Handle> Get() const;
 };
 
 ///
 /// @brief A completer for fields
 ///
 struct FieldCompleter {
-  /// held iterator to class to match fields
-  Result<Iter<model::Class>> iter;
+  /// const-reference to a diagram
+  std::reference_wrapper<model::Diagram const> diagram;
+  /// held handle to class to match fields
+  Result<model::Handle> cls;
   /// held name for match
   std::string_view name;
   /// returns a list of candidates
   [[nodiscard]] std::vector<std::string> Candidates() const;
-  /// get the field's iterator
-  [[nodiscard]] Result<Iter<model::Field>> Get() const;
+  /// get the field's handle
+  [[nodiscard]] Result<model::Handle> Get() const;
 };
 
 ///
 /// @brief A completer for methods
 ///
 struct MethodCompleter {
-  /// held iterator to class to match methods
-  Result<Iter<model::Class>> iter;
+  /// const-reference to a diagram
+  std::reference_wrapper<model::Diagram const> diagram;
+  /// held handle to class to match methods
+  Result<model::Handle> cls;
   /// held name for match
   std::string_view signature;
   /// returns a list of candidates
   [[nodiscard]] std::vector<std::string> Candidates() const;
-  /// get the method's iterator
-  [[nodiscard]] Result<Iter<model::Method>> Get() const;
+  /// get the method's handle
+  [[nodiscard]] Result<model::Handle> Get() const;
 };
 
 ///
 /// @brief A completer for parameters
 ///
 struct ParameterCompleter {
-  /// held iterator to method to match parameters
-  Result<Iter<model::Method>> iter;
+  /// const-reference to a diagram
+  std::reference_wrapper<model::Diagram const> diagram;
+  /// held handle to class of the method
+  Result<model::Handle> cls;
+  /// held handle to method to match parameters
+  Result<model::Handle> method;
   /// held name for match
   std::string_view name;
   /// returns a list of candidates
@@ -69,6 +146,8 @@ struct ParameterCompleter {
 struct RelationshipSourceCompleter {
   /// const-reference to a diagram
   std::reference_wrapper<model::Diagram const> diagram;
+  /// const-reference to a completion snapshot
+  std::reference_wrapper<CompletionSnapshot const> snapshot;
   /// held name for match
   std::string_view source;
   /// returns a list of candidates
@@ -81,6 +160,8 @@ struct RelationshipSourceCompleter {
 struct RelationshipDestinationCompleter {
   /// const-reference to a diagram
   std::reference_wrapper<model::Diagram const> diagram;
+  /// const-reference to a completion snapshot
+  std::reference_wrapper<CompletionSnapshot const> snapshot;
   /// held name for match
   std::string_view source;
   /// held name for match
@@ -98,6 +179,25 @@ struct RelationshipTypeCompleter {
   [[nodiscard]] std::vector<std::string> Candidates() const;
 };
 
+///
+/// @brief A completer for types, offering the types already used most often first
+///
+struct TypeCompleter {
+  /// const-reference to a completion snapshot
+  std::reference_wrapper<CompletionSnapshot const> snapshot;
+  /// held prefix for match
+  std::string_view prefix;
+  /// returns at most model::TypeRanking::RankedPerPrefix candidates, most used first
+  [[nodiscard]] std::vector<std::string> Candidates() const;
+};
+
+///
+/// @brief A completer for setting names
+///
+struct SettingCompleter {
+  [[nodiscard]] std::vector<std::string> Candidates() const;
+};
+
 ///
 /// @brief The completer is a variant of all possible completers (or none)
 ///
@@ -108,6 +208,8 @@ using Completer = std::variant<std::monostate,
                                ParameterCompleter,
                                RelationshipSourceCompleter,
                                RelationshipDestinationCompleter,
-                               RelationshipTypeCompleter>;
+                               RelationshipTypeCompleter,
+                               TypeCompleter,
+                               SettingCompleter>;
 
 } // namespace commands
@@ -3,6 +3,7 @@
 #include "model/method.hpp"
 #include "model/method_signature.hpp"
 #include "model/parameter.hpp"
+#include "model/query.hpp"
 #include "model/relationship_type.hpp"
 
 #include <algorithm>
@@ -71,6 +72,9 @@ template <typename Command, std::size_t Index> static constexpr auto ParseParam(
   } else if constexpr (param == "[relationship_type]") {
     // relationship_type is RelationshipType
     return model::RelationshipTypeFromString(arg);
+  } else if constexpr (param == "[query]") {
+    // query is Query
+    return model::Query::FromString(arg);
   } else if constexpr (param == "[name]" or              //
                        param == "[type]" or              //
                        param == "[class_name]" or        //
@@ -78,6 +82,9 @@ template <typename Command, std::size_t Index> static constexpr auto ParseParam(
                        param == "[class_destination]" or //
                        param == "[param_name]" or        //
                        param == "[field_name]" or        //
+                       param == "[text]" or              //
+                       param == "[setting]" or           //
+                       param == "[value]" or             //
                        param == "[filename]") {
     // everything else is "identity" (a.k.a. string)
     return Result<std::string>{arg};
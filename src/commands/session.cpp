@@ -0,0 +1,340 @@
+#include "session.hpp"
+
+#include "commands/base_commands.hpp"
+#include "commands/commands.hpp"
+#include "commands/timeline.hpp"
+#include "model/class.hpp"
+#include "model/delta.hpp"
+#include "model/relationship.hpp"
+#include "model/relationship_type.hpp"
+#include "utils/binary.hpp"
+#include "utils/file_io.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/parallel.hpp"
+
+#include <doctest/doctest.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace commands {
+
+/// identifies a session file (followed by the version of its layout)
+constexpr static std::string_view SessionMagic{"UMLS"};
+/// the layout of session files written by this version
+constexpr static std::uint64_t SessionVersion{2};
+
+///
+/// @brief A command of a resumed session, which reproduces the change the original command made without repeating it
+///
+class ResumedCommand : public ExpensiveCommand {
+  std::string_view text_;
+  model::Delta change_;
+
+public:
+  ResumedCommand(std::string_view text, model::Delta change) : text_{text}, change_{std::move(change)} {
+  }
+
+  ~ResumedCommand() noexcept override = default;
+
+  [[nodiscard]] Result<void> Execute(model::Diagram& diagram) const override {
+    diagram.Apply(change_);
+    return {};
+  }
+
+  [[nodiscard]] std::string_view Text() const noexcept override {
+    return text_;
+  }
+};
+
+///
+/// @brief Get the classes an applied command changed
+///
+/// @param command
+/// @param before the diagram immediately before the command
+/// @param after the diagram immediately after the command, which is only read if the command lost track of the
+///              classes it changed
+/// @return the classes recorded when the command was committed, or every class of either state if the command lost
+///         track of them (e.g. because it replaced the diagram)
+///
+static std::vector<std::string> ChangedClasses(Command const& command,
+                                               model::Diagram const& before,
+                                               model::Diagram const* after) {
+  if (auto const& changed = command.Changed(); changed) {
+    return *changed;
+  }
+  std::vector<std::string> changed;
+  std::ranges::set_union(before.GetClassNames(), after->GetClassNames(), std::back_inserter(changed));
+  return changed;
+}
+
+static void EncodeDelta(model::Delta const& delta, BinaryWriter& out) {
+  // a class which does not exist on that side of the edit is written as its name alone
+  out.Elements(delta.classes, [](auto const& entry, BinaryWriter& w) {
+    auto const& [name, c] = entry;
+    w.Integer(static_cast<std::uint8_t>(c.has_value()));
+    if (c) {
+      c->Encode(w);
+    } else {
+      w.String(name);
+    }
+  });
+  out.Elements(delta.relationships, &model::Relationship::Encode);
+}
+
+static Result<model::Delta> DecodeDelta(BinaryReader& in) {
+  using Entry = std::pair<std::string, std::optional<model::Class>>;
+  auto const entry = [](BinaryReader& r) {
+    return r.Integer<std::uint8_t>().and_then([&](std::uint8_t exists) -> Result<Entry> {
+      if (exists == 0) {
+        return r.String().transform([](std::string_view name) { return Entry{name, std::nullopt}; });
+      }
+      return model::Class::Decode(r).transform([](model::Class c) {
+        std::string name{c.Name()};
+        return Entry{std::move(name), std::move(c)};
+      });
+    });
+  };
+  return in.Elements(entry).and_then([&](std::vector<Entry> classes) {
+    return in.Elements(&model::Relationship::Decode).transform([&](std::vector<model::Relationship> relationships) {
+      return model::Delta{.classes = {std::make_move_iterator(classes.begin()), std::make_move_iterator(classes.end())},
+                          .relationships = std::move(relationships)};
+    });
+  });
+}
+
+/// an applied command as recorded in a session file
+struct Step {
+  /// the syntax of the command, pointing into CommandStrings
+  std::string_view command;
+  /// the classes the command changed, as they were before it
+  model::Delta prior;
+};
+
+static Result<Step> DecodeStep(BinaryReader& in) {
+  return in.String()
+      .and_then([](std::string_view text) -> Result<std::string_view> {
+        if (auto i = std::ranges::find(CommandStrings, text); i != CommandStrings.end()) {
+          return *i;
+        } else {
+          return std::unexpected{std::format("unknown command '{}'", text)};
+        }
+      })
+      .and_then([&](std::string_view command) {
+        return DecodeDelta(in).transform([&](model::Delta prior) {
+          return Step{.command = command, .prior = std::move(prior)};
+        });
+      });
+}
+
+std::string DefaultSessionFile() {
+  // NOLINTNEXTLINE(concurrency-mt-unsafe) the environment is not modified
+  char const* const home{std::getenv("HOME")};
+  return (std::filesystem::path{home == nullptr ? "." : home} / ".uml_editor_session").string();
+}
+
+Result<void> SaveSession(std::string_view file_name, model::Diagram const& diagram) {
+  Timeline const& timeline = Timeline::GetInstance();
+  auto const applied = timeline.Applied();
+  /// an applied command, and the diagrams around it if it holds the whole state before it
+  struct Held {
+    Command const* command;
+    model::Diagram const* before;
+    model::Diagram const* after;
+  };
+  // back to the oldest applied command which still holds what it changed; the state after an adopted command is
+  // not held anywhere, but the command before it needs it only if it lost track of what it changed
+  std::vector<Held> history;
+  model::Diagram const* later{&diagram};
+  for (std::size_t step{applied.size()}; step > 0; --step) {
+    Command const& command = *applied[step - 1];
+    if (command.PriorDelta() != nullptr) {
+      history.push_back({.command = &command, .before = nullptr, .after = nullptr});
+      later = nullptr;
+    } else if (auto const* before = command.PriorState(); before != nullptr and (command.Changed() or later)) {
+      history.push_back({.command = &command, .before = before, .after = later});
+      later = before;
+    } else {
+      break;
+    }
+  }
+  std::ranges::reverse(history);
+  // the header and the diagram, followed by every step, each written as it was produced rather than joined
+  std::vector<std::string> buffers(history.size() + 1);
+  ParallelFor(
+      history.size(),
+      [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i{begin}; i < end; ++i) {
+          auto const& [command, before, after] = history[i];
+          BinaryWriter out;
+          out.String(command->Text());
+          if (before == nullptr) {
+            EncodeDelta(*command->PriorDelta(), out);
+          } else {
+            EncodeDelta(before->Capture(ChangedClasses(*command, *before, after)), out);
+          }
+          buffers[i + 1] = std::move(out.Bytes());
+        }
+      },
+      /*min_items_per_chunk=*/1);
+  BinaryWriter header;
+  header.Bytes().append(SessionMagic);
+  header.Integer(SessionVersion);
+  diagram.Encode(header);
+  header.Integer(history.size());
+  buffers.front() = std::move(header.Bytes());
+  return WriteBuffers(file_name, buffers).transform_error([](std::string&& error) {
+    return std::format("Error: {}", error);
+  });
+}
+
+Result<void> ResumeSession(std::string_view file_name, model::Diagram& diagram) {
+  auto const mapped = MappedFile::Open(file_name);
+  if (not mapped) {
+    return std::unexpected{std::format("Error: Cannot read session \"{}\"", file_name)};
+  }
+  std::string_view const contents{mapped->Contents()};
+  BinaryReader in{contents.substr(std::min(contents.size(), SessionMagic.size()))};
+  if (not contents.starts_with(SessionMagic) or in.Integer<std::uint64_t>() != SessionVersion) {
+    return std::unexpected{std::format("Error: \"{}\" is not a session file of this version", file_name)};
+  }
+  auto live = model::Diagram::Decode(in);
+  auto steps = live.and_then([&](model::Diagram const&) { return in.Elements(DecodeStep); })
+                   .and_then([&](std::vector<Step> history) -> Result<std::vector<Step>> {
+                     if (not in.AtEnd()) {
+                       return std::unexpected{"unexpected data after the history"};
+                     }
+                     return history;
+                   });
+  if (not steps) {
+    return std::unexpected{std::format("Error: Corrupt session \"{}\": {}", file_name, steps.error())};
+  }
+  // walk back to the oldest recorded state on a single copy of the diagram, handing each command what it changed as it
+  // was before and after it, so that none of them is executed or checked again; what the copy holds is captured
+  // rather than the steps as read, so the classes keep the handles that undoing the commands gives them
+  model::Diagram state{*live};
+  std::vector<std::shared_ptr<Command>> commands(steps->size());
+  for (std::size_t i{steps->size()}; i > 0; --i) {
+    Step const& step = (*steps)[i - 1];
+    auto const changed = std::ranges::to<std::vector<std::string>>(std::views::keys(step.prior.classes));
+    auto command = std::make_shared<ResumedCommand>(step.command, state.Capture(changed));
+    state.Apply(step.prior);
+    command->Adopt(state.Capture(changed), static_cast<std::uint32_t>(i));
+    commands[i - 1] = std::move(command);
+  }
+  Timeline timeline;
+  for (std::shared_ptr<Command>& command : commands) {
+    timeline.Add(std::move(command));
+  }
+  Timeline::GetInstance() = std::move(timeline);
+  diagram = std::move(*live);
+  diagram.RefreshIndexes();
+  return {};
+}
+
+} // namespace commands
+
+DOCTEST_TEST_SUITE("commands::Session") {
+  DOCTEST_TEST_CASE("commands::Session") {
+    auto& timeline = commands::Timeline::GetInstance();
+    timeline = commands::Timeline{};
+    model::Diagram d;
+    // the diagram after each command
+    std::vector<nlohmann::json> states{nlohmann::json(d)};
+    auto const run = [&](std::shared_ptr<commands::Command> cmd) {
+      REQUIRE(cmd->Commit(d));
+      timeline.Add(std::move(cmd));
+      states.emplace_back(d);
+    };
+    run(std::make_shared<commands::AddClassCommand>(std::tuple{"a"}));
+    run(std::make_shared<commands::AddClassCommand>(std::tuple{"b"}));
+    run(std::make_shared<commands::AddFieldCommand>(std::tuple{"a", "x", "int"}));
+    run(std::make_shared<commands::AddRelationshipCommand>(
+        std::tuple{"a", "b", model::RelationshipType::Composition}));
+    run(std::make_shared<commands::RenameClassCommand>(std::tuple{"a", "d"}));
+    run(std::make_shared<commands::RenameClassCommand>(std::tuple{"b", "c"}));
+    // an undone command is not part of the session
+    REQUIRE(timeline.Undo().and_then([&](auto&& cmd) { return cmd->Undo(d); }));
+    states.pop_back();
+
+    [[maybe_unused]] auto const file = (std::filesystem::temp_directory_path() / "test.session").string();
+    REQUIRE(commands::SaveSession(file, d));
+    timeline = commands::Timeline{};
+    d = model::Diagram{};
+    REQUIRE(commands::ResumeSession(file, d));
+    CHECK_EQ(nlohmann::json(d), states.back());
+    REQUIRE_EQ(timeline.Position(), 5);
+    CHECK_EQ(timeline.Applied().front()->Text(), "class add [name]");
+    CHECK_EQ(timeline.Applied()[3]->Text(), "relationship add [class_name] [class_name] [relationship_type]");
+    CHECK_EQ(timeline.Applied()[3]->Changed(), std::vector<std::string>{"a", "b"});
+    CHECK_EQ(timeline.Applied().back()->Text(), "class rename [class_name] [name]");
+    CHECK_EQ(timeline.Applied().back()->GetProvenance(), model::Provenance{5, "class rename"});
+    // the renamed class is part of the change under both names
+    CHECK_EQ(timeline.Applied().back()->Changed(), std::vector<std::string>{"a", "b", "d"});
+    CHECK_FALSE(d.GetClass("a"));
+    CHECK(d.Valid(d.GetHandle("d").value()));
+
+    // every resumed command can be undone and redone
+    for (std::size_t step{5}; step > 0; --step) {
+      REQUIRE(timeline.Undo().and_then([&](auto&& cmd) { return cmd->Undo(d); }));
+      CHECK_EQ(nlohmann::json(d), states[step - 1]);
+    }
+    for (std::size_t step{1}; step <= 5; ++step) {
+      REQUIRE(timeline.Redo().and_then([&](auto&& cmd) { return cmd->Redo(d); }));
+      CHECK_EQ(nlohmann::json(d), states[step]);
+    }
+    CHECK(d.Valid(d.GetHandle("b").value()));
+
+    // resumed commands hold only what they changed, which is written again along with the commands run since
+    CHECK_EQ(timeline.Applied().front()->PriorState(), nullptr);
+    REQUIRE_NE(timeline.Applied().front()->PriorDelta(), nullptr);
+    CHECK_EQ(timeline.Applied().front()->PriorDelta()->classes.size(), 1);
+    run(std::make_shared<commands::AddClassCommand>(std::tuple{"e"}));
+    REQUIRE(commands::SaveSession(file, d));
+    timeline = commands::Timeline{};
+    d = model::Diagram{};
+    REQUIRE(commands::ResumeSession(file, d));
+    CHECK_EQ(nlohmann::json(d), states.back());
+    REQUIRE_EQ(timeline.Position(), 6);
+    for (std::size_t step{6}; step > 0; --step) {
+      REQUIRE(timeline.Undo().and_then([&](auto&& cmd) { return cmd->Undo(d); }));
+      CHECK_EQ(nlohmann::json(d), states[step - 1]);
+    }
+    for (std::size_t step{1}; step <= 6; ++step) {
+      REQUIRE(timeline.Redo().and_then([&](auto&& cmd) { return cmd->Redo(d); }));
+      CHECK_EQ(nlohmann::json(d), states[step]);
+    }
+
+    // a missing, malformed, truncated, or extended session changes nothing
+    std::string bytes;
+    {
+      std::ifstream saved{file, std::ios::binary};
+      bytes.assign(std::istreambuf_iterator<char>{saved}, {});
+    }
+    CHECK_FALSE(commands::ResumeSession("/nonexistent-session", d));
+    std::ofstream{file} << "not a session";
+    CHECK_FALSE(commands::ResumeSession(file, d));
+    std::ofstream{file, std::ios::binary} << bytes.substr(0, bytes.size() - 1);
+    CHECK_FALSE(commands::ResumeSession(file, d));
+    std::ofstream{file, std::ios::binary} << bytes << 'x';
+    CHECK_FALSE(commands::ResumeSession(file, d));
+    CHECK_EQ(nlohmann::json(d), states.back());
+    CHECK_EQ(timeline.Position(), 6);
+    std::filesystem::remove(file);
+    timeline = commands::Timeline{};
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "model/diagram.hpp"
+#include "utils/utils.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace commands {
+
+///
+/// @brief Get the session file used when none is given: ".uml_editor_session" in the home directory
+///
+[[nodiscard]] std::string DefaultSessionFile();
+
+///
+/// @brief Write the diagram and the undo history leading up to it to a session file
+///
+/// The diagram is stored in a binary layout of its own, followed by every applied command of the timeline as a delta
+/// holding the classes it changed as they were before it, so resuming neither parses JSON nor repeats commands.
+///
+/// @param file_name
+/// @param diagram the current diagram
+/// @return Error IFF the session could not be written
+///
+[[nodiscard]] Result<void> SaveSession(std::string_view file_name, model::Diagram const& diagram);
+
+///
+/// @brief Replace the diagram and the timeline with a session written by SaveSession
+///
+/// Every restored command can be undone and redone as in the original session, but is neither executed nor checked
+/// against the invariants again. The commands hold only the classes they changed rather than whole diagrams, so the
+/// states of the history before the current one cannot be listed (see Timeline::StateAt).
+///
+/// @param file_name
+/// @param diagram
+/// @return Error IFF the session could not be read, in which case neither the diagram nor the timeline is changed
+///
+[[nodiscard]] Result<void> ResumeSession(std::string_view file_name, model::Diagram& diagram);
+
+} // namespace commands
@@ -6,6 +6,8 @@
 
 #include <doctest/doctest.h>
 
+#include <format>
+
 namespace commands {
 
 [[nodiscard]] Timeline& Timeline::GetInstance() noexcept {
@@ -38,6 +40,26 @@ void Timeline::Add(std::shared_ptr<commands::Command>&& cmd) {
   }
 }
 
+std::size_t Timeline::Position() const noexcept {
+  return index_;
+}
+
+std::span<std::shared_ptr<commands::Command> const> Timeline::Applied() const noexcept {
+  return std::span{timeline_}.first(index_);
+}
+
+Result<model::Diagram const*> Timeline::StateAt(std::size_t index, model::Diagram const& live) const {
+  if (index == index_) {
+    return &live;
+  } else if (index < timeline_.size() and timeline_[index]->PriorState() != nullptr) {
+    return timeline_[index]->PriorState();
+  } else if (index > timeline_.size()) {
+    return std::unexpected{std::format("History index {} is out of range (0-{})", index, timeline_.size())};
+  } else {
+    return std::unexpected{std::format("The state at history index {} is not recorded", index)};
+  }
+}
+
 } // namespace commands
 
 DOCTEST_TEST_SUITE("commands::Timeline") {
@@ -50,12 +72,14 @@ DOCTEST_TEST_SUITE("commands::Timeline") {
         std::make_shared<commands::AddRelationshipCommand>(std::tuple{"a", "a", model::RelationshipType::Composition});
     CHECK_FALSE(timeline.Undo());
     CHECK_FALSE(timeline.Redo());
+    CHECK_EQ(timeline.Position(), 0);
 
     timeline.Add(c0);
     CHECK_FALSE(timeline.Undo());
     CHECK_FALSE(timeline.Redo());
 
     timeline.Add(c1);
+    CHECK_EQ(timeline.Position(), 1);
     CHECK_FALSE(timeline.Redo());
     auto res = timeline.Undo();
     CHECK(res);
@@ -74,10 +98,33 @@ DOCTEST_TEST_SUITE("commands::Timeline") {
 
     timeline.Add(c3);
     CHECK_FALSE(timeline.Redo());
+    REQUIRE_EQ(timeline.Applied().size(), 2);
+    CHECK_EQ(timeline.Applied().front(), c1);
+    CHECK_EQ(timeline.Applied().back(), c3);
     res = timeline.Undo();
     CHECK_EQ(res.value(), c3);
     res = timeline.Undo();
     CHECK_EQ(res.value(), c1);
     CHECK_FALSE(timeline.Undo());
   }
+  DOCTEST_TEST_CASE("commands::Timeline.StateAt") {
+    commands::Timeline timeline;
+    model::Diagram d;
+    for (auto name : {"a", "b"}) {
+      std::shared_ptr<commands::Command> cmd = std::make_shared<commands::AddClassCommand>(std::tuple{name});
+      REQUIRE(cmd->Commit(d));
+      timeline.Add(std::move(cmd));
+    }
+    CHECK_EQ(timeline.StateAt(2, d).value(), &d);
+    CHECK_EQ(timeline.StateAt(0, d).value()->GetClassNames(), std::vector<std::string>{});
+    CHECK_EQ(timeline.StateAt(1, d).value()->GetClassNames(), std::vector<std::string>{"a"});
+    CHECK_FALSE(timeline.StateAt(3, d));
+
+    REQUIRE(timeline.Undo().value()->Undo(d));
+    CHECK_EQ(timeline.StateAt(1, d).value(), &d);
+    CHECK_EQ(timeline.StateAt(0, d).value()->GetClassNames(), std::vector<std::string>{});
+    // the state after an undone command was discarded
+    CHECK_FALSE(timeline.StateAt(2, d));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"a"});
+  }
 }
@@ -3,6 +3,8 @@
 #include "commands/base_commands.hpp"
 #include "utils/utils.hpp"
 
+#include <memory>
+#include <span>
 #include <vector>
 
 namespace commands {
@@ -39,6 +41,29 @@ public:
   /// @return Error if redo cannot be performed, else the command to then invoke ->Execute() on
   ///
   [[nodiscard]] Result<std::shared_ptr<commands::Command>> Redo();
+
+  ///
+  /// @brief Get the number of commands which are currently applied
+  ///
+  [[nodiscard]] std::size_t Position() const noexcept;
+
+  ///
+  /// @brief Get the commands which are currently applied, oldest first
+  ///
+  [[nodiscard]] std::span<std::shared_ptr<commands::Command> const> Applied() const noexcept;
+
+  ///
+  /// @brief Get the diagram as it was after a number of commands in the timeline had been applied
+  ///
+  /// Every committed command holds the state it was applied to, so any point before the current position (or any
+  /// point still available to redo) is read directly from those checkpoints without touching the live diagram or
+  /// replaying history.
+  ///
+  /// @param index the number of commands applied
+  /// @param live the current diagram, which is the state at Position()
+  /// @return the diagram at that point, or an error if that point was never recorded
+  ///
+  [[nodiscard]] Result<model::Diagram const*> StateAt(std::size_t index, model::Diagram const& live) const;
 };
 
 } // namespace commands
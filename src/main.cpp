@@ -1,4 +1,5 @@
 #include "cli/readline_view.hpp"
+#include "commands/session.hpp"
 
 #define DOCTEST_CONFIG_IMPLEMENT
 #include <doctest/doctest.h>
@@ -16,11 +17,15 @@ int main(int argc, char** argv) {
   auto const args = std::ranges::to<std::vector<std::string_view>>(std::ranges::subrange{argv, argv + argc});
   if ((args.size() == 1) or (args[1] == "--cli" and args.size() == 2)) {
     return cli::CLI();
+  } else if (args[1] == "--session" and args.size() == 2) {
+    return cli::CLI(commands::DefaultSessionFile());
+  } else if (args[1] == "--resume" and args.size() == 2) {
+    return cli::CLI(commands::DefaultSessionFile(), /*resume=*/true);
   } else if constexpr (PreprocessorDefined(DOCTEST_CONFIG_DISABLE)) {
-    std::println("Usage: {} [--cli]", argv[0]);
+    std::println("Usage: {} [--cli|--session|--resume]", argv[0]);
   } else if (args[1] == "--tests") {
     return doctest::Context(argc, argv).run();
   } else {
-    std::println("Usage: {} [--cli|--tests] [test_args...]", argv[0]);
+    std::println("Usage: {} [--cli|--session|--resume|--tests] [test_args...]", argv[0]);
   }
 }
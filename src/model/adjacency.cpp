@@ -0,0 +1,106 @@
+#include "adjacency.hpp"
+
+#include "model/relationship.hpp"
+
+#include <doctest/doctest.h>
+
+#include <ranges>
+
+namespace model {
+
+static std::vector<std::string_view> Names(auto const& edges, std::string_view class_name) {
+  if (auto i = edges.find(class_name); i != edges.end()) {
+    return std::ranges::to<std::vector<std::string_view>>(i->second);
+  } else {
+    return {};
+  }
+}
+
+void Adjacency::Unlink(std::map<std::string, Neighbors, std::less<>>& edges,
+                       std::string_view from,
+                       std::string_view to) {
+  if (auto i = edges.find(from); i != edges.end()) {
+    if (auto j = i->second.find(to); j != i->second.end()) {
+      i->second.erase(j);
+    }
+    if (i->second.empty()) {
+      edges.erase(i);
+    }
+  }
+}
+
+void Adjacency::Link(std::string_view source, std::string_view destination) {
+  out_[std::string{source}].emplace(destination);
+  in_[std::string{destination}].emplace(source);
+}
+
+void Adjacency::Unlink(std::string_view source, std::string_view destination) {
+  Unlink(out_, source, destination);
+  Unlink(in_, destination, source);
+}
+
+void Adjacency::Rebuild(std::vector<Relationship> const& relationships) {
+  out_.clear();
+  in_.clear();
+  for (Relationship const& r : relationships) {
+    Link(r.Source(), r.Destination());
+  }
+}
+
+std::vector<std::string_view> Adjacency::Outgoing(std::string_view class_name) const {
+  return Names(out_, class_name);
+}
+
+std::vector<std::string_view> Adjacency::Incoming(std::string_view class_name) const {
+  return Names(in_, class_name);
+}
+
+static Adjacency::Neighbors const& Find(auto const& edges, std::string_view class_name) {
+  static Adjacency::Neighbors const none;
+  if (auto i = edges.find(class_name); i != edges.end()) {
+    return i->second;
+  } else {
+    return none;
+  }
+}
+
+Adjacency::Neighbors const& Adjacency::Successors(std::string_view class_name) const {
+  return Find(out_, class_name);
+}
+
+Adjacency::Neighbors const& Adjacency::Predecessors(std::string_view class_name) const {
+  return Find(in_, class_name);
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::Adjacency") {
+  DOCTEST_TEST_CASE("model::Adjacency.LinkUnlink") {
+    model::Adjacency adj;
+    adj.Link("a", "b");
+    adj.Link("a", "c");
+    adj.Link("c", "a");
+    CHECK_EQ(adj.Outgoing("a"), std::vector<std::string_view>{"b", "c"});
+    CHECK_EQ(adj.Incoming("a"), std::vector<std::string_view>{"c"});
+    CHECK(adj.Outgoing("b").empty());
+    CHECK_EQ(adj.Incoming("b"), std::vector<std::string_view>{"a"});
+    adj.Unlink("a", "b");
+    CHECK_EQ(adj.Outgoing("a"), std::vector<std::string_view>{"c"});
+    CHECK(adj.Incoming("b").empty());
+    adj.Unlink("a", "b");
+    CHECK(adj.Incoming("z").empty());
+    CHECK_EQ(adj.Successors("a"), model::Adjacency::Neighbors{"c"});
+    CHECK_EQ(adj.Predecessors("a"), model::Adjacency::Neighbors{"c"});
+    CHECK(adj.Successors("z").empty());
+  }
+  DOCTEST_TEST_CASE("model::Adjacency.Rebuild") {
+    std::vector<model::Relationship> rels{*model::Relationship::From("a", "b", model::RelationshipType::Inheritance),
+                                          *model::Relationship::From("b", "b", model::RelationshipType::Composition)};
+    model::Adjacency adj;
+    adj.Link("x", "y");
+    adj.Rebuild(rels);
+    CHECK(adj.Outgoing("x").empty());
+    CHECK_EQ(adj.Outgoing("b"), std::vector<std::string_view>{"b"});
+    CHECK_EQ(adj.Incoming("b"), std::vector<std::string_view>{"a", "b"});
+  }
+}
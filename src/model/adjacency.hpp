@@ -0,0 +1,83 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace model {
+
+class Relationship;
+
+///
+/// @brief Outgoing and incoming neighbor sets for every class taking part in a relationship
+///
+class Adjacency {
+public:
+  using Neighbors = std::set<std::string, std::less<>>;
+
+private:
+  std::map<std::string, Neighbors, std::less<>> out_;
+  std::map<std::string, Neighbors, std::less<>> in_;
+
+  static void Unlink(std::map<std::string, Neighbors, std::less<>>& edges, std::string_view from, std::string_view to);
+
+public:
+  ///
+  /// @brief Record an edge from source to destination
+  ///
+  /// @param source
+  /// @param destination
+  ///
+  void Link(std::string_view source, std::string_view destination);
+
+  ///
+  /// @brief Remove the edge from source to destination
+  ///
+  /// @param source
+  /// @param destination
+  ///
+  void Unlink(std::string_view source, std::string_view destination);
+
+  ///
+  /// @brief Rebuild all edges from the given relationships
+  ///
+  /// @param relationships
+  ///
+  void Rebuild(std::vector<Relationship> const& relationships);
+
+  ///
+  /// @brief Get the classes which a class has relationships to
+  ///
+  /// @param class_name
+  /// @return sorted destination names
+  ///
+  [[nodiscard]] std::vector<std::string_view> Outgoing(std::string_view class_name) const;
+
+  ///
+  /// @brief Get the classes which have relationships to a class
+  ///
+  /// @param class_name
+  /// @return sorted source names
+  ///
+  [[nodiscard]] std::vector<std::string_view> Incoming(std::string_view class_name) const;
+
+  ///
+  /// @brief Get the classes which a class has relationships to without copying them
+  ///
+  /// @param class_name
+  /// @return the destination names, valid until the adjacency is next modified
+  ///
+  [[nodiscard]] Neighbors const& Successors(std::string_view class_name) const;
+
+  ///
+  /// @brief Get the classes which have relationships to a class without copying them
+  ///
+  /// @param class_name
+  /// @return the source names, valid until the adjacency is next modified
+  ///
+  [[nodiscard]] Neighbors const& Predecessors(std::string_view class_name) const;
+};
+
+} // namespace model
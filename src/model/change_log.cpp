@@ -0,0 +1,97 @@
+#include "change_log.hpp"
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <ranges>
+#include <utility>
+
+namespace model {
+
+static std::uint64_t NextEpoch() noexcept {
+  static std::atomic<std::uint64_t> epoch{0};
+  return ++epoch;
+}
+
+ChangeLog::ChangeLog() : epoch_{NextEpoch()} {
+}
+
+ChangeLog::ChangeLog(ChangeLog const&) : ChangeLog() {
+}
+
+ChangeLog::ChangeLog(ChangeLog&&) noexcept : ChangeLog() {
+}
+
+ChangeLog& ChangeLog::operator=(ChangeLog const&) {
+  Reset();
+  return *this;
+}
+
+ChangeLog& ChangeLog::operator=(ChangeLog&&) noexcept {
+  Reset();
+  return *this;
+}
+
+void ChangeLog::Record(std::string_view class_name) {
+  ++revision_;
+  if (auto i = latest_.find(class_name); i != latest_.end()) {
+    entries_.erase(i->second);
+    i->second = revision_;
+  } else {
+    latest_.emplace(class_name, revision_);
+  }
+  entries_.emplace(revision_, class_name);
+}
+
+void ChangeLog::Reset() noexcept {
+  epoch_ = NextEpoch();
+  revision_ = 0;
+  entries_.clear();
+  latest_.clear();
+}
+
+void ChangeLog::Swap(ChangeLog& other) noexcept {
+  std::swap(epoch_, other.epoch_);
+  std::swap(revision_, other.revision_);
+  entries_.swap(other.entries_);
+  latest_.swap(other.latest_);
+}
+
+ChangeLog::Cursor ChangeLog::Now() const noexcept {
+  return {.epoch = epoch_, .revision = revision_};
+}
+
+std::optional<std::vector<std::string>> ChangeLog::Since(Cursor cursor) const {
+  if (cursor.epoch != epoch_ or cursor.revision > revision_) {
+    return std::nullopt;
+  }
+  return std::ranges::to<std::vector>(std::ranges::subrange(entries_.upper_bound(cursor.revision), entries_.end()) |
+                                      std::views::values);
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::ChangeLog") {
+  DOCTEST_TEST_CASE("model::ChangeLog.Since") {
+    model::ChangeLog log;
+    auto const start = log.Now();
+    CHECK_EQ(log.Since(start), std::vector<std::string>{});
+    log.Record("a");
+    log.Record("b");
+    auto const middle = log.Now();
+    log.Record("a");
+    CHECK_EQ(log.Since(start), std::vector<std::string>{"b", "a"});
+    CHECK_EQ(log.Since(middle), std::vector<std::string>{"a"});
+    CHECK_EQ(log.Since(log.Now()), std::vector<std::string>{});
+
+    model::ChangeLog const copy{log};
+    CHECK_FALSE(copy.Since(middle));
+    CHECK_EQ(copy.Since(copy.Now()), std::vector<std::string>{});
+    model::ChangeLog other;
+    other.Swap(log);
+    CHECK_EQ(other.Since(middle), std::vector<std::string>{"a"});
+    CHECK_FALSE(log.Since(middle));
+    other.Reset();
+    CHECK_FALSE(other.Since(middle));
+  }
+}
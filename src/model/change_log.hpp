@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace model {
+
+///
+/// @brief A record of which classes changed and in what order, used by consumers which re-examine only what changed
+///
+/// Every instance starts a new epoch: copying, moving, or resetting a log yields an empty log in a fresh epoch, so a
+/// cursor taken from one diagram state can never be mistaken for a position in another. Only Swap hands a log (and
+/// its epoch) over to another instance.
+///
+class ChangeLog {
+  std::uint64_t epoch_;
+  std::uint64_t revision_{0};
+  /// revision -> class changed at that revision (only the latest revision of each class is kept)
+  std::map<std::uint64_t, std::string> entries_;
+  /// class name -> latest revision at which it changed
+  std::map<std::string, std::uint64_t, std::less<>> latest_;
+
+public:
+  ///
+  /// @brief A position in a change log
+  ///
+  struct Cursor {
+    std::uint64_t epoch{0};
+    std::uint64_t revision{0};
+  };
+
+  ChangeLog();
+  ChangeLog(ChangeLog const&);
+  ChangeLog(ChangeLog&&) noexcept;
+  ChangeLog& operator=(ChangeLog const&);
+  ChangeLog& operator=(ChangeLog&&) noexcept;
+  ~ChangeLog() = default;
+
+  ///
+  /// @brief Record that a class (or the relationships it takes part in) changed
+  ///
+  /// @param class_name
+  ///
+  void Record(std::string_view class_name);
+
+  ///
+  /// @brief Forget every change and start a new epoch
+  ///
+  void Reset() noexcept;
+
+  ///
+  /// @brief Exchange the contents of two logs, epochs included
+  ///
+  /// @param other
+  ///
+  void Swap(ChangeLog& other) noexcept;
+
+  ///
+  /// @brief Get the current position of the log
+  ///
+  [[nodiscard]] Cursor Now() const noexcept;
+
+  ///
+  /// @brief Get the classes which changed after a position
+  ///
+  /// @param cursor a position previously returned by Now
+  /// @return the changed class names in no particular order, or nullopt if cursor belongs to a different epoch
+  ///
+  [[nodiscard]] std::optional<std::vector<std::string>> Since(Cursor cursor) const;
+};
+
+} // namespace model
@@ -5,12 +5,15 @@
 #include "model/method_signature.hpp"
 #include "model/parameter.hpp"
 #include "nlohmann/json_fwd.hpp"
+#include "utils/binary.hpp"
+#include "utils/json.hpp"
 #include "utils/utils.hpp"
 
 #include <doctest/doctest.h>
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <cstddef>
 #include <ranges>
 #include <stdexcept>
 
@@ -51,8 +54,17 @@ void to_json(nlohmann::json& json, Point const& point) {
 
 /// NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(nlohmann::json const& json, Point& point) {
-  json.at("x").get_to(point.x);
-  json.at("y").get_to(point.y);
+  if (auto res = Point::FromJson(json); res) {
+    point = *res;
+  } else {
+    throw std::invalid_argument{res.error()};
+  }
+}
+
+Result<Point> Point::FromJson(nlohmann::json const& json) {
+  return JsonMember(json, "x", JsonInteger<int>).and_then([&](int x) {
+    return JsonMember(json, "y", JsonInteger<int>).transform([&](int y) { return Point{.x = x, .y = y}; });
+  });
 }
 
 /// NOLINTNEXTLINE(readability-identifier-naming)
@@ -61,20 +73,82 @@ void to_json(nlohmann::json& json, Class const& c) {
   json["fields"] = c.fields_;
   json["methods"] = c.methods_;
   json["position"] = c.position_;
+  if (c.provenance_.Known()) {
+    json["modified"] = c.provenance_;
+  }
 }
 
 /// NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(nlohmann::json const& json, Class& c) {
-  json.at("name").get_to(c.name_);
-  if (auto res = Check<ValidType>(c.name_, "class name"); not res) {
-    throw std::invalid_argument{res.error()};
+  if (auto res = Class::FromJson(json); res) {
+    c = std::move(*res);
   } else {
-    json.at("fields").get_to(c.fields_);
-    json.at("methods").get_to(c.methods_);
-    json.at("position").get_to(c.position_);
+    throw std::invalid_argument{res.error()};
   }
 }
 
+Result<Class> Class::FromJson(nlohmann::json const& json) {
+  auto const fields = [](nlohmann::json const& value) { return JsonElements(value, Field::FromJson); };
+  auto const methods = [](nlohmann::json const& value) { return JsonElements(value, Method::FromJson); };
+  return JsonMember(json, "name", JsonString).and_then(From).and_then([&](Class c) -> Result<Class> {
+    auto res = JsonMember(json, "fields", fields)
+                   .transform([&](std::vector<Field> f) { c.fields_ = std::move(f); })
+                   .and_then([&] { return JsonMember(json, "methods", methods); })
+                   .transform([&](std::vector<Method> m) { c.methods_ = std::move(m); })
+                   .transform([&] {
+                     for (std::size_t i{0}; i < c.fields_.size(); ++i) {
+                       c.fields_[i].handle_ = c.members_.Allocate(i);
+                     }
+                     for (std::size_t i{0}; i < c.methods_.size(); ++i) {
+                       c.methods_[i].handle_ = c.members_.Allocate(i);
+                     }
+                   })
+                   .and_then([&] { return JsonMember(json, "position", Point::FromJson); })
+                   .transform([&](Point p) { c.position_ = p; })
+                   .and_then([&] { return ModifiedFromJson(json); })
+                   .transform([&](Provenance modified) { c.provenance_ = modified; });
+    if (not res) {
+      return std::unexpected{std::move(res.error())};
+    }
+    return c;
+  });
+}
+
+void Class::Encode(BinaryWriter& out) const {
+  out.String(name_);
+  out.Elements(fields_, &Field::Encode);
+  out.Elements(methods_, &Method::Encode);
+  out.Integer(position_.x);
+  out.Integer(position_.y);
+  provenance_.Encode(out);
+}
+
+Result<Class> Class::Decode(BinaryReader& in) {
+  Class c;
+  auto res = in.String()
+                 .transform([&](std::string_view name) { c.name_ = name; })
+                 .and_then([&] { return in.Elements(&Field::Decode); })
+                 .transform([&](std::vector<Field> f) { c.fields_ = std::move(f); })
+                 .and_then([&] { return in.Elements(&Method::Decode); })
+                 .transform([&](std::vector<Method> m) { c.methods_ = std::move(m); })
+                 .and_then([&] { return in.Integer<int>(); })
+                 .transform([&](int x) { c.position_.x = x; })
+                 .and_then([&] { return in.Integer<int>(); })
+                 .transform([&](int y) { c.position_.y = y; })
+                 .and_then([&] { return Provenance::Decode(in); })
+                 .transform([&](Provenance modified) { c.provenance_ = modified; });
+  if (not res) {
+    return std::unexpected{std::move(res.error())};
+  }
+  for (std::size_t i{0}; i < c.fields_.size(); ++i) {
+    c.fields_[i].handle_ = c.members_.Allocate(i);
+  }
+  for (std::size_t i{0}; i < c.methods_.size(); ++i) {
+    c.methods_[i].handle_ = c.members_.Allocate(i);
+  }
+  return c;
+}
+
 Result<Class> Class::From(std::string_view name) {
   return Check<ValidType>(name, "class name").transform([&] {
     Class c;
@@ -166,11 +240,99 @@ Result<std::vector<Method>::const_iterator> Class::GetReadOnlyMethod(Method cons
   });
 }
 
+///
+/// @brief Point the handles of members at their places within their container, from a position onwards
+///
+/// @param members
+/// @param container the fields or the methods, after some of them moved
+/// @param first the first position which may have changed
+///
+static void PlaceMembers(HandleTable& members, auto const& container, std::size_t first = 0) noexcept {
+  for (std::size_t i{first}; i < container.size(); ++i) {
+    members.Place(container[i].GetHandle(), i);
+  }
+}
+
+///
+/// @brief Sort members, keeping their handles pointed at them
+///
+/// @param members
+/// @param container the fields or the methods
+///
+static void SortMembers(HandleTable& members, auto& container) {
+  std::ranges::sort(container);
+  PlaceMembers(members, container);
+}
+
+///
+/// @brief Erase a member, releasing its handle and keeping the handles of the members after it pointed at them
+///
+/// @param members
+/// @param container the fields or the methods
+/// @param member
+///
+static void EraseMember(HandleTable& members, auto& container, auto member) {
+  members.Release(member->GetHandle());
+  auto const first = static_cast<std::size_t>(container.erase(member) - container.begin());
+  PlaceMembers(members, container, first);
+}
+
+///
+/// @brief Find the member a handle refers to in constant time
+///
+/// @param members
+/// @param container the fields or the methods (a handle of the other kind is not found)
+/// @param handle
+/// @return the member, or the end of the container if the handle no longer refers to one of its members
+///
+static auto FindMember(HandleTable const& members, auto& container, Handle handle) {
+  if (auto const position = members.Position(handle);
+      position and *position < container.size() and container[*position].GetHandle() == handle) {
+    return container.begin() + static_cast<std::ptrdiff_t>(*position);
+  } else {
+    return container.end();
+  }
+}
+
+Result<std::vector<Field>::iterator> Class::GetField(Handle handle) {
+  if (auto i = FindMember(members_, fields_, handle); i != fields_.end()) {
+    return i;
+  } else {
+    return std::unexpected{"field no longer exists"};
+  }
+}
+
+Result<std::vector<Field>::const_iterator> Class::GetReadOnlyField(Handle handle) const {
+  if (auto i = FindMember(members_, fields_, handle); i != fields_.end()) {
+    return i;
+  } else {
+    return std::unexpected{"field no longer exists"};
+  }
+}
+
+Result<std::vector<Method>::iterator> Class::GetMethod(Handle handle) {
+  if (auto i = FindMember(members_, methods_, handle); i != methods_.end()) {
+    return i;
+  } else {
+    return std::unexpected{"method no longer exists"};
+  }
+}
+
+Result<std::vector<Method>::const_iterator> Class::GetReadOnlyMethod(Handle handle) const {
+  if (auto i = FindMember(members_, methods_, handle); i != methods_.end()) {
+    return i;
+  } else {
+    return std::unexpected{"method no longer exists"};
+  }
+}
+
 Result<void> Class::AddField(std::string_view field_name, std::string_view field_type) {
   if (not GetField(field_name)) {
     return Field::From(field_name, field_type).transform([&](Field f) {
+      f.MarkModified();
+      f.handle_ = members_.Allocate();
       fields_.push_back(std::move(f));
-      std::ranges::sort(fields_);
+      SortMembers(members_, fields_);
     });
   } else {
     return std::unexpected{"the new field already exists"};
@@ -178,13 +340,13 @@ Result<void> Class::AddField(std::string_view field_name, std::string_view field
 }
 
 Result<void> Class::DeleteField(std::string_view field_name) {
-  return GetField(field_name).transform([&](auto f) { fields_.erase(f); });
+  return GetField(field_name).transform([&](auto f) { EraseMember(members_, fields_, f); });
 }
 
 Result<void> Class::RenameField(std::string_view field_name, std::string_view new_name) {
   return GetField(field_name).and_then([&](auto f) -> Result<void> {
     if (not GetField(new_name)) {
-      return f->Rename(new_name).transform([&] { std::ranges::sort(fields_); });
+      return f->Rename(new_name).transform([&] { SortMembers(members_, fields_); });
     } else {
       return std::unexpected{"the new field name is already in use"};
     }
@@ -194,8 +356,10 @@ Result<void> Class::RenameField(std::string_view field_name, std::string_view ne
 Result<void> Class::AddMethod(std::string_view name, std::string_view return_type, std::vector<Parameter> parameters) {
   return Method::From(name, return_type, std::move(parameters)).and_then([&](Method method) -> Result<void> {
     if (not GetMethod(method)) {
+      method.MarkModified();
+      method.handle_ = members_.Allocate();
       methods_.push_back(std::move(method));
-      std::ranges::sort(methods_);
+      SortMembers(members_, methods_);
       return {};
     } else {
       return std::unexpected{"a method with the signature already exists"};
@@ -204,13 +368,13 @@ Result<void> Class::AddMethod(std::string_view name, std::string_view return_typ
 }
 
 Result<void> Class::DeleteMethod(MethodSignature const& method_signature) {
-  return GetMethodFromSignature(method_signature).transform([&](auto m) { methods_.erase(m); });
+  return GetMethodFromSignature(method_signature).transform([&](auto m) { EraseMember(members_, methods_, m); });
 }
 
 Result<void> Class::RenameMethod(MethodSignature const& method_signature, std::string_view new_name) {
   return GetMethodFromSignature(method_signature).and_then([&](auto m) -> Result<void> {
     if (not GetMethodFromSignature(method_signature.WithName(new_name))) {
-      return m->Rename(new_name).transform([&] { std::ranges::sort(methods_); });
+      return m->Rename(new_name).transform([&] { SortMembers(members_, methods_); });
     } else {
       return std::unexpected{"a method with the new signature already exists"};
     }
@@ -222,7 +386,7 @@ Result<void> Class::ChangeParameters(MethodSignature const& method_signature, st
       .and_then([&] { return GetMethodFromSignature(method_signature); })
       .and_then([&](auto m) -> Result<void> {
         if (not GetMethodFromSignature(method_signature.WithParameters(parameters))) {
-          return m->ChangeParameters(parameters).transform([&] { std::ranges::sort(methods_); });
+          return m->ChangeParameters(parameters).transform([&] { SortMembers(members_, methods_); });
         } else {
           return std::unexpected{"a method with the new signature already exists"};
         }
@@ -234,7 +398,7 @@ Result<void> Class::AddParameter(MethodSignature const& method_signature,
                                  std::string_view parameter_type) {
   return GetMethodFromSignature(method_signature).and_then([&](auto m) -> Result<void> {
     if (not GetMethodFromSignature(method_signature.WithAddedParameter(parameter_type))) {
-      return m->AddParameter(parameter_name, parameter_type).transform([&] { std::ranges::sort(methods_); });
+      return m->AddParameter(parameter_name, parameter_type).transform([&] { SortMembers(members_, methods_); });
     } else {
       return std::unexpected{"a method with the new signature already exists"};
     }
@@ -245,7 +409,7 @@ Result<void> Class::DeleteParameter(MethodSignature const& method_signature, std
   return GetMethodFromSignature(method_signature).and_then([&](auto m) {
     return m->GetParameter(parameter_name).and_then([&](auto p) -> Result<void> {
       if (not GetMethodFromSignature(method_signature.WithoutParameter(m->GetParameterIndex(p)))) {
-        return m->RemoveParameter(p).transform([&] { std::ranges::sort(methods_); });
+        return m->RemoveParameter(p).transform([&] { SortMembers(members_, methods_); });
       } else {
         return std::unexpected{"a method with the new signature already exists"};
       }
@@ -256,7 +420,7 @@ Result<void> Class::DeleteParameter(MethodSignature const& method_signature, std
 Result<void> Class::DeleteParameters(MethodSignature const& method_signature) {
   return GetMethodFromSignature(method_signature).and_then([&](auto m) -> Result<void> {
     if (not GetMethodFromSignature(method_signature.WithParameters())) {
-      return m->ClearParameters().transform([&] { std::ranges::sort(methods_); });
+      return m->ClearParameters().transform([&] { SortMembers(members_, methods_); });
     } else {
       return std::unexpected{"a method with the new signature already exists"};
     }
@@ -269,7 +433,10 @@ Result<void> Class::ChangeParameterType(MethodSignature const& method_signature,
   return GetMethodFromSignature(method_signature).and_then([&](auto m) {
     return m->GetParameter(parameter_name).and_then([&](auto p) -> Result<void> {
       if (not GetMethodFromSignature(method_signature.WithParameterType(m->GetParameterIndex(p), new_type))) {
-        return p->ChangeType(new_type).transform([&] { std::ranges::sort(methods_); });
+        return p->ChangeType(new_type).transform([&] {
+          m->Share();
+          SortMembers(members_, methods_);
+        });
       } else {
         return std::unexpected{"a method with the new signature already exists"};
       }
@@ -282,6 +449,29 @@ void Class::Move(int new_x, int new_y) {
   position_.y = new_y;
 }
 
+void Class::Share() {
+  std::ranges::for_each(fields_, &Field::Share);
+  std::ranges::for_each(methods_, &Method::Share);
+}
+
+void Class::ShrinkToFit() {
+  name_.shrink_to_fit();
+  fields_.shrink_to_fit();
+  methods_.shrink_to_fit();
+}
+
+Provenance const& Class::LastModified() const noexcept {
+  return provenance_;
+}
+
+Handle Class::GetHandle() const noexcept {
+  return handle_;
+}
+
+void Class::MarkModified() noexcept {
+  ProvenanceScope::Mark(provenance_);
+}
+
 std::strong_ordering Class::operator<=>(Class const& other) const noexcept {
   return name_ <=> other.name_;
 }
@@ -509,6 +699,41 @@ DOCTEST_TEST_SUITE("model::Class") {
     CHECK_EQ((*i)->ReturnType(), "str");
     CHECK_EQ((*i)->Parameters().size(), 2);
   }
+  DOCTEST_TEST_CASE("model::Class.Handles") {
+    model::Class c;
+    REQUIRE(c.AddField("b", "int"));
+    REQUIRE(c.AddMethod("f", "void", {}));
+    auto const b = c.Fields()[0].GetHandle();
+    auto const f = c.Methods()[0].GetHandle();
+    CHECK_NE(b, f);
+
+    // handles survive the re-sorting caused by unrelated additions and renames of the member itself
+    REQUIRE(c.AddField("a", "str"));
+    REQUIRE(c.RenameField("b", "c"));
+    REQUIRE(c.AddMethod("e", "void", {}));
+    REQUIRE(c.AddParameter(model::MethodSignature{"f", {}}, "x", "int"));
+    REQUIRE(c.GetReadOnlyField(b));
+    CHECK_EQ(c.GetReadOnlyField(b).value()->Name(), "c");
+    REQUIRE(c.GetMethod(f));
+    CHECK_EQ(c.GetMethod(f).value()->ToSignatureString(), "f(int)");
+    CHECK_FALSE(c.GetReadOnlyMethod(b));
+
+    // a copy of the class resolves the same handles
+    model::Class const copy{c};
+    CHECK(copy.GetReadOnlyField(b));
+
+    // erasing a member moves the ones after it, and their handles follow
+    REQUIRE(c.DeleteField("a"));
+    REQUIRE(c.GetReadOnlyField(b));
+    CHECK_EQ(c.GetReadOnlyField(b).value()->Name(), "c");
+
+    REQUIRE(c.DeleteField("c"));
+    REQUIRE(c.DeleteMethod(model::MethodSignature{"f", {"int"}}));
+    CHECK_FALSE(c.GetField(b));
+    CHECK_FALSE(c.GetReadOnlyMethod(f));
+    REQUIRE(c.AddField("c", "int"));
+    CHECK_FALSE(c.GetReadOnlyField(b));
+  }
   DOCTEST_TEST_CASE("model::Class.GetMethodFromSignature") {
     model::Class c;
     REQUIRE(c.AddMethod("f", "void", {}));
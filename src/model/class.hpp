@@ -1,8 +1,10 @@
 #pragma once
 
 #include "model/field.hpp"
+#include "model/handles.hpp"
 #include "model/method.hpp"
 #include "model/method_signature.hpp"
+#include "model/provenance.hpp"
 
 #include <nlohmann/json_fwd.hpp>
 
@@ -13,6 +15,9 @@
 #include <string>
 #include <vector>
 
+class BinaryReader;
+class BinaryWriter;
+
 namespace model {
 
 ///
@@ -28,6 +33,14 @@ struct Point {
   friend void from_json(nlohmann::json const&, Point&);
   // NOLINTEND(readability-identifier-naming)
 
+  ///
+  /// @brief Create a point from its JSON representation without throwing
+  ///
+  /// @param json
+  /// @return error if either coordinate is missing or not an integer
+  ///
+  [[nodiscard]] static Result<Point> FromJson(nlohmann::json const& json);
+
   constexpr auto operator<=>(Point const&) const noexcept = default;
 };
 
@@ -36,11 +49,17 @@ class Class {
   std::vector<Field> fields_;
   std::vector<Method> methods_;
   Point position_{};
+  Provenance provenance_;
+  /// allocated by the diagram the class belongs to
+  Handle handle_;
+  /// the slots behind the handles of the fields and methods
+  HandleTable members_;
 
   // NOLINTBEGIN(readability-identifier-naming)
   friend void to_json(nlohmann::json&, Class const&);
   friend void from_json(nlohmann::json const&, Class&);
   // NOLINTEND(readability-identifier-naming)
+  friend class Diagram;
 
 public:
   ///
@@ -51,6 +70,29 @@ public:
   ///
   [[nodiscard]] static Result<Class> From(std::string_view name);
 
+  ///
+  /// @brief Create a class from its JSON representation without throwing
+  ///
+  /// @param json
+  /// @return error (prefixed by the location of the offending value) if the JSON is malformed or validation failed
+  ///
+  [[nodiscard]] static Result<Class> FromJson(nlohmann::json const& json);
+
+  ///
+  /// @brief Append the class to a binary buffer, to be read back by Decode
+  ///
+  /// @param out
+  ///
+  void Encode(BinaryWriter& out) const;
+
+  ///
+  /// @brief Read a class written by Encode, taking it as it was written rather than validating it again
+  ///
+  /// @param in
+  /// @return error if the buffer is truncated or corrupt
+  ///
+  [[nodiscard]] static Result<Class> Decode(BinaryReader& in);
+
   [[nodiscard]] std::string const& Name() const noexcept;
   [[nodiscard]] std::vector<Field> const& Fields() const noexcept;
   [[nodiscard]] std::vector<Method> const& Methods() const noexcept;
@@ -84,6 +126,22 @@ public:
   ///
   [[nodiscard]] Result<std::vector<model::Field>::const_iterator> GetReadOnlyField(std::string_view field_name) const;
 
+  ///
+  /// @brief Get an iterator to a field from its handle
+  ///
+  /// @param handle
+  /// @return error if the field no longer belongs to the class
+  ///
+  [[nodiscard]] Result<std::vector<model::Field>::iterator> GetField(Handle handle);
+
+  ///
+  /// @brief Get an iterator to a field from its handle
+  ///
+  /// @param handle
+  /// @return error if the field no longer belongs to the class
+  ///
+  [[nodiscard]] Result<std::vector<model::Field>::const_iterator> GetReadOnlyField(Handle handle) const;
+
   ///
   /// @brief Get an iterator to a method
   ///
@@ -118,6 +176,22 @@ public:
   ///
   [[nodiscard]] Result<std::vector<model::Method>::const_iterator> GetReadOnlyMethod(Method const& method) const;
 
+  ///
+  /// @brief Get an iterator to a method from its handle, which survives changes to the method's signature
+  ///
+  /// @param handle
+  /// @return error if the method no longer belongs to the class
+  ///
+  [[nodiscard]] Result<std::vector<model::Method>::iterator> GetMethod(Handle handle);
+
+  ///
+  /// @brief Get an iterator to a method from its handle, which survives changes to the method's signature
+  ///
+  /// @param handle
+  /// @return error if the method no longer belongs to the class
+  ///
+  [[nodiscard]] Result<std::vector<model::Method>::const_iterator> GetReadOnlyMethod(Handle handle) const;
+
   ///
   /// @brief Add a field
   ///
@@ -230,6 +304,31 @@ public:
   /// @param new_y
   ///
   void Move(int new_x, int new_y);
+
+  ///
+  /// @brief Share the storage of every field and method with identical ones (no-op unless hash-consing is enabled)
+  ///
+  void Share();
+
+  ///
+  /// @brief Release the spare capacity of the class's name and member vectors
+  ///
+  void ShrinkToFit();
+
+  ///
+  /// @brief Get the command which last modified the class (or any of its members)
+  ///
+  [[nodiscard]] Provenance const& LastModified() const noexcept;
+
+  ///
+  /// @brief Get the handle of the class, which stays valid while the class belongs to its diagram (even if renamed)
+  ///
+  [[nodiscard]] Handle GetHandle() const noexcept;
+
+  ///
+  /// @brief Record the active command (if any) as the last to modify the class (or any of its members)
+  ///
+  void MarkModified() noexcept;
 };
 
 } // namespace model
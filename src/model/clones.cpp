@@ -0,0 +1,202 @@
+#include "clones.hpp"
+
+#include "model/class.hpp"
+#include "model/field.hpp"
+#include "model/method.hpp"
+#include "utils/parallel.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ranges>
+#include <set>
+#include <span>
+#include <unordered_map>
+
+namespace model {
+
+constexpr static std::size_t SignatureSize{64};
+constexpr static std::size_t BandRows{4};
+constexpr static std::size_t Bands{SignatureSize / BandRows};
+
+///
+/// @brief splitmix64 finalizer: a cheap bijective mixer used for every hash in this file
+///
+static constexpr std::uint64_t Mix(std::uint64_t x) noexcept {
+  x ^= x >> 30U;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27U;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31U;
+  return x;
+}
+
+static constexpr std::uint64_t Combine(std::uint64_t seed, std::uint64_t value) noexcept {
+  return Mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6U) + (seed >> 2U)));
+}
+
+///
+/// @brief Hash every member of a class into a sorted set
+///
+/// Fields are identified by name and type; methods by name, parameter types, and return type (parameter names do
+/// not contribute to structure).
+///
+static std::vector<std::uint64_t> Features(Class const& cls) {
+  std::hash<std::string> const hasher;
+  std::vector<std::uint64_t> features;
+  features.reserve(cls.Fields().size() + cls.Methods().size());
+  for (Field const& f : cls.Fields()) {
+    features.push_back(Mix(hasher(std::format("f {}:{}", f.Name(), f.Type()))));
+  }
+  for (Method const& m : cls.Methods()) {
+    features.push_back(Mix(hasher(std::format("m {}->{}", m.ToSignatureString(), m.ReturnType()))));
+  }
+  std::ranges::sort(features);
+  auto const dups = std::ranges::unique(features);
+  features.erase(dups.begin(), dups.end());
+  return features;
+}
+
+static std::array<std::uint64_t, SignatureSize> MinHash(std::vector<std::uint64_t> const& features) {
+  std::array<std::uint64_t, SignatureSize> signature;
+  signature.fill(std::numeric_limits<std::uint64_t>::max());
+  for (std::uint64_t feature : features) {
+    for (std::size_t k{0}; k < SignatureSize; ++k) {
+      signature[k] = std::min(signature[k], Mix(feature ^ Mix(k + 1)));
+    }
+  }
+  return signature;
+}
+
+static double Jaccard(std::vector<std::uint64_t> const& a, std::vector<std::uint64_t> const& b) {
+  std::size_t common{0};
+  for (auto i = a.begin(), j = b.begin(); i != a.end() and j != b.end();) {
+    if (*i < *j) {
+      ++i;
+    } else if (*j < *i) {
+      ++j;
+    } else {
+      ++common;
+      ++i;
+      ++j;
+    }
+  }
+  return static_cast<double>(common) / static_cast<double>(a.size() + b.size() - common);
+}
+
+CloneReport FindClones(Live<Class> const& classes, double threshold) {
+  std::vector<std::vector<std::uint64_t>> features(classes.size());
+  ParallelFor(classes.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+    for (std::size_t i{begin}; i < end; ++i) {
+      features[i] = Features(classes[i]);
+    }
+  });
+
+  // exact clones: group by the hash of the member set, then split each bucket by actual equality
+  std::unordered_map<std::uint64_t, std::vector<std::vector<std::size_t>>> buckets;
+  for (std::size_t i{0}; i < classes.size(); ++i) {
+    if (features[i].empty()) {
+      continue;
+    }
+    auto& groups = buckets[std::ranges::fold_left(features[i], std::uint64_t{0}, Combine)];
+    auto const members_of = [&](std::vector<std::size_t> const& g) -> auto const& { return features[g.front()]; };
+    if (auto group = std::ranges::find(groups, features[i], members_of); group != groups.end()) {
+      group->push_back(i);
+    } else {
+      groups.push_back({i});
+    }
+  }
+
+  CloneReport report;
+  // a single representative of each distinct member set takes part in near-clone detection
+  std::vector<std::size_t> representatives;
+  for (auto const& groups : std::views::values(buckets)) {
+    for (auto const& group : groups) {
+      representatives.push_back(group.front());
+      if (group.size() > 1) {
+        auto const name_of = [&](std::size_t i) { return classes[i].Name(); };
+        report.identical.push_back(std::ranges::to<std::vector>(std::views::transform(group, name_of)));
+      }
+    }
+  }
+  std::ranges::sort(report.identical);
+  std::ranges::sort(representatives);
+
+  // near clones: MinHash signatures bucketed by LSH bands yield candidate pairs, which are then verified
+  std::vector<std::array<std::uint64_t, SignatureSize>> signatures(representatives.size());
+  ParallelFor(representatives.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+    for (std::size_t i{begin}; i < end; ++i) {
+      signatures[i] = MinHash(features[representatives[i]]);
+    }
+  });
+  std::set<std::pair<std::size_t, std::size_t>> candidates;
+  for (std::size_t band{0}; band < Bands; ++band) {
+    std::unordered_map<std::uint64_t, std::vector<std::size_t>> band_buckets;
+    for (std::size_t i{0}; i < signatures.size(); ++i) {
+      auto const rows = std::span{signatures[i]}.subspan(band * BandRows, BandRows);
+      band_buckets[std::ranges::fold_left(rows, Mix(band + 1), Combine)].push_back(i);
+    }
+    for (auto const& members : std::views::values(band_buckets)) {
+      for (std::size_t x{0}; x < members.size(); ++x) {
+        for (std::size_t y{x + 1}; y < members.size(); ++y) {
+          candidates.emplace(members[x], members[y]);
+        }
+      }
+    }
+  }
+  for (auto [x, y] : candidates) {
+    std::size_t const a{representatives[x]};
+    std::size_t const b{representatives[y]};
+    if (double const similarity{Jaccard(features[a], features[b])}; similarity >= threshold) {
+      report.similar.push_back(NearClone{classes[a].Name(), classes[b].Name(), similarity});
+    }
+  }
+  return report;
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::Clones") {
+  DOCTEST_TEST_CASE("model::FindClones") {
+    std::vector<model::Class> classes;
+    for (auto name : {"A", "B", "C", "D", "E", "F"}) {
+      classes.push_back(*model::Class::From(name));
+    }
+    for (std::size_t i : {0ZU, 1ZU, 3ZU}) {
+      REQUIRE(classes[i].AddField("x", "int"));
+      REQUIRE(classes[i].AddMethod("f", "void", {*model::Parameter::From("a", "int")}));
+    }
+    // parameter names do not affect structure
+    REQUIRE(classes[2].AddField("x", "int"));
+    REQUIRE(classes[2].AddMethod("f", "void", {*model::Parameter::From("b", "int")}));
+    // E shares 9 of 10 members with F
+    for (int i{0}; i < 9; ++i) {
+      REQUIRE(classes[4].AddField(std::format("m{}", i), "int"));
+      REQUIRE(classes[5].AddField(std::format("m{}", i), "int"));
+    }
+    REQUIRE(classes[5].AddField("extra", "int"));
+
+    auto const report = model::FindClones(model::Live<model::Class>{classes});
+    REQUIRE_EQ(report.identical.size(), 1);
+    CHECK_EQ(report.identical[0], std::vector<std::string>{"A", "B", "C", "D"});
+    REQUIRE_EQ(report.similar.size(), 1);
+    CHECK_EQ(report.similar[0].first, "E");
+    CHECK_EQ(report.similar[0].second, "F");
+    CHECK_EQ(report.similar[0].similarity, doctest::Approx(0.9));
+
+    CHECK(model::FindClones(model::Live<model::Class>{classes}, 0.95).similar.empty());
+    CHECK_EQ(std::format("{}", report), "identical: A, B, C, D\nsimilar (90%): E ~ F\n");
+  }
+  DOCTEST_TEST_CASE("model::FindClones.Empty") {
+    std::vector<model::Class> classes;
+    classes.push_back(*model::Class::From("A"));
+    classes.push_back(*model::Class::From("B"));
+    auto const report = model::FindClones(model::Live<model::Class>{classes});
+    CHECK(report.identical.empty());
+    CHECK(report.similar.empty());
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "model/live.hpp"
+
+#include <format>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace model {
+
+class Class;
+
+///
+/// @brief Two classes whose structures overlap without being identical
+///
+struct NearClone {
+  std::string first;
+  std::string second;
+  /// Jaccard similarity of the two member sets in (0, 1)
+  double similarity;
+};
+
+struct CloneReport {
+  /// groups (of at least two classes) having identical member sets
+  std::vector<std::vector<std::string>> identical;
+  /// pairs of classes which are similar but not identical
+  std::vector<NearClone> similar;
+};
+
+///
+/// @brief Find classes with identical or near-identical structure
+///
+/// A class's structure is the set of its fields (name and type) and methods (name, parameter types, and return type).
+/// Identical structures are grouped by hashing the normalized member set. Near-identical structures are found with
+/// MinHash signatures bucketed by LSH banding and then verified, so the cost stays near-linear in the number of
+/// classes. Classes without members are ignored.
+///
+/// @param classes the classes to examine
+/// @param threshold the minimum similarity for two classes to be reported as similar
+/// @return the clone groups and similar pairs, ordered by class name
+///
+[[nodiscard]] CloneReport FindClones(Live<Class> const& classes, double threshold = 0.8);
+
+} // namespace model
+
+template <> struct std::formatter<model::CloneReport> {
+  template <typename FormatParseContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  constexpr inline auto parse(FormatParseContext& ctx) {
+    return ctx.begin();
+  }
+  template <typename FormatContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  auto format(model::CloneReport const& obj, FormatContext& ctx) const {
+    for (auto const& group : obj.identical) {
+      ctx.advance_to(std::format_to(ctx.out(), "identical:"));
+      for (char const* sep = " "; auto const& name : group) {
+        ctx.advance_to(std::format_to(ctx.out(), "{}{}", std::exchange(sep, ", "), name));
+      }
+      ctx.advance_to(std::format_to(ctx.out(), "\n"));
+    }
+    for (auto const& pair : obj.similar) {
+      ctx.advance_to(
+          std::format_to(ctx.out(), "similar ({:.0f}%): {} ~ {}\n", pair.similarity * 100, pair.first, pair.second));
+    }
+    return ctx.out();
+  }
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "model/class.hpp"
+#include "model/relationship.hpp"
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace model {
+
+///
+/// @brief The state of every class changed by an edit, taken after the edit, which can be applied to the state before
+///        it to reproduce the edit without repeating it
+///
+struct Delta {
+  /// class name -> the class after the edit, or nullopt if no class of that name exists after it
+  std::map<std::string, std::optional<Class>, std::less<>> classes;
+  /// every relationship taking part in one of the changed classes after the edit, sorted
+  std::vector<Relationship> relationships;
+};
+
+} // namespace model
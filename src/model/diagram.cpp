@@ -4,6 +4,13 @@
 #include "model/class.hpp"
 #include "model/relationship.hpp"
 #include "model/relationship_type.hpp"
+#include "utils/binary.hpp"
+#include "utils/compression.hpp"
+#include "utils/file_io.hpp"
+#include "utils/json.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/parallel.hpp"
+#include "utils/settings.hpp"
 #include "utils/utils.hpp"
 
 #include <doctest/doctest.h>
@@ -13,61 +20,236 @@
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <iterator>
+#include <optional>
 #include <ranges>
+#include <set>
+#include <span>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
 
 namespace model {
 
 // NOLINTNEXTLINE(readability-identifier-naming)
 void to_json(nlohmann ::json& json, const Diagram& d) {
-  json["classes"] = d.GetClasses();
-  json["relationships"] = d.GetRelationships();
+  auto const classes = d.GetClasses();
+  auto const relationships = d.GetRelationships();
+  json["classes"] = nlohmann::json::array_t(classes.begin(), classes.end());
+  json["relationships"] = nlohmann::json::array_t(relationships.begin(), relationships.end());
 }
 
 // NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(const nlohmann ::json& json, Diagram& d) {
-  json.at("classes").get_to(d.classes_);
-  json.at("relationships").get_to(d.relationships_);
-  auto res = Unique(d.classes_, "class")
-                 .and_then([&] { return Unique(d.relationships_, "relationship"); })
-                 .and_then([&]() -> Result<Diagram> {
-                   std::vector<std::string> rel_classes;
-                   {
-                     rel_classes.reserve(d.relationships_.size() * 2);
-                     auto i = std::back_inserter(rel_classes);
-                     i = std::ranges::transform(d.relationships_, i, &Relationship::Source).out;
-                     std::ranges::transform(d.relationships_, i, &Relationship::Destination);
-                     std::ranges::sort(rel_classes);
-                     auto dups = std::ranges::unique(rel_classes);
-                     rel_classes.erase(dups.begin(), dups.end());
-                   }
-                   if (not std::ranges::includes(d.classes_, rel_classes, {}, &Class::Name)) {
-                     return std::unexpected{"Relationship(s) contain nonexistent class(es)"};
-                   } else {
-                     return {};
+  if (auto res = Diagram::FromJson(json); res) {
+    d = std::move(*res);
+  } else {
+    throw std::invalid_argument{res.error()};
+  }
+}
+
+/// the number of errors in a malformed diagram which are reported individually
+constexpr static std::size_t MaxReportedErrors{10};
+
+Result<Diagram> Diagram::FromJson(nlohmann::json const& json) {
+  Diagram d;
+  // every malformed entity is reported rather than just the first
+  std::vector<std::string> errors;
+  auto const collect = [&](std::string_view key, auto convert, auto& into) {
+    auto const elements = JsonMember(json, key, JsonArray);
+    if (not elements) {
+      errors.push_back(elements.error());
+      return;
+    }
+    into.reserve((*elements)->size());
+    for (std::size_t i{0}; i < (*elements)->size(); ++i) {
+      if (auto entity = convert((**elements)[i]); entity) {
+        into.push_back(std::move(*entity));
+      } else {
+        errors.push_back(Within(std::format(".{}[{}]", key, i), entity.error()));
+      }
+    }
+  };
+  collect("classes", Class::FromJson, d.classes_);
+  collect("relationships", Relationship::FromJson, d.relationships_);
+  if (not errors.empty()) {
+    std::string message{std::format("{} error(s) in diagram:", errors.size())};
+    for (std::string const& error : errors | std::views::take(MaxReportedErrors)) {
+      message.append(std::format("\n  {}", error));
+    }
+    if (errors.size() > MaxReportedErrors) {
+      message.append(std::format("\n  ... and {} more", errors.size() - MaxReportedErrors));
+    }
+    return std::unexpected{std::move(message)};
+  }
+  std::ranges::sort(d.classes_);
+  std::ranges::sort(d.relationships_);
+  return d.Index().transform([&] { return std::move(d); });
+}
+
+void Diagram::Encode(BinaryWriter& out) const {
+  out.Elements(GetClasses(), &Class::Encode);
+  out.Elements(GetRelationships(), &Relationship::Encode);
+}
+
+Result<Diagram> Diagram::Decode(BinaryReader& in) {
+  Diagram d;
+  auto res = in.Elements(&Class::Decode)
+                 .transform([&](std::vector<Class> c) { d.classes_ = std::move(c); })
+                 .and_then([&] { return in.Elements(&Relationship::Decode); })
+                 .transform([&](std::vector<Relationship> r) { d.relationships_ = std::move(r); })
+                 .and_then([&]() -> Result<void> {
+                   // written sorted, so anything else is corrupt
+                   if (not std::ranges::is_sorted(d.classes_) or not std::ranges::is_sorted(d.relationships_)) {
+                     return std::unexpected{"classes or relationships are out of order"};
                    }
+                   return d.Index();
                  });
   if (not res) {
-    throw std::invalid_argument{res.error()};
+    return std::unexpected{std::move(res.error())};
   }
+  return d;
 }
 
-Result<std::vector<Class>::iterator> Diagram::GetClass(std::string_view name) {
-  return Check<ValidType>(name, "class name").and_then([&]() -> Result<std::vector<Class>::iterator> {
-    if (auto i = std::ranges::find(classes_, name, &Class::Name); i != classes_.end()) {
-      return i;
-    } else {
-      return std::unexpected{std::format("class '{}' does not exist", name)};
+Result<void> Diagram::Index() {
+  return Unique(classes_, "class")
+      .and_then([&] { return Unique(relationships_, "relationship"); })
+      .and_then([&]() -> Result<void> {
+        std::vector<std::string> rel_classes;
+        {
+          rel_classes.reserve(relationships_.size() * 2);
+          auto i = std::back_inserter(rel_classes);
+          i = std::ranges::transform(relationships_, i, &Relationship::Source).out;
+          std::ranges::transform(relationships_, i, &Relationship::Destination);
+          std::ranges::sort(rel_classes);
+          auto dups = std::ranges::unique(rel_classes);
+          rel_classes.erase(dups.begin(), dups.end());
+        }
+        if (not std::ranges::includes(classes_, rel_classes, {}, &Class::Name)) {
+          return std::unexpected{"Relationship(s) contain nonexistent class(es)"};
+        } else {
+          return {};
+        }
+      })
+      .transform([&] {
+        type_index_.Reset(classes_);
+        name_index_.Reset(classes_);
+        adjacency_.Rebuild(relationships_);
+        changes_.Reset();
+        AllocateHandles();
+      });
+}
+
+static auto Endpoints(Relationship const& r) {
+  return std::pair<std::string_view, std::string_view>{r.Source(), r.Destination()};
+}
+
+static auto FindRelationship(auto& relationships, auto const& dead, std::string_view src, std::string_view dst) {
+  auto const key = std::pair{src, dst};
+  if (auto i = std::ranges::lower_bound(relationships, key, std::less{}, Endpoints);
+      i != relationships.end() and Endpoints(*i) == key and
+      (dead.empty() or not dead.contains(std::pair<std::string, std::string>{key}))) {
+    return i;
+  } else {
+    return relationships.end();
+  }
+}
+
+static auto FindClass(auto& classes, auto const& dead, std::string_view name) {
+  if (auto i = std::ranges::lower_bound(classes, name, {}, &Class::Name);
+      i != classes.end() and i->Name() == name and not dead.contains(name)) {
+    return i;
+  } else {
+    return classes.end();
+  }
+}
+
+void Diagram::Touch(std::string_view name) {
+  type_index_.Invalidate(name);
+  name_index_.Invalidate(name);
+  changes_.Record(name);
+}
+
+void Diagram::Sweep() {
+  if (not dead_classes_.empty()) {
+    std::erase_if(classes_, [&](Class const& c) { return dead_classes_.contains(c.Name()); });
+    dead_classes_.clear();
+    PlaceHandles();
+  }
+  if (not dead_relationships_.empty()) {
+    std::erase_if(relationships_, [&](Relationship const& r) {
+      return dead_relationships_.contains(std::pair{r.Source(), r.Destination()});
+    });
+    dead_relationships_.clear();
+  }
+}
+
+void Diagram::SweepIfSparse() {
+  if (dead_classes_.size() * 2 > classes_.size() or dead_relationships_.size() * 2 > relationships_.size()) {
+    Sweep();
+  }
+}
+
+void Diagram::Insert(Class c) {
+  if (auto i = std::ranges::lower_bound(classes_, c); i != classes_.end() and i->Name() == c.Name()) {
+    dead_classes_.erase(c.Name());
+    *i = std::move(c);
+    handles_.Place(i->GetHandle(), static_cast<std::size_t>(i - classes_.begin()));
+  } else {
+    // inserting may reallocate, so the position is only taken from the iterator it returns
+    auto const inserted = classes_.insert(i, std::move(c));
+    PlaceHandles(static_cast<std::size_t>(inserted - classes_.begin()));
+  }
+}
+
+void Diagram::Insert(Relationship r) {
+  if (auto i = std::ranges::lower_bound(relationships_, r);
+      i != relationships_.end() and Endpoints(*i) == Endpoints(r)) {
+    dead_relationships_.erase(std::pair{r.Source(), r.Destination()});
+    *i = std::move(r);
+  } else {
+    relationships_.insert(i, std::move(r));
+  }
+}
+
+void Diagram::Bury(std::string_view source, std::string_view destination) {
+  dead_relationships_.emplace(source, destination);
+  adjacency_.Unlink(source, destination);
+}
+
+void Diagram::AllocateHandles() {
+  handles_.Clear();
+  for (std::size_t i{0}; i < classes_.size(); ++i) {
+    classes_[i].handle_ = handles_.Allocate(i);
+  }
+}
+
+void Diagram::PlaceHandles(std::size_t first) {
+  for (std::size_t i{first}; i < classes_.size(); ++i) {
+    // a deleted class may still hold the handle of the class it was renamed to
+    if (dead_classes_.empty() or not dead_classes_.contains(classes_[i].Name())) {
+      handles_.Place(classes_[i].GetHandle(), i);
     }
+  }
+}
+
+Result<void> Diagram::EditClass(std::string_view name, std::function<Result<void>(Class&)> const& edit) {
+  return std::as_const(*this).GetClass(name).and_then([&](auto found) {
+    auto const i = classes_.begin() + (found - classes_.cbegin());
+    return edit(*i).transform([&] {
+      i->MarkModified();
+      Touch(name);
+    });
   });
 }
 
 Result<std::vector<Class>::const_iterator> Diagram::GetClass(std::string_view name) const {
   return Check<ValidType>(name, "class name").and_then([&]() -> Result<std::vector<Class>::const_iterator> {
-    if (auto i = std::ranges::find(classes_, name, &Class::Name); i != classes_.end()) {
+    if (auto i = FindClass(classes_, dead_classes_, name); i != classes_.end()) {
       return i;
     } else {
       return std::unexpected{std::format("class '{}' does not exist", name)};
@@ -75,16 +257,30 @@ Result<std::vector<Class>::const_iterator> Diagram::GetClass(std::string_view na
   });
 }
 
-Result<std::vector<Relationship>::iterator> Diagram::GetRelationship(std::string_view src, std::string_view dst) {
-  return Check<ValidType>(src, "class name").and_then([&] {
-    return Check<ValidType>(dst, "class name").and_then([&]() -> Result<std::vector<Relationship>::iterator> {
-      if (auto i = std::ranges::find_if(
-              relationships_, [&](Relationship const& r) { return (r.Source() == src) and (r.Destination() == dst); });
-          i != relationships_.end()) {
-        return i;
-      } else {
-        return std::unexpected{std::format("relationship between '{}' and '{}' does not exist", src, dst)};
-      }
+Result<std::vector<Class>::const_iterator> Diagram::GetClass(Handle handle) const {
+  if (auto position = handles_.Position(handle); position and *position < classes_.size()) {
+    return classes_.cbegin() + static_cast<std::ptrdiff_t>(*position);
+  } else {
+    return std::unexpected{"class no longer exists"};
+  }
+}
+
+Result<Handle> Diagram::GetHandle(std::string_view name) const {
+  return GetClass(name).transform([](auto c) { return c->GetHandle(); });
+}
+
+bool Diagram::Valid(Handle handle) const noexcept {
+  return handles_.Valid(handle);
+}
+
+Result<void> Diagram::EditRelationship(std::string_view src,
+                                       std::string_view dst,
+                                       std::function<Result<void>(Relationship&)> const& edit) {
+  return GetReadOnlyRelationship(src, dst).and_then([&](auto found) {
+    // relationships stamp themselves when they are modified
+    return edit(relationships_[found - relationships_.cbegin()]).transform([&] {
+      changes_.Record(src);
+      changes_.Record(dst);
     });
   });
 }
@@ -93,9 +289,7 @@ Result<std::vector<Relationship>::const_iterator> Diagram::GetReadOnlyRelationsh
                                                                                    std::string_view dst) const {
   return Check<ValidType>(src, "class name").and_then([&] {
     return Check<ValidType>(dst, "class name").and_then([&]() -> Result<std::vector<Relationship>::const_iterator> {
-      if (auto i = std::ranges::find_if(
-              relationships_, [&](Relationship const& r) { return (r.Source() == src) and (r.Destination() == dst); });
-          i != relationships_.end()) {
+      if (auto i = FindRelationship(relationships_, dead_relationships_, src, dst); i != relationships_.end()) {
         return i;
       } else {
         return std::unexpected{std::format("relationship between '{}' and '{}' does not exist", src, dst)};
@@ -110,33 +304,79 @@ Diagram& Diagram::GetInstance() noexcept {
 }
 
 Result<void> Diagram::AddClass(std::string_view name) {
-  if (not GetClass(name)) {
-    return Class::From(name).transform([&](Class c) { classes_.push_back(std::move(c)); });
+  if (not std::as_const(*this).GetClass(name)) {
+    return Class::From(name).transform([&](Class c) {
+      c.MarkModified();
+      c.handle_ = handles_.Allocate();
+      Insert(std::move(c));
+      Touch(name);
+      type_index_.Reclassify(name);
+    });
   } else {
     return std::unexpected(std::format("Class '{}' cannot be added because it already exists", name));
   }
 }
 
 Result<void> Diagram::DeleteClass(std::string_view name) {
-  return GetClass(name).transform([&](auto c) {
-    std::erase_if(relationships_, [&](Relationship const& r) { return r.Source() == name or r.Destination() == name; });
-    classes_.erase(c);
+  return std::as_const(*this).GetClass(name).transform([&](auto c) {
+    Touch(name);
+    for (std::string const& dst : std::ranges::to<std::vector<std::string>>(adjacency_.Outgoing(name))) {
+      Bury(name, dst);
+      changes_.Record(dst);
+    }
+    for (std::string const& src : std::ranges::to<std::vector<std::string>>(adjacency_.Incoming(name))) {
+      Bury(src, name);
+      changes_.Record(src);
+    }
+    type_index_.Erase(name);
+    type_index_.Reclassify(name);
+    name_index_.Erase(name);
+    handles_.Release(c->GetHandle());
+    dead_classes_.emplace(c->Name());
+    SweepIfSparse();
   });
 }
 
 Result<void> Diagram::RenameClass(std::string_view old_name, std::string_view new_name) {
-  return GetClass(old_name).and_then([&](auto c) -> Result<void> {
-    if (not GetClass(new_name)) {
+  return std::as_const(*this).GetClass(old_name).and_then([&](auto&&) -> Result<void> {
+    if (not std::as_const(*this).GetClass(new_name)) {
+      // old_name may refer to the class being renamed, so keep a copy
+      std::string const old{old_name};
+      // sweeping first means re-sorting cannot leave a deleted class beside a live one of the same name
+      Sweep();
+      auto const c = FindClass(classes_, dead_classes_, old);
       return c->Rename(new_name).transform([&] {
+        c->MarkModified();
         std::ranges::sort(classes_);
+        PlaceHandles();
         for (Relationship& r : relationships_) {
-          if (r.Source() == old_name) {
+          if (r.Source() == old) {
             std::ignore = r.ChangeSource(new_name);
           }
-          if (r.Destination() == old_name) {
+          if (r.Destination() == old) {
             std::ignore = r.ChangeDestination(new_name);
           }
         }
+        std::ranges::sort(relationships_);
+        auto const outgoing = std::ranges::to<std::vector<std::string>>(adjacency_.Outgoing(old));
+        auto const incoming = std::ranges::to<std::vector<std::string>>(adjacency_.Incoming(old));
+        for (std::string const& dst : outgoing) {
+          adjacency_.Unlink(old, dst);
+          adjacency_.Link(new_name, dst == old ? new_name : std::string_view{dst});
+          changes_.Record(dst);
+        }
+        for (std::string const& src : incoming) {
+          adjacency_.Unlink(src, old);
+          adjacency_.Link(src == old ? new_name : std::string_view{src}, new_name);
+          changes_.Record(src);
+        }
+        // the old name is gone, which the change log must know for undo, redo and the incremental checks
+        Touch(old);
+        type_index_.Erase(old);
+        type_index_.Reclassify(old);
+        type_index_.Reclassify(new_name);
+        name_index_.Erase(old);
+        Touch(new_name);
       });
     } else {
       return std::unexpected{"the new class already exists"};
@@ -145,28 +385,49 @@ Result<void> Diagram::RenameClass(std::string_view old_name, std::string_view ne
 }
 
 Result<void> Diagram::AddRelationship(std::string_view source, std::string_view destination, RelationshipType type) {
-  return GetClass(source).and_then([&](auto&&) { return GetClass(destination); }).and_then([&](auto&&) -> Result<void> {
-    if (not GetRelationship(source, destination)) {
-      return Relationship::From(source, destination, type).transform([&](Relationship r) {
-        relationships_.push_back(std::move(r));
-        std::ranges::sort(relationships_);
+  auto const& self = *this;
+  return self.GetClass(source)
+      .and_then([&](auto&&) { return self.GetClass(destination); })
+      .and_then([&](auto&&) -> Result<void> {
+        if (not GetReadOnlyRelationship(source, destination)) {
+          return Relationship::From(source, destination, type).transform([&](Relationship r) {
+            r.MarkModified();
+            Insert(std::move(r));
+            adjacency_.Link(source, destination);
+            changes_.Record(source);
+            changes_.Record(destination);
+          });
+        } else {
+          return std::unexpected{"Cannot add relationship because it already exists"};
+        }
       });
-    } else {
-      return std::unexpected{"Cannot add relationship because it already exists"};
-    }
-  });
 }
 
 Result<void> Diagram::DeleteRelationship(std::string_view source, std::string_view destination) {
-  return GetRelationship(source, destination).transform([&](auto r) { relationships_.erase(r); });
+  return GetReadOnlyRelationship(source, destination).transform([&](auto) {
+    changes_.Record(source);
+    changes_.Record(destination);
+    Bury(source, destination);
+    SweepIfSparse();
+  });
 }
 
 Result<void>
 Diagram::ChangeRelationshipSource(std::string_view source, std::string_view destination, std::string_view new_source) {
-  return GetRelationship(source, destination).and_then([&](auto r) -> Result<void> {
-    if (not GetRelationship(new_source, destination)) {
-      return GetClass(new_source).and_then([&](auto&&) {
-        return r->ChangeSource(new_source).transform([&] { std::ranges::sort(relationships_); });
+  return GetReadOnlyRelationship(source, destination).and_then([&](auto&&) -> Result<void> {
+    if (not GetReadOnlyRelationship(new_source, destination)) {
+      return std::as_const(*this).GetClass(new_source).and_then([&](auto&&) {
+        // sweeping first means re-sorting cannot leave a deleted relationship beside a live one with the same ends
+        Sweep();
+        auto const r = FindRelationship(relationships_, dead_relationships_, source, destination);
+        return r->ChangeSource(new_source).transform([&] {
+          std::ranges::sort(relationships_);
+          adjacency_.Unlink(source, destination);
+          adjacency_.Link(new_source, destination);
+          changes_.Record(source);
+          changes_.Record(destination);
+          changes_.Record(new_source);
+        });
       });
     } else {
       return std::unexpected{std::format("a relationship between {} and {} already exists", new_source, destination)};
@@ -177,10 +438,20 @@ Diagram::ChangeRelationshipSource(std::string_view source, std::string_view dest
 Result<void> Diagram::ChangeRelationshipDestination(std::string_view source,
                                                     std::string_view destination,
                                                     std::string_view new_destination) {
-  return GetRelationship(source, destination).and_then([&](auto r) -> Result<void> {
-    if (not GetRelationship(source, new_destination)) {
-      return GetClass(new_destination).and_then([&](auto&&) {
-        return r->ChangeDestination(new_destination).transform([&] { std::ranges::sort(relationships_); });
+  return GetReadOnlyRelationship(source, destination).and_then([&](auto&&) -> Result<void> {
+    if (not GetReadOnlyRelationship(source, new_destination)) {
+      return std::as_const(*this).GetClass(new_destination).and_then([&](auto&&) {
+        // sweeping first means re-sorting cannot leave a deleted relationship beside a live one with the same ends
+        Sweep();
+        auto const r = FindRelationship(relationships_, dead_relationships_, source, destination);
+        return r->ChangeDestination(new_destination).transform([&] {
+          std::ranges::sort(relationships_);
+          adjacency_.Unlink(source, destination);
+          adjacency_.Link(source, new_destination);
+          changes_.Record(source);
+          changes_.Record(destination);
+          changes_.Record(new_destination);
+        });
       });
     } else {
       return std::unexpected{std::format("a relationship between {} and {} already exists", source, new_destination)};
@@ -189,44 +460,393 @@ Result<void> Diagram::ChangeRelationshipDestination(std::string_view source,
 }
 
 Result<void> Diagram::Load(std::string_view file_name) {
-  try {
-    std::filesystem::path file{file_name};
-    std::filesystem::path const resolved = std::filesystem::absolute(file);
-    std::ifstream ifs{resolved};
-    nlohmann::from_json(nlohmann::json::parse(ifs), *this);
-    return {};
-  } catch (std::exception const& e) {
-    return std::unexpected{std::format("Error: {}", e.what())};
+  std::error_code ec;
+  std::filesystem::path const resolved = std::filesystem::absolute(std::filesystem::path{file_name}, ec);
+  auto const cannot_read = std::unexpected{std::format("Error: Cannot read file \"{}\"", file_name)};
+  if (ec) {
+    return cannot_read;
   }
+  // regular files are parsed straight from their mapped pages; anything else (e.g. a pipe) is read first
+  auto const mapped = MappedFile::Open(resolved.string());
+  Result<std::string> read;
+  if (not mapped) {
+    read = ReadFile(resolved.string());
+    if (not read) {
+      return cannot_read;
+    }
+  }
+  auto const parse = [&]() -> Result<nlohmann::json> {
+    std::string_view const contents{mapped ? mapped->Contents() : *read};
+    if (resolved.extension() != CompressedExtension) {
+      return ParseJson(contents);
+    }
+    return Decompress(contents).and_then([](std::string const& json) { return ParseJson(std::string_view{json}); });
+  };
+  // parse into a fresh diagram so that a failed load leaves this one untouched
+  return parse()
+      .and_then(&Diagram::FromJson)
+      .transform([&](Diagram loaded) { std::swap(*this, loaded); })
+      .transform_error([](std::string&& error) { return std::format("Error: {}", error); });
+}
+
+/// the number of elements serialized together before their text is handed on to be written
+constexpr static std::size_t SavedPerSlice{1 << 14};
+
+///
+/// @brief Emit a member of the top-level object holding an array, laid out as nlohmann::json::dump(2) would
+///
+/// The array is serialized a slice at a time, each slice in one buffer per chunk, each chunk on its own thread. Every
+/// slice is emitted as soon as it is serialized, so it can be written while the next one is.
+///
+/// @param emit invoked with the buffers of each part of the member in order
+/// @param key the name of the member
+/// @param elements
+/// @param last whether the member closes the object
+///
+template <typename T, std::invocable<std::vector<std::string>> Emit>
+static void EmitArrayMember(Emit const& emit, std::string_view key, Live<T> const& elements, bool last) {
+  if (elements.empty()) {
+    emit({std::format("  \"{}\": []{}\n", key, last ? "" : ",")});
+    return;
+  }
+  std::vector<std::string> buffers{std::format("  \"{}\": [\n", key)};
+  for (std::size_t first{0}; first < elements.size(); first += SavedPerSlice) {
+    std::size_t const count{std::min(SavedPerSlice, elements.size() - first)};
+    std::size_t const offset{buffers.size()};
+    buffers.resize(offset + ChunkCount(count));
+    ParallelFor(count, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+      std::string& out = buffers[offset + chunk];
+      for (std::size_t i{first + begin}; i < first + end; ++i) {
+        out.append(i == 0 ? "    " : ",\n    ");
+        // escaped strings hold no line breaks, so every one of them starts a line nested in the array
+        nlohmann::json const element = elements[i];
+        for (char const ch : element.dump(2, ' ', /*ensure_ascii=*/true, nlohmann::json::error_handler_t::replace)) {
+          out.push_back(ch);
+          if (ch == '\n') {
+            out.append("    ");
+          }
+        }
+      }
+    });
+    emit(std::exchange(buffers, {}));
+  }
+  emit({last ? "\n  ]\n" : "\n  ],\n"});
 }
 
 Result<void> Diagram::Save(std::string_view file_name) {
-  try {
-    std::filesystem::path file{file_name};
-    std::filesystem::path const resolved = std::filesystem::absolute(file);
-    std::ofstream ofs{resolved};
-    nlohmann::json as_json = *this;
-    ofs << as_json.dump(/*indent=*/2, /*indent_char=*/' ', /*ensure_ascii=*/true);
-    if (not ofs.good()) {
-      throw std::runtime_error{std::format("Cannot write file \"{}\"", resolved.string())};
+  std::error_code ec;
+  std::filesystem::path const resolved = std::filesystem::absolute(std::filesystem::path{file_name}, ec);
+  if (ec) {
+    return std::unexpected{std::format("Error: Cannot write file \"{}\"", file_name)};
+  }
+  return FileWriter::Create(resolved.string())
+      .and_then([&](FileWriter writer) {
+        // the same document as to_json, but serialized in parallel and written without joining the pieces, each part
+        // while the next one is serialized (unless it has to be compressed as a whole first)
+        bool const compressed{resolved.extension() == CompressedExtension};
+        std::string document;
+        auto const emit = [&](std::vector<std::string> buffers) {
+          for (std::string& buffer : buffers) {
+            if (compressed) {
+              document += buffer;
+            } else {
+              writer.Write(std::move(buffer));
+            }
+          }
+          writer.Submit();
+        };
+        emit({"{\n"});
+        EmitArrayMember(emit, "classes", GetClasses(), /*last=*/false);
+        EmitArrayMember(emit, "relationships", GetRelationships(), /*last=*/true);
+        emit({"}"});
+        if (compressed) {
+          for (std::string& block : Compress(document)) {
+            writer.Write(std::move(block));
+          }
+        }
+        return writer.Finish();
+      })
+      .transform_error([](std::string&& error) { return std::format("Error: {}", error); });
+}
+
+Result<void> Diagram::LoadPositions(std::string_view file_name) {
+  auto const contents = ReadFile(file_name);
+  if (not contents) {
+    return std::unexpected{std::format("Error: {}", contents.error())};
+  }
+  struct Placement {
+    std::string name;
+    Point position;
+  };
+  std::vector<Placement> placements;
+  std::size_t number{0};
+  for (auto const line : std::views::split(*contents, '\n')) {
+    ++number;
+    auto const words = Split(std::string_view{line});
+    if (words.empty() or words.front().starts_with('#')) {
+      continue;
     }
-    ofs.close();
-    return {};
-  } catch (std::exception const& e) {
-    return std::unexpected{std::format("Error: {}", e.what())};
+    auto placement = [&]() -> Result<Placement> {
+      if (words.size() != 3) {
+        return std::unexpected{"expected \"class_name x y\""};
+      }
+      return std::as_const(*this).GetClass(words[0]).and_then([&](auto) {
+        return IntFromString(words[1]).and_then([&](int x) {
+          return IntFromString(words[2]).transform([&](int y) {
+            return Placement{.name = std::string{words[0]}, .position = {.x = x, .y = y}};
+          });
+        });
+      });
+    }();
+    if (not placement) {
+      return std::unexpected{std::format("Error: line {}: {}", number, placement.error())};
+    }
+    placements.push_back(std::move(*placement));
+  }
+  // positions take part in no index, so moving a class only needs to be recorded as a change
+  for (auto const& [name, position] : placements) {
+    auto const i = FindClass(classes_, dead_classes_, name);
+    i->Move(position.x, position.y);
+    i->MarkModified();
+    changes_.Record(name);
   }
+  return {};
+}
+
+Result<void> Diagram::SavePositions(std::string_view file_name) const {
+  std::string positions;
+  for (Class const& c : GetClasses()) {
+    std::format_to(std::back_inserter(positions), "{} {} {}\n", c.Name(), c.Position().x, c.Position().y);
+  }
+  return WriteBuffers(file_name, std::span{&positions, 1}).transform_error([](std::string&& error) {
+    return std::format("Error: {}", error);
+  });
+}
+
+Result<Diagram> Diagram::Extract(std::string_view class_name, std::size_t hops, bool with_types) const {
+  return GetClass(class_name).transform([&](auto center) {
+    // names are views of the strings held by classes_ and adjacency_, which this function does not modify
+    std::set<std::string_view> extracted{center->Name()};
+    std::vector<std::string_view> frontier{center->Name()};
+    for (std::size_t hop{0}; hop < hops and not frontier.empty(); ++hop) {
+      std::vector<std::string_view> next;
+      for (std::string_view name : frontier) {
+        for (auto const* neighbors : {&adjacency_.Successors(name), &adjacency_.Predecessors(name)}) {
+          for (std::string const& neighbor : *neighbors) {
+            if (extracted.emplace(neighbor).second) {
+              next.push_back(neighbor);
+            }
+          }
+        }
+      }
+      frontier = std::move(next);
+    }
+    if (with_types) {
+      for (std::string_view name : std::ranges::to<std::vector>(extracted)) {
+        for (std::string_view type : TypesOf(*FindClass(classes_, dead_classes_, name))) {
+          for (std::string_view identifier : TypeIdentifiers(type)) {
+            if (auto c = FindClass(classes_, dead_classes_, identifier); c != classes_.end()) {
+              extracted.emplace(c->Name());
+            }
+          }
+        }
+      }
+    }
+    Diagram sub;
+    for (std::string_view name : extracted) {
+      sub.classes_.push_back(*FindClass(classes_, dead_classes_, name));
+    }
+    // visiting sources and then destinations in order keeps the relationships sorted
+    for (std::string_view name : extracted) {
+      for (std::string const& dst : adjacency_.Successors(name)) {
+        if (extracted.contains(dst)) {
+          sub.relationships_.push_back(*FindRelationship(relationships_, dead_relationships_, name, dst));
+        }
+      }
+    }
+    sub.type_index_.Reset(sub.classes_);
+    sub.name_index_.Reset(sub.classes_);
+    sub.adjacency_.Rebuild(sub.relationships_);
+    sub.AllocateHandles();
+    return sub;
+  });
 }
 
 std::vector<std::string> Diagram::GetClassNames() const {
-  return std::ranges::to<std::vector>(std::views::transform(classes_, &Class::Name));
+  return std::ranges::to<std::vector>(std::views::transform(GetClasses(), &Class::Name));
+}
+
+Live<Class> Diagram::GetClasses() const {
+  if (dead_classes_.empty()) {
+    return Live<Class>{classes_};
+  }
+  return {classes_, [&](Class const& c) { return dead_classes_.contains(c.Name()); }};
+}
+
+Live<Relationship> Diagram::GetRelationships() const {
+  if (dead_relationships_.empty()) {
+    return Live<Relationship>{relationships_};
+  }
+  return {relationships_, [&](Relationship const& r) {
+            return dead_relationships_.contains(std::pair{r.Source(), r.Destination()});
+          }};
+}
+
+void Diagram::RefreshIndexes() {
+  // the indexes look classes up in storage, which must not hold deleted ones
+  Sweep();
+  if (auto const& builtins = Settings::GetInstance().Builtins();
+      type_index_.Stale() or type_index_.Builtins() != builtins) {
+    type_index_.Refresh(classes_, builtins);
+  }
+  if (name_index_.Stale()) {
+    name_index_.Refresh(classes_);
+  }
+}
+
+TypeIndex const& Diagram::GetTypeIndex() {
+  RefreshIndexes();
+  return type_index_;
+}
+
+TypeIndex const& Diagram::GetTypeIndex() const noexcept {
+  return type_index_;
+}
+
+NameIndex const& Diagram::GetNameIndex() {
+  RefreshIndexes();
+  return name_index_;
+}
+
+NameIndex const& Diagram::GetNameIndex() const noexcept {
+  return name_index_;
+}
+
+Adjacency const& Diagram::GetAdjacency() const noexcept {
+  return adjacency_;
+}
+
+std::optional<Delta> Diagram::DeltaSince(ChangeLog::Cursor since) const {
+  return changes_.Since(since).transform([&](std::vector<std::string> const& changed) { return Capture(changed); });
+}
+
+Delta Diagram::Capture(std::span<std::string const> class_names) const {
+  Delta delta;
+  for (std::string const& name : class_names) {
+    auto const c = FindClass(classes_, dead_classes_, name);
+    delta.classes.emplace(name, c == classes_.end() ? std::optional<Class>{} : std::optional<Class>{*c});
+    for (std::string_view dst : adjacency_.Outgoing(name)) {
+      delta.relationships.push_back(*FindRelationship(relationships_, dead_relationships_, name, dst));
+    }
+    for (std::string_view src : adjacency_.Incoming(name)) {
+      delta.relationships.push_back(*FindRelationship(relationships_, dead_relationships_, src, name));
+    }
+  }
+  std::ranges::sort(delta.relationships);
+  auto const dups = std::ranges::unique(delta.relationships);
+  delta.relationships.erase(dups.begin(), dups.end());
+  return delta;
+}
+
+void Diagram::Apply(Delta const& delta) {
+  // every relationship of a changed class is either gone after the edit or part of the delta
+  for (std::string const& name : std::views::keys(delta.classes)) {
+    for (std::string const& dst : std::ranges::to<std::vector<std::string>>(adjacency_.Outgoing(name))) {
+      Bury(name, dst);
+      changes_.Record(dst);
+    }
+    for (std::string const& src : std::ranges::to<std::vector<std::string>>(adjacency_.Incoming(name))) {
+      Bury(src, name);
+      changes_.Record(src);
+    }
+  }
+  // a renamed class appears under both names with one handle, which only the class it points at may release
+  auto const release = [&](std::vector<Class>::iterator c) {
+    if (handles_.Position(c->GetHandle()) == static_cast<std::size_t>(c - classes_.begin())) {
+      handles_.Release(c->GetHandle());
+    }
+  };
+  // classes are buried first, so a renamed class gives up its handle before the class under its other name takes it
+  for (auto const& [name, cls] : delta.classes) {
+    if (auto i = FindClass(classes_, dead_classes_, name); i != classes_.end() and not cls) {
+      release(i);
+      dead_classes_.emplace(name);
+    }
+  }
+  for (auto const& [name, cls] : delta.classes) {
+    if (auto i = FindClass(classes_, dead_classes_, name); i != classes_.end() and cls) {
+      // a class without a handle (e.g. read from a file) takes over the handle of the class it replaces
+      Handle const handle{cls->GetHandle() == Handle{} ? i->GetHandle() : cls->GetHandle()};
+      if (i->GetHandle() != handle) {
+        release(i);
+      }
+      *i = *cls;
+      i->handle_ = handle;
+      handles_.Restore(handle, static_cast<std::size_t>(i - classes_.begin()));
+    } else if (cls) {
+      Class added{*cls};
+      if (added.handle_ == Handle{}) {
+        added.handle_ = handles_.Allocate();
+      } else {
+        // Insert places it
+        handles_.Restore(added.handle_);
+      }
+      Insert(std::move(added));
+    }
+    Touch(name);
+    type_index_.Reclassify(name);
+  }
+  for (Relationship const& r : delta.relationships) {
+    Insert(r);
+    adjacency_.Link(r.Source(), r.Destination());
+    changes_.Record(r.Source());
+    changes_.Record(r.Destination());
+  }
+  SweepIfSparse();
 }
 
-std::vector<Class> const& Diagram::GetClasses() const noexcept {
-  return classes_;
+void Diagram::Restore(Diagram const& state, std::span<std::string const> changed) {
+  ChangeLog log;
+  log.Swap(changes_);
+  *this = state;
+  changes_.Swap(log);
+  for (std::string const& name : changed) {
+    changes_.Record(name);
+  }
 }
 
-std::vector<Relationship> const& Diagram::GetRelationships() const noexcept {
-  return relationships_;
+ChangeLog const& Diagram::GetChangeLog() const noexcept {
+  return changes_;
+}
+
+void Diagram::Share() {
+  Sweep();
+  std::ranges::for_each(classes_, &Class::Share);
+}
+
+void Diagram::Compact() {
+  Sweep();
+  classes_.shrink_to_fit();
+  relationships_.shrink_to_fit();
+  std::ranges::for_each(classes_, &Class::ShrinkToFit);
+  std::ranges::for_each(relationships_, &Relationship::ShrinkToFit);
+}
+
+std::string Diagram::RenderClasses() const {
+  auto const classes = GetClasses();
+  std::vector<std::string> buffers(ChunkCount(classes.size()));
+  ParallelFor(classes.size(), [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+    auto out = std::back_inserter(buffers[chunk]);
+    for (std::size_t i{begin}; i < end; ++i) {
+      out = std::format_to(out, "{}\n", classes[i]);
+    }
+  });
+  std::string rendered;
+  rendered.reserve(std::ranges::fold_left(std::views::transform(buffers, &std::string::size), 0ZU, std::plus{}));
+  for (std::string const& buffer : buffers) {
+    rendered.append(buffer);
+  }
+  return rendered;
 }
 
 } // namespace model
@@ -272,6 +892,60 @@ DOCTEST_TEST_SUITE("model::Diagram") {
     CHECK_FALSE(d.GetClass("b"));
     CHECK(d.GetClasses().empty());
   }
+  DOCTEST_TEST_CASE("model::Diagram.DeleteClass.Tombstones") {
+    model::Diagram d;
+    for (auto name : {"a", "b", "c", "d", "e"}) {
+      REQUIRE(d.AddClass(name));
+    }
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    REQUIRE(d.AddRelationship("c", "b", model::RelationshipType::Composition));
+    REQUIRE(d.AddRelationship("d", "e", model::RelationshipType::Inheritance));
+    for (auto dst : {"c", "d", "e"}) {
+      REQUIRE(d.AddRelationship("a", dst, model::RelationshipType::Aggregation));
+    }
+    REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("x", "int"); }));
+
+    // deleted entities are invisible to read-only lookups before they are swept away
+    REQUIRE(d.DeleteClass("b"));
+    CHECK_FALSE(std::as_const(d).GetClass("b"));
+    CHECK_FALSE(d.GetReadOnlyRelationship("a", "b"));
+    CHECK_FALSE(d.DeleteClass("b"));
+    REQUIRE(d.DeleteRelationship("d", "e"));
+    CHECK_FALSE(d.GetReadOnlyRelationship("d", "e"));
+
+    // re-adding takes over the place of the deleted entity
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddRelationship("d", "e", model::RelationshipType::Realization));
+    CHECK(std::as_const(d).GetClass("b").value()->Fields().empty());
+    CHECK_EQ(d.GetReadOnlyRelationship("d", "e").value()->Type(), model::RelationshipType::Realization);
+
+    // renaming onto the name of a deleted class must not leave two classes of that name
+    REQUIRE(d.DeleteClass("c"));
+    REQUIRE(d.RenameClass("a", "c"));
+    CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"b", "c", "d", "e"});
+    CHECK_EQ(d.GetRelationships().size(), 3);
+
+    // a run of deletions is swept in passes rather than shifting the vector on every deletion
+    model::Diagram many;
+    constexpr int Count{1000};
+    for (int i{0}; i < Count; ++i) {
+      REQUIRE(many.AddClass(std::format("C{:04}", i)));
+    }
+    for (int i{0}; i < Count; i += 2) {
+      REQUIRE(many.DeleteClass(std::format("C{:04}", i)));
+    }
+    // reading skips the deleted classes in place, so what one reader holds stays valid while others read
+    auto const& many_const = std::as_const(many);
+    model::Class const* const first{&many_const.GetClasses().front()};
+    CHECK_EQ(many_const.GetClasses().size(), Count / 2);
+    CHECK_EQ(first->Name(), "C0001");
+    CHECK_EQ(many_const.GetClasses().back().Name(), std::format("C{:04}", Count - 1));
+    CHECK_EQ(std::ranges::distance(many_const.GetClasses()), Count / 2);
+    CHECK_EQ(&many_const.GetClasses().front(), first);
+    many.Compact();
+    CHECK_EQ(many.GetClasses().size(), Count / 2);
+    CHECK_EQ(many.GetClasses().front().Name(), "C0001");
+  }
   DOCTEST_TEST_CASE("model::Diagram.RenameClass") {
     model::Diagram d;
     REQUIRE(d.AddClass("a"));
@@ -281,7 +955,11 @@ DOCTEST_TEST_SUITE("model::Diagram") {
     std::ignore = d.AddRelationship("b", "a", model::RelationshipType::Composition);
     CHECK_FALSE(d.RenameClass(" ", "d"));
     CHECK_FALSE(d.RenameClass("a", "b"));
+    auto const cursor = d.GetChangeLog().Now();
     CHECK(d.RenameClass("a", "d"));
+    auto changed = d.GetChangeLog().Since(cursor).value();
+    std::ranges::sort(changed);
+    CHECK_EQ(changed, std::vector<std::string>{"a", "b", "d"});
     CHECK_EQ(d.GetClasses()[0].Name(), "b");
     CHECK(d.RenameClass("b", "e"));
     CHECK_EQ(d.GetClasses()[0].Name(), "c");
@@ -312,13 +990,13 @@ DOCTEST_TEST_SUITE("model::Diagram") {
     REQUIRE(d.AddClass("a"));
     REQUIRE(d.AddClass("b"));
     REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
-    CHECK_FALSE(d.GetRelationship(" ", " "));
-    CHECK_FALSE(d.GetRelationship("a", " "));
-    CHECK_FALSE(d.GetRelationship(" ", "b"));
-    CHECK_FALSE(d.GetRelationship("b", "a"));
-    CHECK_FALSE(d.GetRelationship("d", "a"));
-    CHECK_FALSE(d.GetRelationship("a", "d"));
-    auto rel = d.GetRelationship("a", "b");
+    CHECK_FALSE(d.EditRelationship(" ", " ", [](auto&&) { return Result<void>{}; }));
+    CHECK_FALSE(d.EditRelationship("a", " ", [](auto&&) { return Result<void>{}; }));
+    CHECK_FALSE(d.EditRelationship(" ", "b", [](auto&&) { return Result<void>{}; }));
+    CHECK_FALSE(d.EditRelationship("b", "a", [](auto&&) { return Result<void>{}; }));
+    CHECK_FALSE(d.EditRelationship("d", "a", [](auto&&) { return Result<void>{}; }));
+    CHECK_FALSE(d.EditRelationship("a", "d", [](auto&&) { return Result<void>{}; }));
+    auto rel = d.GetReadOnlyRelationship("a", "b");
 
     CHECK_FALSE(dc.GetReadOnlyRelationship(" ", " "));
     CHECK_FALSE(dc.GetReadOnlyRelationship("a", " "));
@@ -362,8 +1040,8 @@ DOCTEST_TEST_SUITE("model::Diagram") {
     CHECK_FALSE(d.ChangeRelationshipSource("a", "a", "b"));
     CHECK_FALSE(d.ChangeRelationshipSource("a", "a", "a"));
     CHECK(d.ChangeRelationshipSource("b", "b", "a"));
-    CHECK_FALSE(d.GetRelationship("b", "b"));
-    CHECK(d.GetRelationship("a", "b"));
+    CHECK_FALSE(d.GetReadOnlyRelationship("b", "b"));
+    CHECK(d.GetReadOnlyRelationship("a", "b"));
   }
   DOCTEST_TEST_CASE("model::Diagram.ChangeRelationshipDestination") {
     model::Diagram d;
@@ -380,8 +1058,8 @@ DOCTEST_TEST_SUITE("model::Diagram") {
     CHECK_FALSE(d.ChangeRelationshipDestination("b", "b", "b"));
     CHECK_FALSE(d.ChangeRelationshipDestination("a", "a", "b"));
     CHECK(d.ChangeRelationshipDestination("b", "b", "a"));
-    CHECK_FALSE(d.GetRelationship("b", "b"));
-    CHECK(d.GetRelationship("b", "a"));
+    CHECK_FALSE(d.GetReadOnlyRelationship("b", "b"));
+    CHECK(d.GetReadOnlyRelationship("b", "a"));
   }
   DOCTEST_TEST_CASE("model::Diagram.GetClassNames") {
     model::Diagram d;
@@ -389,6 +1067,155 @@ DOCTEST_TEST_SUITE("model::Diagram") {
     REQUIRE(d.AddClass("b"));
     CHECK_EQ(d.GetClassNames(), std::vector<std::string>{"a", "b"});
   }
+  DOCTEST_TEST_CASE("model::Diagram.GetTypeIndex") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "b"); }));
+    CHECK_EQ(d.GetTypeIndex().UsersOf("b"), std::vector<std::string>{"a"});
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.DeleteField("x"); }));
+    CHECK(d.GetTypeIndex().UsersOf("b").empty());
+    REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("y", "int"); }));
+    REQUIRE(d.RenameClass("b", "c"));
+    CHECK_EQ(d.GetTypeIndex().UsersOf("int"), std::vector<std::string>{"c"});
+    REQUIRE(d.DeleteClass("c"));
+    CHECK(d.GetTypeIndex().UsersOf("int").empty());
+    // reading through a const reference leaves the index as it was until the owner refreshes it
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("z", "int"); }));
+    CHECK(std::as_const(d).GetTypeIndex().UsersOf("int").empty());
+    d.RefreshIndexes();
+    CHECK_EQ(std::as_const(d).GetTypeIndex().UsersOf("int"), std::vector<std::string>{"a"});
+  }
+  DOCTEST_TEST_CASE("model::Diagram.GetTypeIndex.Unresolved") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "vector<b>"); }));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("y", "int"); }));
+    CHECK_EQ(d.GetTypeIndex().Unresolved(), std::set<std::string, std::less<>>{"b"});
+    REQUIRE(d.AddClass("b"));
+    CHECK(d.GetTypeIndex().Unresolved().empty());
+    REQUIRE(d.RenameClass("b", "c"));
+    CHECK_EQ(d.GetTypeIndex().Unresolved(), std::set<std::string, std::less<>>{"b"});
+    REQUIRE(d.RenameClass("c", "b"));
+    CHECK(d.GetTypeIndex().Unresolved().empty());
+    REQUIRE(d.DeleteClass("b"));
+    CHECK_EQ(d.GetTypeIndex().Unresolved(), std::set<std::string, std::less<>>{"b"});
+    REQUIRE(d.DeleteClass("a"));
+    CHECK(d.GetTypeIndex().Unresolved().empty());
+  }
+  DOCTEST_TEST_CASE("model::Diagram.Provenance") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    {
+      model::ProvenanceScope const scope{{.step = 1, .command = "class add"}};
+      REQUIRE(d.AddClass("b"));
+      REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    }
+    {
+      model::ProvenanceScope const scope{{.step = 2, .command = "field add"}};
+      REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("x", "int"); }));
+      REQUIRE(d.EditClass("b", [](model::Class& c) { return c.AddField("y", "int"); }));
+    }
+    {
+      model::ProvenanceScope const scope{{.step = 3, .command = "field rename"}};
+      REQUIRE(d.EditClass("b", [](model::Class& c) { return c.RenameField("y", "z"); }));
+    }
+    {
+      // a failed edit stamps nothing, and neither does a read-only one
+      model::ProvenanceScope const scope{{.step = 4, .command = "field rename"}};
+      auto const before = d.GetChangeLog().Now();
+      CHECK_FALSE(d.EditClass("b", [](model::Class& c) { return c.RenameField("missing", "w"); }));
+      CHECK_FALSE(d.EditRelationship("a", "b", [](model::Relationship&) -> Result<void> {
+        return std::unexpected{"rejected"};
+      }));
+      CHECK(d.GetChangeLog().Since(before).value().empty());
+    }
+    model::Provenance const added{1, "class add"};
+    model::Provenance const field_added{2, "field add"};
+    model::Provenance const renamed{3, "field rename"};
+    auto const& b = **std::as_const(d).GetClass("b");
+    CHECK_FALSE(std::as_const(d).GetClass("a").value()->LastModified().Known());
+    CHECK_EQ(b.LastModified(), renamed);
+    CHECK_EQ(b.Fields()[0].LastModified(), field_added);
+    CHECK_EQ(b.Fields()[1].LastModified(), renamed);
+    CHECK_EQ(d.GetRelationships()[0].LastModified(), added);
+
+    // provenance survives saving and loading
+    nlohmann::json const json = d;
+    model::Diagram loaded;
+    REQUIRE_NOTHROW(loaded = json);
+    auto const& c = **std::as_const(loaded).GetClass("b");
+    CHECK_EQ(c.LastModified(), renamed);
+    CHECK_EQ(c.Fields()[0].LastModified(), field_added);
+    CHECK_EQ(loaded.GetRelationships()[0].LastModified(), added);
+    CHECK_FALSE(json.at("classes").at(0).contains("modified"));
+  }
+  DOCTEST_TEST_CASE("model::Diagram.Extract") {
+    model::Diagram d;
+    for (auto name : {"a", "b", "c", "d", "e"}) {
+      REQUIRE(d.AddClass(name));
+    }
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    REQUIRE(d.AddRelationship("c", "b", model::RelationshipType::Composition));
+    REQUIRE(d.AddRelationship("c", "d", model::RelationshipType::Inheritance));
+    REQUIRE(d.EditClass("a", [](model::Class& c) { return c.AddField("x", "vector<e>"); }));
+
+    auto sub = d.Extract("b", 1, false);
+    REQUIRE(sub);
+    CHECK_EQ(sub->GetClassNames(), std::vector<std::string>{"a", "b", "c"});
+    CHECK_EQ(sub->GetRelationships(),
+             std::vector{*model::Relationship::From("a", "b", model::RelationshipType::Aggregation),
+                         *model::Relationship::From("c", "b", model::RelationshipType::Composition)});
+    CHECK_EQ(sub->GetAdjacency().Outgoing("c"), std::vector<std::string_view>{"b"});
+    CHECK_EQ((*sub->GetClass("a"))->Fields().size(), 1);
+
+    CHECK_EQ(d.Extract("b", 2, false)->GetClassNames(), std::vector<std::string>{"a", "b", "c", "d"});
+    CHECK_EQ(d.Extract("b", 0, false)->GetClassNames(), std::vector<std::string>{"b"});
+    CHECK_EQ(d.Extract("a", 1, true)->GetClassNames(), std::vector<std::string>{"a", "b", "e"});
+    CHECK_EQ(d.Extract("e", 5, false)->GetClassNames(), std::vector<std::string>{"e"});
+    CHECK_FALSE(d.Extract("z", 1, false));
+  }
+  DOCTEST_TEST_CASE("model::Diagram.GetAdjacency") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddClass("c"));
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    REQUIRE(d.AddRelationship("b", "b", model::RelationshipType::Aggregation));
+    CHECK_EQ(d.GetAdjacency().Outgoing("a"), std::vector<std::string_view>{"b"});
+    CHECK_EQ(d.GetAdjacency().Incoming("b"), std::vector<std::string_view>{"a", "b"});
+    REQUIRE(d.ChangeRelationshipDestination("a", "b", "c"));
+    CHECK_EQ(d.GetAdjacency().Outgoing("a"), std::vector<std::string_view>{"c"});
+    REQUIRE(d.RenameClass("b", "d"));
+    CHECK_EQ(d.GetAdjacency().Outgoing("d"), std::vector<std::string_view>{"d"});
+    CHECK(d.GetAdjacency().Outgoing("b").empty());
+    REQUIRE(d.DeleteClass("c"));
+    CHECK(d.GetAdjacency().Outgoing("a").empty());
+    REQUIRE(d.DeleteRelationship("d", "d"));
+    CHECK(d.GetAdjacency().Incoming("d").empty());
+  }
+  DOCTEST_TEST_CASE("model::Diagram.GetChangeLog") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    REQUIRE(d.AddClass("c"));
+    auto cursor = d.GetChangeLog().Now();
+    REQUIRE(d.AddRelationship("a", "b", model::RelationshipType::Inheritance));
+    auto changed = d.GetChangeLog().Since(cursor);
+    REQUIRE(changed);
+    std::ranges::sort(*changed);
+    CHECK_EQ(*changed, std::vector<std::string>{"a", "b"});
+
+    cursor = d.GetChangeLog().Now();
+    REQUIRE(d.DeleteClass("b"));
+    changed = d.GetChangeLog().Since(cursor);
+    REQUIRE(changed);
+    std::ranges::sort(*changed);
+    CHECK_EQ(*changed, std::vector<std::string>{"a", "b"});
+
+    model::Diagram const copy{d};
+    CHECK_FALSE(copy.GetChangeLog().Since(cursor));
+  }
   DOCTEST_TEST_CASE("model::Diagram.Json") {
     DOCTEST_SUBCASE("Valid") {
       auto json = R"({
@@ -428,6 +1255,84 @@ DOCTEST_TEST_SUITE("model::Diagram") {
       REQUIRE_THROWS(d = json);
     }
   }
+  DOCTEST_TEST_CASE("model::Diagram.FromJson") {
+    auto const json = R"({
+      "classes": [
+        {"name": "a", "fields": [{"name": "x", "type": " "}], "methods": [], "position": {"x": 0, "y": 0}},
+        {"name": "b", "fields": [], "methods": [], "position": {"x": 0}},
+        {"name": "c", "fields": [], "methods": [], "position": {"x": 0, "y": 0}}
+      ],
+      "relationships": [
+        {"source": "a", "destination": "b", "type": "Friendship"}
+      ]
+    })"_json;
+    auto const d = model::Diagram::FromJson(json);
+    REQUIRE_FALSE(d);
+    CHECK_NE(d.error().find("3 error(s)"), std::string::npos);
+    CHECK_NE(d.error().find(".classes[0].fields[0]: "), std::string::npos);
+    CHECK_NE(d.error().find(".classes[1].position: missing 'y'"), std::string::npos);
+    CHECK_NE(d.error().find(".relationships[0].type: "), std::string::npos);
+
+    CHECK_EQ(model::Diagram::FromJson(R"({"classes": []})"_json).error(),
+             "1 error(s) in diagram:\n  missing 'relationships'");
+    CHECK_FALSE(model::Diagram::FromJson(R"([])"_json));
+    auto const valid = model::Diagram::FromJson(R"({"classes": [], "relationships": []})"_json);
+    REQUIRE(valid);
+    CHECK(valid->GetClasses().empty());
+  }
+  DOCTEST_TEST_CASE("model::Diagram.Decode") {
+    auto const json = R"({
+      "classes": [
+        {"name": "a", "fields": [{"name": "x", "type": "int", "modified": [2, "field add"]}],
+         "methods": [{"name": "f", "return_type": "void", "params": [{"name": "p", "type": "b"}]}],
+         "position": {"x": -5, "y": 7}, "modified": [1, "class add"]},
+        {"name": "b", "fields": [], "methods": [], "position": {"x": 0, "y": 0}}
+      ],
+      "relationships": [
+        {"source": "a", "destination": "b", "type": "Realization", "modified": [3, "relationship add"]}
+      ]
+    })"_json;
+    auto d = model::Diagram::FromJson(json);
+    REQUIRE(d);
+    REQUIRE(d->DeleteClass("b").and_then([&] { return d->AddClass("b"); }));
+    REQUIRE(d->AddRelationship("a", "b", model::RelationshipType::Realization));
+    auto const encode = [](model::Diagram const& diagram) {
+      BinaryWriter out;
+      diagram.Encode(out);
+      return std::move(out.Bytes());
+    };
+    // deleted entities are not written, and everything read back is usable at once
+    std::string const bytes{encode(*d)};
+    BinaryReader in{bytes};
+    auto const decoded = model::Diagram::Decode(in);
+    REQUIRE(decoded);
+    CHECK(in.AtEnd());
+    CHECK_EQ(nlohmann::json(*decoded), nlohmann::json(*d));
+    CHECK(decoded->Valid(decoded->GetHandle("a").value()));
+    CHECK(decoded->GetClass("a").value()->GetReadOnlyField("x"));
+    CHECK_EQ(decoded->GetClass("a").value()->LastModified(), model::Provenance{1, "class add"});
+
+    for (std::size_t size{0}; size < bytes.size(); ++size) {
+      BinaryReader truncated{std::string_view{bytes}.substr(0, size)};
+      CHECK_FALSE(model::Diagram::Decode(truncated));
+    }
+    // what the lookups rely on is checked, even though names are not validated again
+    auto const forged = [](std::vector<model::Class> const& classes,
+                           std::vector<model::Relationship> const& relationships) {
+      BinaryWriter out;
+      out.Elements(classes, &model::Class::Encode);
+      out.Elements(relationships, &model::Relationship::Encode);
+      BinaryReader in{out.Bytes()};
+      return model::Diagram::Decode(in);
+    };
+    auto const a = *model::Class::From("a");
+    auto const b = *model::Class::From("b");
+    auto const ab = *model::Relationship::From("a", "b", model::RelationshipType::Inheritance);
+    CHECK(forged({a, b}, {ab}));
+    CHECK_FALSE(forged({b, a}, {}));
+    CHECK_FALSE(forged({a, a}, {}));
+    CHECK_FALSE(forged({a}, {ab}));
+  }
   DOCTEST_TEST_CASE("model::Diagram.SaveLoad") {
     auto json = R"({
       "classes": [
@@ -448,6 +1353,200 @@ DOCTEST_TEST_SUITE("model::Diagram") {
     CHECK(d2.Load(tmp.string()));
     CHECK_EQ(d.GetClasses(), d2.GetClasses());
     CHECK_EQ(d.GetRelationships(), d2.GetRelationships());
+
+    // the extension selects the compressed container
+    [[maybe_unused]] auto compressed = std::filesystem::temp_directory_path() / "test.umlz";
+    CHECK(d.Save(compressed.string()));
+    std::string magic(4, '\0');
+    std::ifstream{compressed}.read(magic.data(), 4);
+    CHECK_EQ(magic, "UMLZ");
+    model::Diagram d3;
+    CHECK(d3.Load(compressed.string()));
+    CHECK_EQ(d.GetClasses(), d3.GetClasses());
+    CHECK_EQ(d.GetRelationships(), d3.GetRelationships());
+    std::filesystem::copy_file(tmp, compressed, std::filesystem::copy_options::overwrite_existing);
+    CHECK_FALSE(d3.Load(compressed.string()));
+    CHECK_EQ(d.GetClasses(), d3.GetClasses());
+    std::filesystem::remove(compressed);
+
+    // a syntax error is reported with its position and leaves the diagram untouched
+    std::ofstream{tmp} << "{\n  \"classes\": [,\n}";
+    auto const res = d2.Load(tmp.string());
+    REQUIRE_FALSE(res);
+    CHECK_NE(res.error().find("line 2"), std::string::npos);
+    CHECK_EQ(d.GetClasses(), d2.GetClasses());
+  }
+  DOCTEST_TEST_CASE("model::Diagram.Save.Layout") {
+    [[maybe_unused]] auto tmp = std::filesystem::temp_directory_path() / "layout.json";
+    auto const saved = [&](model::Diagram& d) {
+      REQUIRE(d.Save(tmp.string()));
+      std::ostringstream contents;
+      contents << std::ifstream{tmp}.rdbuf();
+      return contents.str();
+    };
+    // the parallel serialization lays out a file exactly like a single dump
+    model::Diagram d;
+    CHECK_EQ(saved(d), nlohmann::json(d).dump(2, ' ', true));
+    for (int i{0}; i < 5000; ++i) {
+      REQUIRE(d.AddClass(std::format("c{}", i)));
+    }
+    REQUIRE(d.EditClass("c42", [](model::Class& c) { return c.AddField("f", "int"); }));
+    CHECK_EQ(saved(d), nlohmann::json(d).dump(2, ' ', true));
+    for (int i{1}; i < 5000; ++i) {
+      REQUIRE(d.AddRelationship("c0", std::format("c{}", i), model::RelationshipType::Aggregation));
+    }
+    CHECK_EQ(saved(d), nlohmann::json(d).dump(2, ' ', true));
+    // enough classes to be written in several slices
+    for (std::size_t i{5000}; i <= 2 * model::SavedPerSlice; ++i) {
+      REQUIRE(d.AddClass(std::format("c{}", i)));
+    }
+    CHECK_EQ(saved(d), nlohmann::json(d).dump(2, ' ', true));
+    std::filesystem::remove(tmp);
+  }
+  DOCTEST_TEST_CASE("model::Diagram.RenderClasses") {
+    model::Diagram d;
+    CHECK(d.RenderClasses().empty());
+    // enough classes to be split into several chunks
+    for (int i{0}; i < 5000; ++i) {
+      REQUIRE(d.AddClass(std::format("c{}", i)));
+    }
+    REQUIRE(d.EditClass("c42", [](model::Class& c) { return c.AddField("f", "int"); }));
+    std::string expected;
+    for (model::Class const& c : d.GetClasses()) {
+      expected.append(std::format("{}\n", c));
+    }
+    CHECK_EQ(d.RenderClasses(), expected);
+    CHECK_EQ(std::format("{:c}", d), expected);
+  }
+  DOCTEST_TEST_CASE("model::Diagram.Positions") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.AddClass("b"));
+    [[maybe_unused]] auto tmp = std::filesystem::temp_directory_path() / "positions.txt";
+    std::ofstream{tmp} << "# layout\na 10 -20\n\nb 3 4\n";
+    CHECK_FALSE(d.LoadPositions("/invalid-file"));
+    REQUIRE(d.LoadPositions(tmp.string()));
+    CHECK_EQ(d.GetClass("a").value()->Position(), model::Point{.x = 10, .y = -20});
+    CHECK_EQ(d.GetClass("b").value()->Position(), model::Point{.x = 3, .y = 4});
+
+    model::Diagram d2;
+    REQUIRE(d2.AddClass("a"));
+    REQUIRE(d2.AddClass("b"));
+    REQUIRE(d.SavePositions(tmp.string()));
+    REQUIRE(d2.LoadPositions(tmp.string()));
+    CHECK_EQ(d.GetClasses(), d2.GetClasses());
+
+    // an error on any line leaves every class where it was
+    std::ofstream{tmp} << "a 0 0\nc 1 1\n";
+    auto const missing = d.LoadPositions(tmp.string());
+    REQUIRE_FALSE(missing);
+    CHECK_EQ(missing.error(), "Error: line 2: class 'c' does not exist");
+    std::ofstream{tmp} << "a 0\n";
+    CHECK_FALSE(d.LoadPositions(tmp.string()));
+    CHECK_EQ(d.GetClass("a").value()->Position(), model::Point{.x = 10, .y = -20});
+  }
+  DOCTEST_TEST_CASE("model::Diagram.Delta") {
+    model::Diagram before;
+    for (auto name : {"a", "b", "c", "d"}) {
+      REQUIRE(before.AddClass(name));
+    }
+    REQUIRE(before.AddRelationship("a", "b", model::RelationshipType::Aggregation));
+    REQUIRE(before.AddRelationship("b", "b", model::RelationshipType::Composition));
+    REQUIRE(before.AddRelationship("c", "d", model::RelationshipType::Inheritance));
+
+    model::Diagram after{before};
+    auto const cursor = after.GetChangeLog().Now();
+    REQUIRE(after.RenameClass("b", "e"));
+    REQUIRE(after.EditClass("a", [](model::Class& c) { return c.AddField("x", "e"); }));
+    REQUIRE(after.DeleteClass("d"));
+    auto const delta = after.DeltaSince(cursor);
+    REQUIRE(delta);
+    CHECK_FALSE(delta->classes.at("b"));
+    CHECK_FALSE(delta->classes.at("d"));
+    CHECK(delta->classes.at("e"));
+
+    before.Apply(*delta);
+    CHECK_EQ(before.GetClasses(), after.GetClasses());
+    CHECK_EQ(before.GetRelationships(), after.GetRelationships());
+    CHECK_EQ(before.GetAdjacency().Successors("e"), after.GetAdjacency().Successors("e"));
+    CHECK_EQ(before.GetAdjacency().Predecessors("e"), after.GetAdjacency().Predecessors("e"));
+    CHECK(before.GetAdjacency().Predecessors("d").empty());
+    CHECK_EQ(before.GetTypeIndex().Unresolved(), after.GetTypeIndex().Unresolved());
+
+    model::Diagram copy{after};
+    CHECK_FALSE(after.DeltaSince(copy.GetChangeLog().Now()));
+
+    // a class which does not exist is captured as removed
+    auto const missing = copy.Capture(std::vector<std::string>{"e", "z"});
+    CHECK(missing.classes.at("e"));
+    CHECK_FALSE(missing.classes.at("z"));
+
+    // classes read from a file carry no handle, and keep the one of the class they replace
+    auto const handle = after.GetHandle("a").value();
+    model::Delta loaded;
+    loaded.classes.emplace("a", model::Class::From("a").value());
+    loaded.classes.emplace("n", model::Class::From("n").value());
+    after.Apply(loaded);
+    CHECK_EQ(after.GetHandle("a").value(), handle);
+    CHECK(after.Valid(after.GetHandle("n").value()));
+    CHECK_NE(after.GetHandle("n").value(), handle);
+  }
+  DOCTEST_TEST_CASE("model::Diagram.Handles") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("b"));
+    auto const b = d.GetHandle("b");
+    REQUIRE(b);
+    CHECK_FALSE(d.GetHandle("z"));
+
+    // a handle survives edits which move the class within the diagram, including its own renaming
+    REQUIRE(d.AddClass("a"));
+    REQUIRE(d.RenameClass("b", "c"));
+    REQUIRE(d.AddClass("b"));
+    CHECK(d.Valid(*b));
+    REQUIRE(std::as_const(d).GetClass(*b));
+    CHECK_EQ(std::as_const(d).GetClass(*b).value()->Name(), "c");
+    CHECK_NE(d.GetHandle("b"), b);
+
+    // restoring an earlier copy (as undo does) invalidates handles to classes added since
+    model::Diagram const before{d};
+    REQUIRE(d.AddClass("e"));
+    auto const e = d.GetHandle("e");
+    REQUIRE(e);
+    auto const cursor = d.GetChangeLog().Now();
+    REQUIRE(d.RenameClass("c", "f"));
+    auto const delta = d.DeltaSince(cursor);
+    REQUIRE(delta);
+    d = before;
+    CHECK_FALSE(d.Valid(*e));
+    REQUIRE(d.AddClass("g"));
+    CHECK_FALSE(d.GetClass(*e));
+
+    // replaying an edit keeps the handles it was made with
+    model::Diagram replayed{before};
+    REQUIRE(replayed.AddClass("e"));
+    replayed.Apply(*delta);
+    REQUIRE(replayed.GetClass(*b));
+    CHECK_EQ(replayed.GetClass(*b).value()->Name(), "f");
+
+    // replaying a rename which sorts the class before its old place hands the handle over instead of releasing it
+    model::Diagram moved{replayed};
+    auto const renamed = replayed.GetChangeLog().Now();
+    REQUIRE(replayed.RenameClass("f", "a0"));
+    moved.Apply(replayed.DeltaSince(renamed).value());
+    REQUIRE(moved.GetClass(*b));
+    CHECK_EQ(moved.GetClass(*b).value()->Name(), "a0");
+    // the handle is a position, which follows the class when deleted classes before it are swept away
+    REQUIRE(moved.DeleteClass("a"));
+    moved.Compact();
+    REQUIRE(moved.GetClass(*b));
+    CHECK_EQ(moved.GetClass(*b).value()->Name(), "a0");
+    CHECK_EQ(moved.GetClass(moved.GetHandle("e").value()).value()->Name(), "e");
+
+    REQUIRE(d.DeleteClass("c"));
+    CHECK_FALSE(d.Valid(*b));
+    CHECK_FALSE(d.GetClass(*b));
+    REQUIRE(d.AddClass("c"));
+    CHECK_FALSE(d.Valid(*b));
   }
   DOCTEST_TEST_CASE("model::Diagram::GetInstance") {
     REQUIRE(model::Diagram::GetInstance().AddClass("a"));
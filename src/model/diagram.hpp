@@ -1,21 +1,108 @@
 #pragma once
 
+#include "model/adjacency.hpp"
+#include "model/change_log.hpp"
 #include "model/class.hpp"
+#include "model/delta.hpp"
+#include "model/handles.hpp"
+#include "model/live.hpp"
+#include "model/name_index.hpp"
 #include "model/relationship.hpp"
 #include "model/relationship_type.hpp"
+#include "model/type_index.hpp"
 
 #include "utils/utils.hpp"
 
 #include <nlohmann/json_fwd.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+class BinaryReader;
+class BinaryWriter;
+
 namespace model {
 
 class Diagram {
+  // deleted entities are only marked as such and keep their places until the next sweep, which happens once they
+  // outnumber the live ones or whenever a non-const member function needs every entity in place (e.g. to re-sort or
+  // refresh the indexes); const member functions skip them, so reading never moves an entity
   std::vector<Class> classes_;
   std::vector<Relationship> relationships_;
+  /// the names of the deleted classes still within classes_
+  std::set<std::string, std::less<>> dead_classes_;
+  /// the endpoints of the deleted relationships still within relationships_
+  std::set<std::pair<std::string, std::string>> dead_relationships_;
+  TypeIndex type_index_;
+  NameIndex name_index_;
+  Adjacency adjacency_;
+  ChangeLog changes_;
+  /// the slots behind the handles of the classes, each holding the position of its class within classes_
+  HandleTable handles_;
+
+  ///
+  /// @brief Notify every derived index that a class may be modified
+  ///
+  /// @param name the name of the class
+  ///
+  void Touch(std::string_view name);
+
+  ///
+  /// @brief Give every class a fresh handle, invalidating any it had
+  ///
+  void AllocateHandles();
+
+  ///
+  /// @brief Point the handles of the live classes at their places within classes_ after some of them moved
+  ///
+  /// @param first the first position which may have changed
+  ///
+  void PlaceHandles(std::size_t first = 0);
+
+  ///
+  /// @brief Remove every deleted class and relationship from storage in a single pass
+  ///
+  void Sweep();
+
+  ///
+  /// @brief Sweep once deleted entities outnumber the live ones, so a run of deletions costs linear time overall
+  ///
+  void SweepIfSparse();
+
+  ///
+  /// @brief Insert a class at its sorted place, reusing the place of a deleted class of the same name
+  ///
+  /// @param c a class whose name no live class has
+  ///
+  void Insert(Class c);
+
+  ///
+  /// @brief Insert a relationship at its sorted place, reusing the place of a deleted one with the same endpoints
+  ///
+  /// @param r a relationship whose endpoints no live relationship has
+  ///
+  void Insert(Relationship r);
+
+  ///
+  /// @brief Mark a relationship as deleted
+  ///
+  /// @param source
+  /// @param destination
+  ///
+  void Bury(std::string_view source, std::string_view destination);
+
+  ///
+  /// @brief Check the sorted classes and relationships of a diagram being read, and build its indexes
+  ///
+  /// @return error if a class or relationship appears twice, or a relationship takes part in a nonexistent class
+  ///
+  [[nodiscard]] Result<void> Index();
 
   //NOLINTBEGIN(readability-identifier-naming)
   friend void to_json(nlohmann::json&, Diagram const&);
@@ -28,12 +115,45 @@ public:
   [[nodiscard]] static Diagram& GetInstance() noexcept;
 
   ///
-  /// @brief Get an iterator to a corresponding class
+  /// @brief Create a diagram from its JSON representation without throwing
+  ///
+  /// Every malformed class and relationship is reported, each prefixed by its location within the document.
+  ///
+  /// @param json
+  /// @return error if the JSON is malformed or validation failed
+  ///
+  [[nodiscard]] static Result<Diagram> FromJson(nlohmann::json const& json);
+
+  ///
+  /// @brief Append the diagram to a binary buffer, to be read back by Decode
+  ///
+  /// @param out
+  ///
+  void Encode(BinaryWriter& out) const;
+
+  ///
+  /// @brief Read a diagram written by Encode
+  ///
+  /// The classes and relationships are taken as they were written rather than validated again; only what the
+  /// diagram's lookups rely on (both sorted without duplicates, relationships between existing classes) is checked.
+  ///
+  /// @param in
+  /// @return error if the buffer is truncated or corrupt
+  ///
+  [[nodiscard]] static Result<Diagram> Decode(BinaryReader& in);
+
+  ///
+  /// @brief Modify a class, recording the change IFF the modification succeeds
+  ///
+  /// The class is stamped with the active provenance, and the indexes and change log learn about it, only once edit
+  /// has succeeded, so a failed or read-only edit leaves no trace. Classes are renamed with RenameClass, which keeps
+  /// them sorted.
   ///
   /// @param name
-  /// @return Error if the name is invalid or the class doesn't exist
+  /// @param edit called with the class, leaving it unchanged if it returns an error
+  /// @return Error if the name is invalid, the class doesn't exist, or edit failed
   ///
-  [[nodiscard]] Result<std::vector<Class>::iterator> GetClass(std::string_view name);
+  [[nodiscard]] Result<void> EditClass(std::string_view name, std::function<Result<void>(Class&)> const& edit);
 
   ///
   /// @brief Get an iterator to a corresponding class
@@ -44,13 +164,46 @@ public:
   [[nodiscard]] Result<std::vector<Class>::const_iterator> GetClass(std::string_view name) const;
 
   ///
-  /// @brief Get an iterator to a corresponding relationship
+  /// @brief Get an iterator to the class a handle refers to
+  ///
+  /// @param handle
+  /// @return Error if the class no longer belongs to the diagram
+  ///
+  [[nodiscard]] Result<std::vector<Class>::const_iterator> GetClass(Handle handle) const;
+
+  ///
+  /// @brief Get a handle to a class, which stays valid until the class is deleted or the diagram is replaced
+  ///
+  /// Unlike an iterator, a handle survives the addition, deletion and renaming of other classes, and a stale handle
+  /// is detected in constant time rather than dangling.
+  ///
+  /// @param name
+  /// @return Error if the name is invalid or the class doesn't exist
+  ///
+  [[nodiscard]] Result<Handle> GetHandle(std::string_view name) const;
+
+  ///
+  /// @brief Check in constant time whether a handle still refers to a class of the diagram
+  ///
+  /// @param handle
+  /// @return true IFF the class has not been deleted
+  ///
+  [[nodiscard]] bool Valid(Handle handle) const noexcept;
+
+  ///
+  /// @brief Modify a relationship, recording the change IFF the modification succeeds
+  ///
+  /// Only what is not part of the relationship's identity (i.e. its type) may be changed, since the relationships
+  /// stay sorted by their endpoints.
   ///
   /// @param src
   /// @param dst
-  /// @return Error if either name is invalid or the relationship doesn't exist
+  /// @param edit called with the relationship, leaving it unchanged if it returns an error
+  /// @return Error if either name is invalid, the relationship doesn't exist, or edit failed
   ///
-  [[nodiscard]] Result<std::vector<Relationship>::iterator> GetRelationship(std::string_view src, std::string_view dst);
+  [[nodiscard]] Result<void> EditRelationship(std::string_view src,
+                                              std::string_view dst,
+                                              std::function<Result<void>(Relationship&)> const& edit);
 
   ///
   /// @brief Get an iterator to a corresponding relationship
@@ -73,6 +226,8 @@ public:
   ///
   /// @brief Delete a class from the diagram
   ///
+  /// The class and its relationships are only marked as deleted, so deleting many classes costs linear time overall.
+  ///
   /// @param name
   /// @return Error IFF deleting failed
   ///
@@ -101,6 +256,8 @@ public:
   ///
   /// @brief Delete a relationship from the diagram
   ///
+  /// The relationship is only marked as deleted, so deleting many relationships costs linear time overall.
+  ///
   /// @param source
   /// @param destination
   /// @return Error IFF deleting failed
@@ -133,6 +290,8 @@ public:
   ///
   /// @brief Load a file and replace this Diagram's contents
   ///
+  /// Files with the compressed extension (.umlz) are decompressed first.
+  ///
   /// @param file_name
   /// @return Error IFF loading the file failed (including validation)
   ///
@@ -141,11 +300,45 @@ public:
   ///
   /// @brief Save this diagram's representation to a file
   ///
+  /// Files with the compressed extension (.umlz) are written as a compressed container.
+  ///
   /// @param file_name
   /// @return Error IFF saving the file failed
   ///
   [[nodiscard]] Result<void> Save(std::string_view file_name);
 
+  ///
+  /// @brief Move every class listed in a coordinate file
+  ///
+  /// Each non-blank line which does not start with '#' reads "class_name x y". The whole file is validated before any
+  /// class is moved, so a file with an error leaves the diagram untouched.
+  ///
+  /// @param file_name
+  /// @return Error IFF the file could not be read, a line is malformed, or a listed class does not exist
+  ///
+  [[nodiscard]] Result<void> LoadPositions(std::string_view file_name);
+
+  ///
+  /// @brief Write the position of every class to a coordinate file readable by LoadPositions()
+  ///
+  /// @param file_name
+  /// @return Error IFF writing the file failed
+  ///
+  [[nodiscard]] Result<void> SavePositions(std::string_view file_name) const;
+
+  ///
+  /// @brief Copy the neighborhood of a class into a standalone diagram
+  ///
+  /// Relationships are followed in either direction using the adjacency index, so the cost is proportional to the
+  /// size of the neighborhood rather than the diagram. Every relationship between two extracted classes is kept.
+  ///
+  /// @param class_name the class at the center of the neighborhood
+  /// @param hops the maximum number of relationships between the center and an extracted class
+  /// @param with_types whether classes named by the member types of extracted classes are also extracted
+  /// @return Error IFF the class doesn't exist
+  ///
+  [[nodiscard]] Result<Diagram> Extract(std::string_view class_name, std::size_t hops, bool with_types) const;
+
   ///
   /// @brief Get the names of the classes of the diagram
   ///
@@ -156,16 +349,125 @@ public:
   ///
   /// @brief Get the classes of the diagram
   ///
-  /// @return std::vector<Class> const&
+  /// @return the classes in order of their names, which stay in place until the diagram is modified
   ///
-  [[nodiscard]] std::vector<Class> const& GetClasses() const noexcept;
+  [[nodiscard]] Live<Class> GetClasses() const;
 
   ///
   /// @brief Get the relationships of the diagram
   ///
-  /// @return std::vector<Relationship> const&
+  /// @return the relationships in order of their endpoints, which stay in place until the diagram is modified
+  ///
+  [[nodiscard]] Live<Relationship> GetRelationships() const;
+
+  ///
+  /// @brief Bring the type usage and name indexes up to date with any pending changes and the configured builtins
+  ///
+  /// Const member functions never refresh the indexes, so a diagram which is read from several threads (or through a
+  /// const reference) must be refreshed by its owner beforehand. Deleted entities are swept away as well, so readers
+  /// see the storage directly.
+  ///
+  void RefreshIndexes();
+
+  ///
+  /// @brief Get the type usage index of the diagram, bringing it up to date with any pending changes
+  ///
+  /// @return TypeIndex const&
+  ///
+  [[nodiscard]] TypeIndex const& GetTypeIndex();
+
+  ///
+  /// @brief Get the type usage index of the diagram as of the previous RefreshIndexes()
+  ///
+  /// @return TypeIndex const&
+  ///
+  [[nodiscard]] TypeIndex const& GetTypeIndex() const noexcept;
+
+  ///
+  /// @brief Get the name index of the diagram, bringing it up to date with any pending changes
+  ///
+  /// @return NameIndex const&
+  ///
+  [[nodiscard]] NameIndex const& GetNameIndex();
+
+  ///
+  /// @brief Get the name index of the diagram as of the previous RefreshIndexes()
+  ///
+  /// @return NameIndex const&
+  ///
+  [[nodiscard]] NameIndex const& GetNameIndex() const noexcept;
+
+  ///
+  /// @brief Get the relationship adjacency of the diagram
+  ///
+  /// @return Adjacency const&
+  ///
+  [[nodiscard]] Adjacency const& GetAdjacency() const noexcept;
+
+  ///
+  /// @brief Get the log of classes changed since the diagram was created, copied, or loaded
+  ///
+  /// @return ChangeLog const&
+  ///
+  [[nodiscard]] ChangeLog const& GetChangeLog() const noexcept;
+
+  ///
+  /// @brief Capture the state of every class changed since a position of the change log
+  ///
+  /// @param since a position of this diagram's change log taken before the edit
+  /// @return the changed classes and their relationships, or nullopt if the log started a new epoch since then
+  ///
+  [[nodiscard]] std::optional<Delta> DeltaSince(ChangeLog::Cursor since) const;
+
+  ///
+  /// @brief Capture the current state of some classes and of every relationship they take part in
+  ///
+  /// @param class_names the classes to capture (a class which does not exist is captured as removed)
+  /// @return a delta which reproduces the current state of those classes when applied to another state
+  ///
+  [[nodiscard]] Delta Capture(std::span<std::string const> class_names) const;
+
+  ///
+  /// @brief Reproduce an edit by applying the delta captured after it to the state before it
+  ///
+  /// Only the classes named by the delta and the relationships they take part in are replaced, so the cost is
+  /// proportional to the size of the edit rather than to the work originally needed to make it.
   ///
-  [[nodiscard]] std::vector<Relationship> const& GetRelationships() const noexcept;
+  /// Classes which carry no handle (e.g. read from a file) keep the handle of the class they replace or get a new one.
+  ///
+  /// @param delta a delta captured from this diagram's current state
+  ///
+  void Apply(Delta const& delta);
+
+  ///
+  /// @brief Replace the contents of the diagram with another state of it, carrying on with the same change log
+  ///
+  /// Assignment starts a new change log epoch, which makes every consumer of the log (e.g. lint and invariants)
+  /// re-examine the whole diagram; restoring instead records the classes which differ as changed.
+  ///
+  /// @param state the state to restore, e.g. a copy taken before an edit
+  /// @param changed every class which differs between this diagram and the state
+  ///
+  void Restore(Diagram const& state, std::span<std::string const> changed);
+
+  ///
+  /// @brief Share the storage of every field and method with identical ones (no-op unless hash-consing is enabled)
+  ///
+  void Share();
+
+  ///
+  /// @brief Sweep away deleted entities and release the spare capacity of every string and vector
+  ///
+  void Compact();
+  ///
+  /// @brief Render the box of every class, each followed by a newline, in order
+  ///
+  /// Boxes are independent of each other, so contiguous chunks of classes are formatted concurrently into separate
+  /// buffers which are then joined.
+  ///
+  /// @return the boxes as printed by list all and list classes
+  ///
+  [[nodiscard]] std::string RenderClasses() const;
 };
 
 } // namespace model
@@ -188,9 +490,7 @@ template <> struct std::formatter<model::Diagram> {
   auto format(model::Diagram const& obj, FormatContext& ctx) const {
     for (char letter : format_text) {
       if (letter == 'c') {
-        for (model::Class const& c : obj.GetClasses()) {
-          ctx.advance_to(std::format_to(ctx.out(), "{}\n", c));
-        }
+        ctx.advance_to(std::ranges::copy(obj.RenderClasses(), ctx.out()).out);
       } else if (letter == 'r') {
         for (model::Relationship const& r : obj.GetRelationships()) {
           ctx.advance_to(std::format_to(ctx.out(), "{}\n", r));
@@ -1,11 +1,14 @@
 #include "field.hpp"
 
+#include <functional>
 #include <stdexcept>
 
 #include <doctest/doctest.h>
 #include <nlohmann/json.hpp>
 
 #include "model/checking.hpp"
+#include "utils/binary.hpp"
+#include "utils/json.hpp"
 #include "utils/utils.hpp"
 
 namespace model {
@@ -14,52 +17,119 @@ namespace model {
 void to_json(nlohmann ::json& json, const Field& f) {
   json["name"] = f.Name();
   json["type"] = f.Type();
+  if (f.provenance_.Known()) {
+    json["modified"] = f.provenance_;
+  }
 }
 
 // NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(const nlohmann ::json& json, Field& f) {
-  auto res =
-      Field::From(json.at("name").get<std::string>(), json.at("type").get<std::string>()).transform([&](Field field) {
-        f = std::move(field);
-      });
+  auto res = Field::FromJson(json).transform([&](Field field) { f = std::move(field); });
   if (not res.has_value()) {
     throw std::invalid_argument{res.error()};
   }
 }
 
+Result<Field> Field::FromJson(nlohmann::json const& json) {
+  return JsonMember(json, "name", JsonString)
+      .and_then([&](std::string_view name) {
+        return JsonMember(json, "type", JsonString).and_then([&](std::string_view type) { return From(name, type); });
+      })
+      .and_then([&](Field f) {
+        return ModifiedFromJson(json).transform([&](Provenance modified) {
+          f.provenance_ = modified;
+          return std::move(f);
+        });
+      });
+}
+
+void Field::Encode(BinaryWriter& out) const {
+  out.String(data_->name);
+  out.String(data_->type);
+  provenance_.Encode(out);
+}
+
+Result<Field> Field::Decode(BinaryReader& in) {
+  return in.String().and_then([&](std::string_view name) {
+    return in.String().and_then([&](std::string_view type) {
+      return Provenance::Decode(in).transform([&](Provenance modified) {
+        Field f;
+        f.data_ = Shared<Data>{Data{std::string{name}, std::string{type}}};
+        f.provenance_ = modified;
+        return f;
+      });
+    });
+  });
+}
+
 Result<Field> Field::From(std::string_view name, std::string_view type) {
   return Check<ValidIdentifier>(name, "field name").and_then([&] {
     return Check<ValidType>(type, "field type").transform([&] {
       Field f;
-      f.name_ = name;
-      f.type_ = type;
+      f.data_ = Shared<Data>{Data{std::string{name}, std::string{type}}};
       return f;
     });
   });
 }
 
+std::size_t Field::Data::Hash() const noexcept {
+  std::hash<std::string> const hasher;
+  return (hasher(name) * 31) ^ hasher(type);
+}
+
+Field::Data& Field::Edit() {
+  MarkModified();
+  return data_.Edit();
+}
+
 std::string const& Field::Name() const noexcept {
-  return name_;
+  return data_->name;
 }
 
 std::string const& Field::Type() const noexcept {
-  return type_;
+  return data_->type;
 }
 
 Result<void> Field::Rename(std::string_view name) {
-  return Check<ValidType>(name, "field type").transform([&] { name_ = name; });
+  return Check<ValidType>(name, "field type").transform([&] {
+    Edit().name = name;
+    data_.Share();
+  });
 }
 
 Result<void> Field::ChangeType(std::string_view new_type) {
-  return Check<ValidType>(new_type, "field type").transform([&] { type_ = new_type; });
+  return Check<ValidType>(new_type, "field type").transform([&] {
+    Edit().type = new_type;
+    data_.Share();
+  });
+}
+
+void Field::Share() {
+  data_.Share();
+}
+
+bool Field::SharesWith(Field const& other) const noexcept {
+  return data_.SharesWith(other.data_);
+}
+
+Provenance const& Field::LastModified() const noexcept {
+  return provenance_;
+}
+
+Handle Field::GetHandle() const noexcept {
+  return handle_;
+}
+
+void Field::MarkModified() noexcept {
+  ProvenanceScope::Mark(provenance_);
 }
 
 std::strong_ordering Field::operator<=>(Field const& other) const noexcept {
-  return name_ <=> other.name_;
+  return Name() <=> other.Name();
 }
 
 bool Field::operator==(Field const& other) const noexcept {
-  return name_ == other.name_;
+  return Name() == other.Name();
 }
 
 } // namespace model
@@ -160,6 +230,27 @@ DOCTEST_TEST_SUITE("model::Field") {
     CHECK_GE(*a, *a);
   }
 
+  DOCTEST_TEST_CASE("model::Field.Share") {
+    ScopedSettings const scope;
+    REQUIRE(Settings::GetInstance().Set("hash-consing", "on"));
+    auto a = model::Field::From("a", "int");
+    auto b = model::Field::From("a", "int");
+    REQUIRE(a);
+    REQUIRE(b);
+    CHECK(a->SharesWith(*b));
+    REQUIRE(b->ChangeType("double"));
+    CHECK_FALSE(a->SharesWith(*b));
+    CHECK_EQ(a->Type(), "int");
+    CHECK_EQ(b->Type(), "double");
+    REQUIRE(b->ChangeType("int"));
+    CHECK(a->SharesWith(*b));
+    REQUIRE(Settings::GetInstance().Set("hash-consing", "off"));
+    auto c = model::Field::From("a", "int");
+    REQUIRE(c);
+    CHECK_FALSE(a->SharesWith(*c));
+    CHECK_EQ(*a, *c);
+  }
+
   DOCTEST_TEST_CASE("model::Field.Format") {
     [[maybe_unused]] auto a = model::Field::From("a", "int");
     REQUIRE(a);
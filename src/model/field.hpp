@@ -1,5 +1,8 @@
 #pragma once
 
+#include "model/handles.hpp"
+#include "model/provenance.hpp"
+#include "utils/shared.hpp"
 #include "utils/utils.hpp"
 
 #include <nlohmann/json_fwd.hpp>
@@ -9,15 +12,36 @@
 #include <string>
 #include <string_view>
 
+class BinaryReader;
+class BinaryWriter;
+
 namespace model {
 
 class Field {
-  std::string name_;
-  std::string type_;
+  struct Data {
+    std::string name;
+    std::string type;
+
+    [[nodiscard]] bool operator==(Data const&) const noexcept = default;
+
+    [[nodiscard]] std::size_t Hash() const noexcept;
+  };
+
+  Shared<Data> data_;
+  Provenance provenance_;
+  /// allocated by the class the field belongs to
+  Handle handle_;
+
+  ///
+  /// @brief Get our own copy of the data to modify, marking the field as modified
+  ///
+  [[nodiscard]] Data& Edit();
+
   //NOLINTBEGIN(readability-identifier-naming)
   friend void to_json(nlohmann::json&, Field const&);
   friend void from_json(nlohmann::json const&, Field&);
   //NOLINTEND(readability-identifier-naming)
+  friend class Class;
 
 public:
   ///
@@ -29,6 +53,29 @@ public:
   ///
   static Result<Field> From(std::string_view name, std::string_view type);
 
+  ///
+  /// @brief Create a field from its JSON representation without throwing
+  ///
+  /// @param json
+  /// @return error (prefixed by the location of the offending value) if the JSON is malformed or validation failed
+  ///
+  [[nodiscard]] static Result<Field> FromJson(nlohmann::json const& json);
+
+  ///
+  /// @brief Append the field to a binary buffer, to be read back by Decode
+  ///
+  /// @param out
+  ///
+  void Encode(BinaryWriter& out) const;
+
+  ///
+  /// @brief Read a field written by Encode, taking it as it was written rather than validating it again
+  ///
+  /// @param in
+  /// @return error if the buffer is truncated or corrupt
+  ///
+  [[nodiscard]] static Result<Field> Decode(BinaryReader& in);
+
   [[nodiscard]] std::string const& Name() const noexcept;
   [[nodiscard]] std::string const& Type() const noexcept;
 
@@ -51,6 +98,31 @@ public:
   /// @return error IFF validation of the new type failed
   ///
   [[nodiscard]] Result<void> ChangeType(std::string_view new_type);
+
+  ///
+  /// @brief Share storage with every identical field (no-op unless hash-consing is enabled)
+  ///
+  void Share();
+
+  ///
+  /// @brief Check whether two fields share the same storage
+  ///
+  [[nodiscard]] bool SharesWith(Field const& other) const noexcept;
+
+  ///
+  /// @brief Get the command which last modified the field
+  ///
+  [[nodiscard]] Provenance const& LastModified() const noexcept;
+
+  ///
+  /// @brief Get the handle of the field, which stays valid while the field belongs to its class
+  ///
+  [[nodiscard]] Handle GetHandle() const noexcept;
+
+  ///
+  /// @brief Record the active command (if any) as the last to modify the field
+  ///
+  void MarkModified() noexcept;
 };
 
 } // namespace model
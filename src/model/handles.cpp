@@ -0,0 +1,129 @@
+#include "handles.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace model {
+
+static std::uint32_t NextGeneration() noexcept {
+  static std::atomic<std::uint32_t> generation{0};
+  return ++generation;
+}
+
+Handle HandleTable::Allocate(std::size_t position) {
+  Handle handle{.slot = 0, .generation = NextGeneration()};
+  if (free_.empty()) {
+    handle.slot = static_cast<std::uint32_t>(slots_.size());
+    slots_.emplace_back();
+  } else {
+    handle.slot = free_.back();
+    free_.pop_back();
+  }
+  slots_[handle.slot] = Slot{.generation = handle.generation, .position = static_cast<std::uint32_t>(position)};
+  return handle;
+}
+
+void HandleTable::Restore(Handle handle, std::size_t position) {
+  if (handle.generation == 0) {
+    return;
+  }
+  if (handle.slot >= slots_.size()) {
+    for (auto slot = static_cast<std::uint32_t>(slots_.size()); slot < handle.slot; ++slot) {
+      free_.push_back(slot);
+    }
+    slots_.resize(handle.slot + std::size_t{1});
+  } else if (slots_[handle.slot].generation == 0) {
+    std::erase(free_, handle.slot);
+  }
+  slots_[handle.slot] = Slot{.generation = handle.generation, .position = static_cast<std::uint32_t>(position)};
+}
+
+void HandleTable::Release(Handle handle) noexcept {
+  if (Valid(handle)) {
+    slots_[handle.slot] = Slot{};
+    free_.push_back(handle.slot);
+  }
+}
+
+void HandleTable::Place(Handle handle, std::size_t position) noexcept {
+  if (Valid(handle)) {
+    slots_[handle.slot].position = static_cast<std::uint32_t>(position);
+  }
+}
+
+void HandleTable::Clear() noexcept {
+  slots_.clear();
+  free_.clear();
+}
+
+bool HandleTable::Valid(Handle handle) const noexcept {
+  return handle.generation != 0 and handle.slot < slots_.size() and slots_[handle.slot].generation == handle.generation;
+}
+
+std::optional<std::size_t> HandleTable::Position(Handle handle) const noexcept {
+  if (Valid(handle)) {
+    return slots_[handle.slot].position;
+  } else {
+    return std::nullopt;
+  }
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::HandleTable") {
+  DOCTEST_TEST_CASE("model::HandleTable.Allocate") {
+    model::HandleTable table;
+    auto const a = table.Allocate(0);
+    auto const b = table.Allocate(1);
+    CHECK_NE(a, b);
+    CHECK(table.Valid(a));
+    CHECK(table.Valid(b));
+    CHECK_FALSE(table.Valid(model::Handle{}));
+    CHECK_EQ(table.Position(a), 0);
+    CHECK_EQ(table.Position(b), 1);
+
+    table.Release(a);
+    CHECK_FALSE(table.Valid(a));
+    CHECK_FALSE(table.Position(a));
+    CHECK(table.Valid(b));
+
+    // the slot is reused, but the stale handle stays invalid
+    auto const c = table.Allocate(2);
+    CHECK_EQ(c.slot, a.slot);
+    CHECK_FALSE(table.Valid(a));
+    CHECK(table.Valid(c));
+
+    table.Place(c, 0);
+    CHECK_EQ(table.Position(c), 0);
+    // a stale handle cannot move the entity which took over its slot
+    table.Place(a, 5);
+    CHECK_EQ(table.Position(c), 0);
+    table.Clear();
+    CHECK_FALSE(table.Valid(b));
+    CHECK_FALSE(table.Valid(c));
+  }
+  DOCTEST_TEST_CASE("model::HandleTable.Restore") {
+    model::HandleTable table;
+    auto const a = table.Allocate(0);
+    auto const before = table;
+    auto const b = table.Allocate(1);
+    table.Release(a);
+    auto const c = table.Allocate(0);
+
+    // restoring an earlier copy must not revive handles allocated since it was taken
+    table = before;
+    CHECK(table.Valid(a));
+    CHECK_FALSE(table.Valid(b));
+    CHECK_FALSE(table.Valid(c));
+
+    table.Restore(b, 1);
+    CHECK(table.Valid(b));
+    CHECK_EQ(table.Position(b), 1);
+    // the slot of a restored handle is no longer free
+    auto const d = table.Allocate(2);
+    CHECK_NE(d.slot, b.slot);
+    CHECK_NE(d, c);
+  }
+}
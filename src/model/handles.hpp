@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace model {
+
+///
+/// @brief A reference to an entity which stays valid across unrelated edits and can be revalidated in constant time
+///
+/// A default-constructed handle refers to nothing.
+///
+struct Handle {
+  /// the slot of the handle table which tracks the entity
+  std::uint32_t slot{0};
+  /// the generation of the slot when the entity was added, never reused once the entity is removed
+  std::uint32_t generation{0};
+
+  [[nodiscard]] bool operator==(Handle const&) const noexcept = default;
+};
+
+///
+/// @brief The slots behind the handles of one kind of entity
+///
+/// Generations are drawn from a process-wide counter rather than per slot, so a handle can never be mistaken for a
+/// later entity even after the table is restored from a copy taken before that entity was added.
+///
+/// Each slot holds the position of its entity within the owner's storage, so resolving a handle is a single index.
+/// The owner places the handles again whenever it moves entities (e.g. by inserting, sorting or sweeping).
+///
+class HandleTable {
+  struct Slot {
+    /// the generation of the live entity, or 0 if the slot is free
+    std::uint32_t generation{0};
+    /// the position of the entity within the owner's storage
+    std::uint32_t position{0};
+  };
+  std::vector<Slot> slots_;
+  std::vector<std::uint32_t> free_;
+
+public:
+  ///
+  /// @brief Track a new entity
+  ///
+  /// @param position the position of the entity within the owner's storage
+  /// @return a handle unequal to every handle previously returned
+  ///
+  [[nodiscard]] Handle Allocate(std::size_t position = 0);
+
+  ///
+  /// @brief Track an entity under a handle allocated by a copy of this table (moving it if already tracked)
+  ///
+  /// @param handle a handle whose slot is free in this table or already refers to the entity
+  /// @param position the position of the entity within the owner's storage
+  ///
+  void Restore(Handle handle, std::size_t position = 0);
+
+  ///
+  /// @brief Stop tracking an entity, invalidating every copy of its handle
+  ///
+  /// @param handle
+  ///
+  void Release(Handle handle) noexcept;
+
+  ///
+  /// @brief Record that an entity moved within the owner's storage
+  ///
+  /// @param handle
+  /// @param position
+  ///
+  void Place(Handle handle, std::size_t position) noexcept;
+
+  ///
+  /// @brief Stop tracking every entity
+  ///
+  void Clear() noexcept;
+
+  ///
+  /// @brief Check whether a handle still refers to a tracked entity
+  ///
+  /// @param handle
+  /// @return true IFF the entity has not been released
+  ///
+  [[nodiscard]] bool Valid(Handle handle) const noexcept;
+
+  ///
+  /// @brief Get the position of the entity a handle refers to
+  ///
+  /// @param handle
+  /// @return the position within the owner's storage, or nullopt if the handle is no longer valid
+  ///
+  [[nodiscard]] std::optional<std::size_t> Position(Handle handle) const noexcept;
+};
+
+} // namespace model
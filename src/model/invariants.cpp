@@ -0,0 +1,295 @@
+#include "invariants.hpp"
+
+#include "model/class.hpp"
+#include "model/diagram.hpp"
+#include "utils/parallel.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <ranges>
+
+namespace model {
+
+static std::vector<std::string> Evaluate(Query const& query, Diagram const& diagram, Class const& cls) {
+  std::vector<std::string> matches;
+  query.ExecuteFor(diagram, cls, [&](QueryMatch const& match) { matches.push_back(std::format("{}", match)); });
+  return matches;
+}
+
+InvariantEngine& InvariantEngine::GetInstance() noexcept {
+  static InvariantEngine engine;
+  return engine;
+}
+
+Result<void> InvariantEngine::Add(std::string_view name, Query query) {
+  if (rules_.contains(name)) {
+    return std::unexpected{std::format("invariant '{}' already exists", name)};
+  }
+  switch (query.Access()) {
+  case QueryAccess::ClassName:
+  case QueryAccess::Outgoing:
+    owned_by_[query.AccessKey()].emplace(name);
+    break;
+  case QueryAccess::Incoming:
+    leading_to_[query.AccessKey()].emplace(name);
+    break;
+  default:
+    scanning_.emplace(name);
+    break;
+  }
+  rules_.emplace(name, Rule{.query = std::move(query)});
+  return {};
+}
+
+Result<void> InvariantEngine::Remove(std::string_view name) {
+  auto rule = rules_.find(name);
+  if (rule == rules_.end()) {
+    return std::unexpected{std::format("invariant '{}' does not exist", name)};
+  }
+  auto const unindex = [&](auto& index) {
+    if (auto i = index.find(rule->second.query.AccessKey()); i != index.end()) {
+      std::erase_if(i->second, [&](std::string const& r) { return r == name; });
+      if (i->second.empty()) {
+        index.erase(i);
+      }
+    }
+  };
+  unindex(owned_by_);
+  unindex(leading_to_);
+  std::erase_if(scanning_, [&](std::string const& r) { return r == name; });
+  for (auto i = violations_.begin(); i != violations_.end();) {
+    std::erase_if(i->second, [&](auto const& entry) { return entry.first == name; });
+    i = i->second.empty() ? violations_.erase(i) : std::next(i);
+  }
+  rules_.erase(rule);
+  return {};
+}
+
+bool InvariantEngine::Empty() const noexcept {
+  return rules_.empty();
+}
+
+std::vector<std::pair<std::string, std::string>> InvariantEngine::Invariants() const {
+  return std::ranges::to<std::vector>(std::views::transform(rules_, [](auto const& entry) {
+    return std::pair{entry.first, entry.second.query.Text()};
+  }));
+}
+
+std::set<std::string, std::less<>> InvariantEngine::Affected(Diagram const& diagram,
+                                                            std::string_view class_name) const {
+  std::set<std::string, std::less<>> affected{scanning_.begin(), scanning_.end()};
+  if (auto owned = owned_by_.find(class_name); owned != owned_by_.end()) {
+    affected.insert(owned->second.begin(), owned->second.end());
+  }
+  for (std::string_view dst : diagram.GetAdjacency().Outgoing(class_name)) {
+    if (auto leading = leading_to_.find(dst); leading != leading_to_.end()) {
+      affected.insert(leading->second.begin(), leading->second.end());
+    }
+  }
+  if (auto violated = violations_.find(class_name); violated != violations_.end()) {
+    for (std::string const& rule : std::views::keys(violated->second)) {
+      affected.insert(rule);
+    }
+  }
+  return affected;
+}
+
+void InvariantEngine::Store(std::string const& class_name,
+                            std::string const& rule_name,
+                            Matches matches,
+                            bool journal) {
+  auto by_class = violations_.find(class_name);
+  if (by_class == violations_.end()) {
+    if (matches.empty()) {
+      if (journal) {
+        replaced_.emplace_back(class_name, rule_name, Matches{});
+      }
+      return;
+    }
+    by_class = violations_.emplace(class_name, RuleMatches{}).first;
+  }
+  auto by_rule = by_class->second.find(rule_name);
+  if (journal) {
+    replaced_.emplace_back(class_name, rule_name, by_rule != by_class->second.end() ? by_rule->second : Matches{});
+  }
+  if (not matches.empty()) {
+    by_class->second.insert_or_assign(rule_name, std::move(matches));
+    return;
+  }
+  if (by_rule != by_class->second.end()) {
+    by_class->second.erase(by_rule);
+  }
+  if (by_class->second.empty()) {
+    violations_.erase(by_class);
+  }
+}
+
+std::vector<Violation> InvariantEngine::Check(Diagram const& diagram) {
+  replaced_all_.reset();
+  replaced_.clear();
+  evaluated_pending_.clear();
+  evaluations_ = 0;
+
+  std::vector<Violation> introduced;
+  auto const update = [&](std::string const& class_name,
+                          std::string const& rule_name,
+                          Matches matches,
+                          RuleMatches const* before) {
+    if (before != nullptr) {
+      auto const old = before->find(rule_name);
+      for (std::string const& match : matches) {
+        if (old == before->end() or not std::ranges::contains(old->second, match)) {
+          introduced.push_back(Violation{rule_name, match});
+        }
+      }
+    }
+    Store(class_name, rule_name, std::move(matches), not replaced_all_);
+  };
+  // evaluate some rules against every class, spread across threads
+  auto const evaluate_all = [&](std::vector<std::string> const& rule_names, bool baseline) {
+    auto const& classes = diagram.GetClasses();
+    auto const queries = std::ranges::to<std::vector>(std::views::transform(
+        rule_names, [&](std::string const& name) { return &rules_.find(name)->second.query; }));
+    std::vector<std::vector<Matches>> results(classes.size());
+    ParallelFor(classes.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+      for (std::size_t i{begin}; i < end; ++i) {
+        for (Query const* query : queries) {
+          results[i].push_back(Evaluate(*query, diagram, classes[i]));
+        }
+      }
+    });
+    RuleMatches const none;
+    for (std::size_t i{0}; i < classes.size(); ++i) {
+      RuleMatches const* before{nullptr};
+      if (not baseline) {
+        auto const old = replaced_all_->find(classes[i].Name());
+        before = old != replaced_all_->end() ? &old->second : &none;
+      }
+      for (std::size_t r{0}; r < rule_names.size(); ++r) {
+        update(classes[i].Name(), rule_names[r], std::move(results[i][r]), before);
+      }
+    }
+    evaluations_ += classes.size() * rule_names.size();
+  };
+
+  std::vector<std::string> established;
+  std::vector<std::string> pending;
+  for (auto const& [name, rule] : rules_) {
+    (rule.pending ? pending : established).push_back(name);
+  }
+
+  if (auto changed = diagram.GetChangeLog().Since(seen_); not changed) {
+    replaced_all_ = std::exchange(violations_, {});
+    evaluate_all(established, false);
+  } else {
+    std::ranges::sort(*changed);
+    for (std::string const& class_name : *changed) {
+      auto const cls = diagram.GetClass(class_name);
+      auto const old = violations_.find(class_name);
+      RuleMatches const before = old != violations_.end() ? old->second : RuleMatches{};
+      for (std::string const& rule_name : Affected(diagram, class_name)) {
+        if (auto rule = rules_.find(rule_name); rule != rules_.end() and not rule->second.pending) {
+          update(class_name, rule_name, cls ? Evaluate(rule->second.query, diagram, **cls) : Matches{}, &before);
+          ++evaluations_;
+        }
+      }
+    }
+  }
+
+  evaluate_all(pending, true);
+  for (std::string const& name : pending) {
+    rules_.find(name)->second.pending = false;
+  }
+  evaluated_pending_ = std::move(pending);
+  seen_ = diagram.GetChangeLog().Now();
+  return introduced;
+}
+
+void InvariantEngine::Revert(Diagram const& restored) {
+  if (replaced_all_) {
+    violations_ = std::move(*replaced_all_);
+  } else {
+    for (auto& [class_name, rule_name, matches] : std::views::reverse(replaced_)) {
+      Store(class_name, rule_name, std::move(matches), false);
+    }
+  }
+  for (std::string const& name : evaluated_pending_) {
+    if (auto rule = rules_.find(name); rule != rules_.end()) {
+      rule->second.pending = true;
+    }
+  }
+  replaced_all_.reset();
+  replaced_.clear();
+  evaluated_pending_.clear();
+  seen_ = restored.GetChangeLog().Now();
+}
+
+std::vector<Violation> InvariantEngine::Violations() const {
+  std::vector<Violation> violations;
+  for (RuleMatches const& by_rule : std::views::values(violations_)) {
+    for (auto const& [rule_name, matches] : by_rule) {
+      for (std::string const& match : matches) {
+        violations.push_back(Violation{rule_name, match});
+      }
+    }
+  }
+  return violations;
+}
+
+std::size_t InvariantEngine::Evaluations() const noexcept {
+  return evaluations_;
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::InvariantEngine") {
+  DOCTEST_TEST_CASE("model::InvariantEngine.Check") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("Serializable"));
+    REQUIRE(d.AddClass("A"));
+    REQUIRE(d.AddClass("B"));
+    REQUIRE(d.AddRelationship("A", "Serializable", model::RelationshipType::Realization));
+
+    model::InvariantEngine engine;
+    REQUIRE(engine.Add("serialize", *model::Query::FromString("classes:realizes=Serializable&method!=serialize")));
+    REQUIRE(engine.Add("small", *model::Query::FromString("classes:fields>2")));
+    CHECK_FALSE(engine.Add("small", *model::Query::FromString("classes")));
+    // violations of new invariants are not introduced by anything
+    CHECK(engine.Check(d).empty());
+    CHECK_EQ(engine.Violations(), std::vector<model::Violation>{{"serialize", "A"}});
+
+    REQUIRE(d.AddRelationship("B", "Serializable", model::RelationshipType::Realization));
+    CHECK_EQ(engine.Check(d), std::vector<model::Violation>{{"serialize", "B"}});
+    // B against both rules and Serializable (which changed as well) against the scanning rule
+    CHECK_EQ(engine.Evaluations(), 3);
+
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.AddMethod("serialize", "void", {}); }));
+    CHECK(engine.Check(d).empty());
+    CHECK_EQ(engine.Violations(), std::vector<model::Violation>{{"serialize", "B"}});
+
+    REQUIRE(d.DeleteClass("B"));
+    CHECK(engine.Check(d).empty());
+    CHECK(engine.Violations().empty());
+
+    REQUIRE(engine.Remove("serialize"));
+    CHECK_FALSE(engine.Remove("serialize"));
+    CHECK_EQ(engine.Invariants(), std::vector<std::pair<std::string, std::string>>{{"small", "classes:fields>2"}});
+  }
+  DOCTEST_TEST_CASE("model::InvariantEngine.Revert") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("A"));
+    model::InvariantEngine engine;
+    REQUIRE(engine.Add("no-int", *model::Query::FromString("fields:type=int")));
+    CHECK(engine.Check(d).empty());
+
+    model::Diagram const prior{d};
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.AddField("x", "int"); }));
+    CHECK_EQ(engine.Check(d), std::vector<model::Violation>{{"no-int", "A::x: int"}});
+    d = prior;
+    engine.Revert(d);
+    CHECK(engine.Violations().empty());
+    CHECK(engine.Check(d).empty());
+    CHECK_EQ(engine.Evaluations(), 0);
+  }
+}
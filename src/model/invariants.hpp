@@ -0,0 +1,149 @@
+#pragma once
+
+#include "model/change_log.hpp"
+#include "model/query.hpp"
+#include "utils/utils.hpp"
+
+#include <cstddef>
+#include <format>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace model {
+
+class Diagram;
+
+///
+/// @brief An entity matched by an invariant's query
+///
+struct Violation {
+  std::string invariant;
+  std::string entity;
+
+  [[nodiscard]] bool operator==(Violation const&) const = default;
+};
+
+///
+/// @brief Named invariants which are re-checked as the diagram changes
+///
+/// An invariant is a query whose matches are violations, e.g. `classes:realizes=Serializable&method!=serialize`
+/// lists the classes realizing Serializable without a serialize method. Results are cached per class and rule. A
+/// check re-evaluates, for every class recorded in the diagram's ChangeLog since the previous check, only the rules
+/// which could match something that class owns: rules keyed on that class, rules keyed on a class it has a
+/// relationship to, rules it previously violated, and rules which must scan every class.
+///
+class InvariantEngine {
+  struct Rule {
+    Query query;
+    /// whether the rule was added after the previous check and has not yet been evaluated
+    bool pending{true};
+  };
+
+  using Matches = std::vector<std::string>;
+  using RuleMatches = std::map<std::string, Matches, std::less<>>;
+
+  std::map<std::string, Rule, std::less<>> rules_;
+  /// class name -> rule name -> (non-empty) matches owned by the class
+  std::map<std::string, RuleMatches, std::less<>> violations_;
+  /// class name -> rules whose candidates are exactly that class or the relationships leaving it
+  std::map<std::string, std::set<std::string, std::less<>>, std::less<>> owned_by_;
+  /// class name -> rules whose candidates are the classes (or relationships) leading to that class
+  std::map<std::string, std::set<std::string, std::less<>>, std::less<>> leading_to_;
+  /// rules which must consider every class
+  std::set<std::string, std::less<>> scanning_;
+  ChangeLog::Cursor seen_;
+  std::size_t evaluations_{0};
+
+  /// how to undo the previous check: either everything it replaced or the entries it replaced
+  std::optional<std::map<std::string, RuleMatches, std::less<>>> replaced_all_;
+  std::vector<std::tuple<std::string, std::string, Matches>> replaced_;
+  std::vector<std::string> evaluated_pending_;
+
+  [[nodiscard]] std::set<std::string, std::less<>> Affected(Diagram const& diagram, std::string_view class_name) const;
+
+  void Store(std::string const& class_name, std::string const& rule_name, Matches matches, bool journal);
+
+public:
+  ///
+  /// @brief Singleton for InvariantEngine
+  ///
+  [[nodiscard]] static InvariantEngine& GetInstance() noexcept;
+
+  ///
+  /// @brief Add an invariant, which is first evaluated by the next check
+  ///
+  /// @param name the name of the invariant
+  /// @param query the query matching violations
+  /// @return error IFF an invariant with the name already exists
+  ///
+  [[nodiscard]] Result<void> Add(std::string_view name, Query query);
+
+  ///
+  /// @brief Remove an invariant and its violations
+  ///
+  /// @param name
+  /// @return error IFF the invariant doesn't exist
+  ///
+  [[nodiscard]] Result<void> Remove(std::string_view name);
+
+  ///
+  /// @brief Check whether any invariants exist
+  ///
+  [[nodiscard]] bool Empty() const noexcept;
+
+  ///
+  /// @brief Get every invariant as its name and query text
+  ///
+  [[nodiscard]] std::vector<std::pair<std::string, std::string>> Invariants() const;
+
+  ///
+  /// @brief Bring every invariant up to date with the diagram
+  ///
+  /// Violations of invariants added since the previous check are not considered to be introduced.
+  ///
+  /// @param diagram
+  /// @return the violations which did not exist at the previous check
+  ///
+  [[nodiscard]] std::vector<Violation> Check(Diagram const& diagram);
+
+  ///
+  /// @brief Undo the previous check after the diagram was restored to the state it was in before that check
+  ///
+  /// @param restored the restored diagram
+  ///
+  void Revert(Diagram const& restored);
+
+  ///
+  /// @brief Get every violation as of the previous check
+  ///
+  /// @return violations ordered by the owning class and then by invariant
+  ///
+  [[nodiscard]] std::vector<Violation> Violations() const;
+
+  ///
+  /// @brief Get the number of (class, invariant) pairs evaluated by the previous check
+  ///
+  [[nodiscard]] std::size_t Evaluations() const noexcept;
+};
+
+} // namespace model
+
+template <> struct std::formatter<model::Violation> {
+  template <typename FormatParseContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  constexpr inline auto parse(FormatParseContext& ctx) {
+    return ctx.begin();
+  }
+  template <typename FormatContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  auto format(model::Violation const& obj, FormatContext& ctx) const {
+    ctx.advance_to(std::format_to(ctx.out(), "[{}] {}", obj.invariant, obj.entity));
+    return ctx.out();
+  }
+};
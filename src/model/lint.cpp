@@ -0,0 +1,440 @@
+#include "lint.hpp"
+
+#include "model/class.hpp"
+#include "model/diagram.hpp"
+#include "model/field.hpp"
+#include "model/method.hpp"
+#include "model/parameter.hpp"
+#include "model/relationship.hpp"
+#include "model/relationship_type.hpp"
+#include "model/type_index.hpp"
+#include "utils/parallel.hpp"
+#include "utils/settings.hpp"
+#include "utils/utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+namespace model {
+
+LintContext::LintContext(Diagram const& diagram,
+                         TypeIndex const& types,
+                         Class const& cls,
+                         std::vector<Diagnostic>& diagnostics,
+                         std::set<std::string, std::less<>>& dependencies) noexcept
+    : diagram_{diagram}, types_{types}, cls_{cls}, diagnostics_{diagnostics}, dependencies_{dependencies} {
+}
+
+Diagram const& LintContext::GetDiagram() const noexcept {
+  return diagram_;
+}
+
+TypeIndex const& LintContext::GetTypeIndex() const noexcept {
+  return types_;
+}
+
+Class const& LintContext::GetClass() const noexcept {
+  return cls_;
+}
+
+void LintContext::DependOn(std::string_view class_name) {
+  if (class_name != cls_.Name() and not dependencies_.contains(class_name)) {
+    dependencies_.emplace(class_name);
+  }
+}
+
+void LintContext::Report(std::string message) {
+  diagnostics_.push_back(Diagnostic{std::string{rule_}, cls_.Name(), std::move(message)});
+}
+
+///
+/// @brief Check that a name is made of letters and digits only and starts with a letter of the expected case
+///
+static bool CamelCase(std::string_view name, bool capitalized) noexcept {
+  return not name.empty() and (capitalized ? InRange<'A', 'Z'>(name.front()) : InRange<'a', 'z'>(name.front())) and
+         std::ranges::all_of(name, [](char c) { return AlNum(c) and c != '_'; });
+}
+
+std::string_view NamingRule::Name() const noexcept {
+  return "naming";
+}
+
+void NamingRule::Check(LintContext& ctx) const {
+  Class const& cls = ctx.GetClass();
+  if (not CamelCase(cls.Name(), true)) {
+    ctx.Report("class name should be PascalCase");
+  }
+  for (Field const& f : cls.Fields()) {
+    if (not CamelCase(f.Name(), false)) {
+      ctx.Report(std::format("field '{}' should be camelCase", f.Name()));
+    }
+  }
+  for (Method const& m : cls.Methods()) {
+    if (not CamelCase(m.Name(), false)) {
+      ctx.Report(std::format("method '{}' should be camelCase", m.ToSignatureString()));
+    }
+    for (Parameter const& p : m.Parameters()) {
+      if (not CamelCase(p.Name(), false)) {
+        ctx.Report(std::format("parameter '{}' of '{}' should be camelCase", p.Name(), m.ToSignatureString()));
+      }
+    }
+  }
+}
+
+GodClassRule::GodClassRule(std::size_t max_members) noexcept : max_members_{max_members} {
+}
+
+std::string_view GodClassRule::Name() const noexcept {
+  return "god-class";
+}
+
+void GodClassRule::Check(LintContext& ctx) const {
+  Class const& cls = ctx.GetClass();
+  if (std::size_t const members{cls.Fields().size() + cls.Methods().size()}; members > max_members_) {
+    ctx.Report(std::format("has {} members (at most {} expected)", members, max_members_));
+  }
+}
+
+DanglingTypeRule::DanglingTypeRule(std::set<std::string, std::less<>> builtins) noexcept
+    : builtins_{std::move(builtins)} {
+}
+
+std::string_view DanglingTypeRule::Name() const noexcept {
+  return "dangling-type";
+}
+
+void DanglingTypeRule::Check(LintContext& ctx) const {
+  auto const& builtins = builtins_ ? *builtins_ : ctx.GetTypeIndex().Builtins();
+  std::set<std::string_view> reported;
+  for (std::string_view type : TypesOf(ctx.GetClass())) {
+    for (std::string_view identifier : TypeIdentifiers(type)) {
+      if (builtins.contains(identifier) or reported.contains(identifier)) {
+        continue;
+      }
+      // declared even when the class exists so that deleting it is noticed
+      ctx.DependOn(identifier);
+      if (not ctx.GetDiagram().GetClass(identifier)) {
+        ctx.Report(std::format("type '{}' does not name a class", identifier));
+        reported.insert(identifier);
+      }
+    }
+  }
+}
+
+InheritanceDepthRule::InheritanceDepthRule(std::size_t max_depth) noexcept : max_depth_{max_depth} {
+}
+
+std::string_view InheritanceDepthRule::Name() const noexcept {
+  return "inheritance-depth";
+}
+
+void InheritanceDepthRule::Check(LintContext& ctx) const {
+  Diagram const& diagram = ctx.GetDiagram();
+  auto const parents_of = [&](std::string_view name) {
+    return std::ranges::to<std::vector>(diagram.GetAdjacency().Outgoing(name) |
+                                        std::views::filter([&](std::string_view parent) {
+                                          auto r = diagram.GetReadOnlyRelationship(name, parent);
+                                          return r and (*r)->Type() == RelationshipType::Inheritance;
+                                        }));
+  };
+  // longest chain of ancestors, found depth-first while tracking the current path to detect cycles
+  std::map<std::string_view, std::size_t> depths;
+  std::set<std::string_view> path;
+  bool cyclic{false};
+  std::function<std::size_t(std::string_view)> depth_of = [&](std::string_view name) -> std::size_t {
+    if (auto known = depths.find(name); known != depths.end()) {
+      return known->second;
+    } else if (path.contains(name)) {
+      cyclic = true;
+      return 0;
+    }
+    ctx.DependOn(name);
+    path.insert(name);
+    std::size_t depth{0};
+    for (std::string_view parent : parents_of(name)) {
+      depth = std::max(depth, depth_of(parent) + 1);
+    }
+    path.erase(name);
+    depths.emplace(name, depth);
+    return depth;
+  };
+  if (std::size_t const depth{depth_of(ctx.GetClass().Name())}; cyclic) {
+    ctx.Report("takes part in an inheritance cycle");
+  } else if (depth > max_depth_) {
+    ctx.Report(std::format("inheritance depth is {} (at most {} expected)", depth, max_depth_));
+  }
+}
+
+std::string_view UnusedClassRule::Name() const noexcept {
+  return "unused-class";
+}
+
+void UnusedClassRule::Check(LintContext& ctx) const {
+  Diagram const& diagram = ctx.GetDiagram();
+  Class const& cls = ctx.GetClass();
+  // the verdict for every class this one refers to depends on this one, so declare those as well: they are then
+  // re-linted whenever a reference from this class appears or disappears
+  for (std::string_view type : TypesOf(cls)) {
+    for (std::string_view identifier : TypeIdentifiers(type)) {
+      ctx.DependOn(identifier);
+    }
+  }
+  auto const outgoing = diagram.GetAdjacency().Outgoing(cls.Name());
+  auto const incoming = diagram.GetAdjacency().Incoming(cls.Name());
+  std::ranges::for_each(outgoing, [&](std::string_view name) { ctx.DependOn(name); });
+  std::ranges::for_each(incoming, [&](std::string_view name) { ctx.DependOn(name); });
+  auto users = ctx.GetTypeIndex().UsersOf(cls.Name());
+  std::erase(users, cls.Name());
+  std::ranges::for_each(users, [&](std::string_view name) { ctx.DependOn(name); });
+  if (outgoing.empty() and incoming.empty() and users.empty()) {
+    ctx.Report("is not used by any relationship or type");
+  }
+}
+
+Linter::Linter()
+    : Linter(std::vector<std::shared_ptr<LintRule const>>{std::make_shared<NamingRule>(),
+                                                         std::make_shared<GodClassRule>(),
+                                                         std::make_shared<DanglingTypeRule>(),
+                                                         std::make_shared<InheritanceDepthRule>(),
+                                                         std::make_shared<UnusedClassRule>()}) {
+}
+
+Linter::Linter(std::vector<std::shared_ptr<LintRule const>> rules) noexcept : rules_{std::move(rules)} {
+}
+
+Linter& Linter::GetInstance() noexcept {
+  static Linter linter;
+  return linter;
+}
+
+void Linter::AddRule(std::shared_ptr<LintRule const> rule) {
+  rules_.push_back(std::move(rule));
+  seen_ = {};
+}
+
+Linter::Report Linter::Lint(Diagram const& diagram, TypeIndex const& types, Class const& cls) const {
+  Report report;
+  LintContext ctx{diagram, types, cls, report.diagnostics, report.dependencies};
+  for (auto const& rule : rules_) {
+    ctx.rule_ = rule->Name();
+    rule->Check(ctx);
+  }
+  return report;
+}
+
+std::set<std::string, std::less<>> Linter::Forget(std::string_view class_name) {
+  auto report = reports_.find(class_name);
+  if (report == reports_.end()) {
+    return {};
+  }
+  auto dependencies = std::move(report->second.dependencies);
+  reports_.erase(report);
+  for (std::string const& dependency : dependencies) {
+    if (auto d = dependents_.find(dependency); d != dependents_.end()) {
+      if (auto i = d->second.find(class_name); i != d->second.end()) {
+        d->second.erase(i);
+      }
+      if (d->second.empty()) {
+        dependents_.erase(d);
+      }
+    }
+  }
+  return dependencies;
+}
+
+void Linter::Remember(std::string const& class_name, Report report) {
+  for (std::string const& dependency : report.dependencies) {
+    dependents_[dependency].insert(class_name);
+  }
+  reports_.insert_or_assign(class_name, std::move(report));
+}
+
+std::vector<Diagnostic> Linter::Run(Diagram const& diagram, TypeIndex const& types) {
+  std::set<std::string, std::less<>> pending;
+  if (auto changed = diagram.GetChangeLog().Since(seen_); changed and types.Builtins() == builtins_) {
+    for (std::string& name : *changed) {
+      if (auto d = dependents_.find(name); d != dependents_.end()) {
+        pending.insert(d->second.begin(), d->second.end());
+      }
+      pending.insert(std::move(name));
+    }
+  } else {
+    reports_.clear();
+    dependents_.clear();
+    pending = std::ranges::to<std::set<std::string, std::less<>>>(diagram.GetClassNames());
+  }
+
+  relinted_ = 0;
+  std::set<std::string, std::less<>> done;
+  while (not pending.empty()) {
+    auto const work = std::ranges::to<std::vector>(std::exchange(pending, {}));
+    done.insert(work.begin(), work.end());
+    std::vector<std::optional<Report>> fresh(work.size());
+    ParallelFor(work.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+      for (std::size_t i{begin}; i < end; ++i) {
+        if (auto c = diagram.GetClass(work[i]); c) {
+          fresh[i] = Lint(diagram, types, **c);
+        }
+      }
+    });
+    for (auto&& [name, report] : std::views::zip(work, fresh)) {
+      auto const before = Forget(name);
+      auto const after = report ? report->dependencies : std::set<std::string, std::less<>>{};
+      std::vector<std::string> flipped;
+      std::ranges::set_symmetric_difference(before, after, std::back_inserter(flipped));
+      for (std::string& other : flipped) {
+        if (not done.contains(other)) {
+          pending.insert(std::move(other));
+        }
+      }
+      if (report) {
+        Remember(name, std::move(*report));
+        ++relinted_;
+      }
+    }
+  }
+  seen_ = diagram.GetChangeLog().Now();
+  builtins_ = types.Builtins();
+
+  std::vector<Diagnostic> diagnostics;
+  for (Report const& report : std::views::values(reports_)) {
+    diagnostics.insert(diagnostics.end(), report.diagnostics.begin(), report.diagnostics.end());
+  }
+  return diagnostics;
+}
+
+std::size_t Linter::Relinted() const noexcept {
+  return relinted_;
+}
+
+} // namespace model
+
+static std::vector<std::string> Formatted(std::vector<model::Diagnostic> const& diagnostics) {
+  return std::ranges::to<std::vector>(
+      std::views::transform(diagnostics, [](model::Diagnostic const& d) { return std::format("{}", d); }));
+}
+
+DOCTEST_TEST_SUITE("model::Lint") {
+  DOCTEST_TEST_CASE("model::NamingRule") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("Good"));
+    REQUIRE(d.AddClass("bad_name"));
+    REQUIRE(d.EditClass("Good", [](model::Class& c) { return c.AddField("okField", "int"); }));
+    REQUIRE(d.EditClass("Good", [](model::Class& c) { return c.AddField("Bad", "int"); }));
+    REQUIRE(d.EditClass("Good", [](model::Class& c) {
+      return c.AddMethod("run", "void", {*model::Parameter::From("x_y", "int")});
+    }));
+    model::Linter linter{{std::make_shared<model::NamingRule>()}};
+    CHECK_EQ(Formatted(linter.Run(d, d.GetTypeIndex())),
+             std::vector<std::string>{"[naming] Good: field 'Bad' should be camelCase",
+                                      "[naming] Good: parameter 'x_y' of 'run(int)' should be camelCase",
+                                      "[naming] bad_name: class name should be PascalCase"});
+  }
+  DOCTEST_TEST_CASE("model::GodClassRule") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("A"));
+    for (int i{0}; i < 3; ++i) {
+      REQUIRE(d.EditClass("A", [&](model::Class& c) { return c.AddField(std::format("f{}", i), "int"); }));
+    }
+    model::Linter linter{{std::make_shared<model::GodClassRule>(2)}};
+    CHECK_EQ(Formatted(linter.Run(d, d.GetTypeIndex())),
+             std::vector<std::string>{"[god-class] A: has 3 members (at most 2 expected)"});
+  }
+  DOCTEST_TEST_CASE("model::DanglingTypeRule") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("A"));
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.AddField("b", "vector<B*>"); }));
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.AddField("c", "int"); }));
+    model::Linter linter{{std::make_shared<model::DanglingTypeRule>()}};
+    CHECK_EQ(Formatted(linter.Run(d, d.GetTypeIndex())),
+             std::vector<std::string>{"[dangling-type] A: type 'B' does not name a class"});
+    REQUIRE(d.AddClass("B"));
+    CHECK(linter.Run(d, d.GetTypeIndex()).empty());
+    CHECK_EQ(linter.Relinted(), 2);
+    REQUIRE(d.DeleteClass("B"));
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 1);
+  }
+  DOCTEST_TEST_CASE("model::DanglingTypeRule.ConfiguredBuiltins") {
+    ScopedSettings const scope;
+    model::Diagram d;
+    REQUIRE(d.AddClass("A"));
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.AddField("m", "Money"); }));
+    model::Linter linter{{std::make_shared<model::DanglingTypeRule>()}};
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 1);
+    // nothing changed but the builtins, which is enough to lint again
+    REQUIRE(Settings::GetInstance().Set("builtins", "Money"));
+    CHECK(linter.Run(d, d.GetTypeIndex()).empty());
+    CHECK_EQ(linter.Relinted(), 1);
+  }
+  DOCTEST_TEST_CASE("model::InheritanceDepthRule") {
+    model::Diagram d;
+    for (auto name : {"A", "B", "C", "D"}) {
+      REQUIRE(d.AddClass(name));
+    }
+    REQUIRE(d.AddRelationship("A", "B", model::RelationshipType::Inheritance));
+    REQUIRE(d.AddRelationship("B", "C", model::RelationshipType::Inheritance));
+    REQUIRE(d.AddRelationship("C", "D", model::RelationshipType::Aggregation));
+    model::Linter linter{{std::make_shared<model::InheritanceDepthRule>(1)}};
+    CHECK_EQ(Formatted(linter.Run(d, d.GetTypeIndex())),
+             std::vector<std::string>{"[inheritance-depth] A: inheritance depth is 2 (at most 1 expected)"});
+    REQUIRE(d.EditRelationship("C", "D", [](model::Relationship& r) {
+      r.ChangeType(model::RelationshipType::Inheritance);
+      return Result<void>{};
+    }));
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 2);
+    REQUIRE(d.AddRelationship("D", "A", model::RelationshipType::Inheritance));
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 4);
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).front().message, "takes part in an inheritance cycle");
+  }
+  DOCTEST_TEST_CASE("model::UnusedClassRule") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("A"));
+    REQUIRE(d.AddClass("B"));
+    REQUIRE(d.AddClass("C"));
+    REQUIRE(d.AddRelationship("A", "B", model::RelationshipType::Aggregation));
+    model::Linter linter{{std::make_shared<model::UnusedClassRule>()}};
+    CHECK_EQ(Formatted(linter.Run(d, d.GetTypeIndex())),
+             std::vector<std::string>{"[unused-class] C: is not used by any relationship or type"});
+    // C becomes used without itself changing
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.AddField("c", "C"); }));
+    CHECK(linter.Run(d, d.GetTypeIndex()).empty());
+    // A, B (which depends on A through the relationship), and C
+    CHECK_EQ(linter.Relinted(), 3);
+    REQUIRE(d.EditClass("A", [](model::Class& c) { return c.DeleteField("c"); }));
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 1);
+  }
+  DOCTEST_TEST_CASE("model::Linter.Run") {
+    model::Diagram d;
+    for (int i{0}; i < 100; ++i) {
+      REQUIRE(d.AddClass(std::format("C{}", i)));
+    }
+    model::Linter linter;
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 100);
+    CHECK_EQ(linter.Relinted(), 100);
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 100);
+    CHECK_EQ(linter.Relinted(), 0);
+    REQUIRE(d.AddRelationship("C1", "C2", model::RelationshipType::Aggregation));
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 98);
+    CHECK_EQ(linter.Relinted(), 2);
+    // restoring an earlier state (as undo does) keeps the change epoch, so only what differs is linted again
+    model::Diagram const prior{d};
+    auto const cursor = d.GetChangeLog().Now();
+    REQUIRE(d.AddRelationship("C3", "C4", model::RelationshipType::Aggregation));
+    auto const changed = d.GetChangeLog().Since(cursor);
+    REQUIRE(changed);
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 96);
+    d.Restore(prior, *changed);
+    CHECK_EQ(linter.Run(d, d.GetTypeIndex()).size(), 98);
+    CHECK_EQ(linter.Relinted(), 2);
+    // whereas a copy starts a new change epoch and is linted from scratch
+    model::Diagram const copy{d};
+    CHECK_EQ(linter.Run(copy, copy.GetTypeIndex()).size(), 98);
+    CHECK_EQ(linter.Relinted(), 100);
+  }
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "model/change_log.hpp"
+
+#include <cstddef>
+#include <format>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace model {
+
+class Class;
+class Diagram;
+class TypeIndex;
+
+///
+/// @brief A single problem found by a lint rule
+///
+struct Diagnostic {
+  std::string rule;
+  std::string class_name;
+  std::string message;
+};
+
+///
+/// @brief What a lint rule may observe and report while checking one class
+///
+class LintContext {
+  Diagram const& diagram_;
+  TypeIndex const& types_;
+  Class const& cls_;
+  std::string_view rule_;
+  std::vector<Diagnostic>& diagnostics_;
+  std::set<std::string, std::less<>>& dependencies_;
+
+  friend class Linter;
+
+public:
+  LintContext(Diagram const& diagram,
+              TypeIndex const& types,
+              Class const& cls,
+              std::vector<Diagnostic>& diagnostics,
+              std::set<std::string, std::less<>>& dependencies) noexcept;
+
+  [[nodiscard]] Diagram const& GetDiagram() const noexcept;
+
+  ///
+  /// @brief Get the type index of the diagram, refreshed before the run was split across threads
+  ///
+  [[nodiscard]] TypeIndex const& GetTypeIndex() const noexcept;
+
+  [[nodiscard]] Class const& GetClass() const noexcept;
+
+  ///
+  /// @brief Declare that the verdict for this class depends on another class
+  ///
+  /// The class is linted again whenever the named class changes, appears, or disappears. A class's own changes are
+  /// always tracked and need not be declared.
+  ///
+  /// @param class_name
+  ///
+  void DependOn(std::string_view class_name);
+
+  ///
+  /// @brief Report a problem with the class being checked
+  ///
+  /// @param message
+  ///
+  void Report(std::string message);
+};
+
+///
+/// @brief A check applied to every class of a diagram
+///
+/// Rules are invoked concurrently for different classes and must not modify shared state.
+///
+class LintRule {
+public:
+  virtual ~LintRule() = default;
+
+  ///
+  /// @brief Get the name which identifies the rule in diagnostics
+  ///
+  [[nodiscard]] virtual std::string_view Name() const noexcept = 0;
+
+  ///
+  /// @brief Check one class, reporting problems and declaring dependencies through the context
+  ///
+  /// @param ctx
+  ///
+  virtual void Check(LintContext& ctx) const = 0;
+};
+
+///
+/// @brief Classes are PascalCase; fields, methods, and parameters are camelCase
+///
+class NamingRule final : public LintRule {
+public:
+  [[nodiscard]] std::string_view Name() const noexcept override;
+  void Check(LintContext& ctx) const override;
+};
+
+///
+/// @brief Classes should not accumulate too many members
+///
+class GodClassRule final : public LintRule {
+  std::size_t max_members_;
+
+public:
+  explicit GodClassRule(std::size_t max_members = 20) noexcept;
+  [[nodiscard]] std::string_view Name() const noexcept override;
+  void Check(LintContext& ctx) const override;
+};
+
+///
+/// @brief Every identifier in a member's type should name a class of the diagram or a builtin type
+///
+class DanglingTypeRule final : public LintRule {
+  /// the builtins to accept, or nullopt for those configured (as the type index was refreshed with)
+  std::optional<std::set<std::string, std::less<>>> builtins_;
+
+public:
+  DanglingTypeRule() noexcept = default;
+  explicit DanglingTypeRule(std::set<std::string, std::less<>> builtins) noexcept;
+  [[nodiscard]] std::string_view Name() const noexcept override;
+  void Check(LintContext& ctx) const override;
+};
+
+///
+/// @brief Inheritance chains should be shallow and acyclic
+///
+/// The source of an Inheritance relationship is taken to inherit from its destination.
+///
+class InheritanceDepthRule final : public LintRule {
+  std::size_t max_depth_;
+
+public:
+  explicit InheritanceDepthRule(std::size_t max_depth = 5) noexcept;
+  [[nodiscard]] std::string_view Name() const noexcept override;
+  void Check(LintContext& ctx) const override;
+};
+
+///
+/// @brief Every class should take part in a relationship or be used as a type by another class
+///
+class UnusedClassRule final : public LintRule {
+public:
+  [[nodiscard]] std::string_view Name() const noexcept override;
+  void Check(LintContext& ctx) const override;
+};
+
+///
+/// @brief Applies a set of lint rules to a diagram, re-linting only what changed since the previous run
+///
+/// Each class's diagnostics are cached along with the classes its rules declared a dependency on. A run re-lints the
+/// classes recorded in the diagram's ChangeLog since the previous run plus their dependents, and then any class
+/// whose dependency on a re-linted class appeared or disappeared (so that, e.g., a class becoming used is noticed).
+/// Re-linting is spread across threads per class.
+///
+class Linter {
+  struct Report {
+    std::vector<Diagnostic> diagnostics;
+    std::set<std::string, std::less<>> dependencies;
+  };
+
+  std::vector<std::shared_ptr<LintRule const>> rules_;
+  ChangeLog::Cursor seen_;
+  /// the builtins of the type index at the previous run, which rules may have consulted
+  std::set<std::string, std::less<>> builtins_;
+  std::map<std::string, Report, std::less<>> reports_;
+  /// class name -> classes whose reports depend on it
+  std::map<std::string, std::set<std::string, std::less<>>, std::less<>> dependents_;
+  std::size_t relinted_{0};
+
+  [[nodiscard]] Report Lint(Diagram const& diagram, TypeIndex const& types, Class const& cls) const;
+
+  std::set<std::string, std::less<>> Forget(std::string_view class_name);
+
+  void Remember(std::string const& class_name, Report report);
+
+public:
+  ///
+  /// @brief Create a linter with every builtin rule at its default settings
+  ///
+  Linter();
+
+  explicit Linter(std::vector<std::shared_ptr<LintRule const>> rules) noexcept;
+
+  ///
+  /// @brief Singleton for Linter
+  ///
+  [[nodiscard]] static Linter& GetInstance() noexcept;
+
+  ///
+  /// @brief Add a rule, discarding every cached result
+  ///
+  /// @param rule
+  ///
+  void AddRule(std::shared_ptr<LintRule const> rule);
+
+  ///
+  /// @brief Lint a diagram
+  ///
+  /// A change of builtins since the previous run re-lints every class.
+  ///
+  /// @param diagram
+  /// @param types the type index of the diagram, up to date (e.g. as returned by a non-const Diagram)
+  /// @return every diagnostic, ordered by class name and then by rule
+  ///
+  [[nodiscard]] std::vector<Diagnostic> Run(Diagram const& diagram, TypeIndex const& types);
+
+  ///
+  /// @brief Get the number of classes which were linted by the previous run
+  ///
+  [[nodiscard]] std::size_t Relinted() const noexcept;
+};
+
+} // namespace model
+
+template <> struct std::formatter<model::Diagnostic> {
+  template <typename FormatParseContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  constexpr inline auto parse(FormatParseContext& ctx) {
+    return ctx.begin();
+  }
+  template <typename FormatContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  auto format(model::Diagnostic const& obj, FormatContext& ctx) const {
+    ctx.advance_to(std::format_to(ctx.out(), "[{}] {}: {}", obj.rule, obj.class_name, obj.message));
+    return ctx.out();
+  }
+};
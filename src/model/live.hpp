@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <vector>
+
+namespace model {
+
+///
+/// @brief The entities of a diagram which have not been deleted, in order
+///
+/// A diagram keeps deleted entities in place until a non-const member function sweeps them away. While any are kept,
+/// the view holds the addresses of the live ones, so reading never modifies the diagram (and so never invalidates what
+/// another reader holds); otherwise it refers to the storage directly and costs nothing to take.
+///
+template <typename T> class Live {
+  std::span<T const> entities_;
+  std::vector<T const*> live_;
+  bool filtered_{false};
+
+public:
+  class Iterator {
+    Live const* live_{nullptr};
+    std::ptrdiff_t i_{0};
+
+  public:
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T const*;
+    using reference = T const&;
+
+    Iterator() noexcept = default;
+
+    Iterator(Live const* live, std::ptrdiff_t i) noexcept : live_{live}, i_{i} {
+    }
+
+    T const& operator*() const noexcept {
+      return (*live_)[static_cast<std::size_t>(i_)];
+    }
+
+    T const* operator->() const noexcept {
+      return &**this;
+    }
+
+    T const& operator[](std::ptrdiff_t n) const noexcept {
+      return *(*this + n);
+    }
+
+    Iterator& operator++() noexcept {
+      ++i_;
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      return {live_, i_++};
+    }
+
+    Iterator& operator--() noexcept {
+      --i_;
+      return *this;
+    }
+
+    Iterator operator--(int) noexcept {
+      return {live_, i_--};
+    }
+
+    Iterator& operator+=(std::ptrdiff_t n) noexcept {
+      i_ += n;
+      return *this;
+    }
+
+    Iterator& operator-=(std::ptrdiff_t n) noexcept {
+      i_ -= n;
+      return *this;
+    }
+
+    friend Iterator operator+(Iterator i, std::ptrdiff_t n) noexcept {
+      return i += n;
+    }
+
+    friend Iterator operator+(std::ptrdiff_t n, Iterator i) noexcept {
+      return i += n;
+    }
+
+    friend Iterator operator-(Iterator i, std::ptrdiff_t n) noexcept {
+      return i -= n;
+    }
+
+    friend std::ptrdiff_t operator-(Iterator const& a, Iterator const& b) noexcept {
+      return a.i_ - b.i_;
+    }
+
+    friend bool operator==(Iterator const& a, Iterator const& b) noexcept {
+      return a.i_ == b.i_;
+    }
+
+    friend std::strong_ordering operator<=>(Iterator const& a, Iterator const& b) noexcept {
+      return a.i_ <=> b.i_;
+    }
+  };
+
+  Live() noexcept = default;
+
+  ///
+  /// @brief View entities which are all live
+  ///
+  /// @param entities
+  ///
+  explicit Live(std::span<T const> entities) noexcept : entities_{entities} {
+  }
+
+  ///
+  /// @brief View the entities which have not been deleted
+  ///
+  /// @param entities
+  /// @param dead whether an entity has been deleted
+  ///
+  Live(std::span<T const> entities, std::predicate<T const&> auto const& dead) : entities_{entities}, filtered_{true} {
+    for (T const& entity : entities) {
+      if (not dead(entity)) {
+        live_.push_back(&entity);
+      }
+    }
+  }
+
+  [[nodiscard]] T const& operator[](std::size_t i) const noexcept {
+    return filtered_ ? *live_[i] : entities_[i];
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept {
+    return filtered_ ? live_.size() : entities_.size();
+  }
+
+  [[nodiscard]] bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  [[nodiscard]] T const& front() const noexcept {
+    return (*this)[0];
+  }
+
+  [[nodiscard]] T const& back() const noexcept {
+    return (*this)[size() - 1];
+  }
+
+  [[nodiscard]] Iterator begin() const noexcept {
+    return {this, 0};
+  }
+
+  [[nodiscard]] Iterator end() const noexcept {
+    return {this, static_cast<std::ptrdiff_t>(size())};
+  }
+
+  template <std::ranges::input_range R> [[nodiscard]] friend bool operator==(Live const& live, R const& other) {
+    return std::ranges::equal(live, other);
+  }
+};
+
+} // namespace model
@@ -3,12 +3,15 @@
 #include "model/checking.hpp"
 #include "model/method_signature.hpp"
 #include "model/parameter.hpp"
+#include "utils/binary.hpp"
+#include "utils/json.hpp"
 #include "utils/utils.hpp"
 
 #include <doctest/doctest.h>
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <ranges>
 #include <stdexcept>
@@ -30,91 +33,167 @@ void to_json(nlohmann ::json& json, const Method& m) {
   json["name"] = m.Name();
   json["return_type"] = m.ReturnType();
   json["params"] = m.Parameters();
+  if (m.provenance_.Known()) {
+    json["modified"] = m.provenance_;
+  }
 }
 
 // NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(const nlohmann ::json& json, Method& m) {
-  auto res = Method::From(json.at("name").get<std::string>(),
-                          json.at("return_type").get<std::string>(),
-                          json.at("params").get<std::vector<Parameter>>())
-                 .transform([&](Method method) { m = std::move(method); });
+  auto res = Method::FromJson(json).transform([&](Method method) { m = std::move(method); });
   if (not res) {
     throw std::invalid_argument{res.error()};
   }
 }
 
+Result<Method> Method::FromJson(nlohmann::json const& json) {
+  auto const parameters = [](nlohmann::json const& value) { return JsonElements(value, Parameter::FromJson); };
+  return JsonMember(json, "name", JsonString)
+      .and_then([&](std::string_view name) {
+        return JsonMember(json, "return_type", JsonString).and_then([&](std::string_view return_type) {
+          return JsonMember(json, "params", parameters).and_then([&](std::vector<Parameter> params) {
+            return From(name, return_type, std::move(params));
+          });
+        });
+      })
+      .and_then([&](Method m) {
+        return ModifiedFromJson(json).transform([&](Provenance modified) {
+          m.provenance_ = modified;
+          return std::move(m);
+        });
+      });
+}
+
+void Method::Encode(BinaryWriter& out) const {
+  out.String(data_->name);
+  out.String(data_->return_type);
+  out.Elements(data_->parameters, &Parameter::Encode);
+  provenance_.Encode(out);
+}
+
+Result<Method> Method::Decode(BinaryReader& in) {
+  return in.String().and_then([&](std::string_view name) {
+    return in.String().and_then([&](std::string_view return_type) {
+      return in.Elements(&Parameter::Decode).and_then([&](std::vector<Parameter> parameters) {
+        return Provenance::Decode(in).transform([&](Provenance modified) {
+          Method m;
+          m.data_ = Shared<Data>{Data{std::string{name}, std::string{return_type}, std::move(parameters)}};
+          m.provenance_ = modified;
+          return m;
+        });
+      });
+    });
+  });
+}
+
 Result<Method> Method::From(std::string_view name, std::string_view return_type, std::vector<Parameter> parameters) {
   return Check<ValidIdentifier>(name, "method name")
       .and_then([&] { return Check<ValidType>(return_type, "method return type"); })
       .and_then([&] { return Check(parameters); })
       .transform([&] {
         Method m;
-        m.name_ = name;
-        m.return_type_ = return_type;
-        m.parameters_ = std::move(parameters);
+        m.data_ = Shared<Data>{Data{std::string{name}, std::string{return_type}, std::move(parameters)}};
         return m;
       });
 }
 
+bool Method::Data::operator==(Data const& other) const noexcept {
+  // Parameter equality only considers names, but storage may only be shared if the types match as well
+  auto const same = [](Parameter const& a, Parameter const& b) {
+    return a.Name() == b.Name() and a.Type() == b.Type();
+  };
+  return name == other.name and return_type == other.return_type and
+         std::ranges::equal(parameters, other.parameters, same);
+}
+
+std::size_t Method::Data::Hash() const noexcept {
+  std::hash<std::string> const hasher;
+  std::size_t hash{hasher(name) ^ (hasher(return_type) << 1U)};
+  for (Parameter const& p : parameters) {
+    hash = (hash * 31) ^ hasher(p.Name());
+    hash = (hash * 31) ^ hasher(p.Type());
+  }
+  return hash;
+}
+
 std::string const& Method::Name() const noexcept {
-  return name_;
+  return data_->name;
 }
 std::string const& Method::ReturnType() const noexcept {
-  return return_type_;
+  return data_->return_type;
 }
 std::vector<Parameter> const& Method::Parameters() const noexcept {
-  return parameters_;
+  return data_->parameters;
+}
+
+Method::Data& Method::Edit() {
+  MarkModified();
+  return data_.Edit();
 }
 
 Result<void> Method::AddParameter(std::string_view parameter_name, std::string_view parameter_type) {
   return Parameter::From(parameter_name, parameter_type).and_then([&](Parameter p) -> Result<void> {
-    if (std::ranges::find(parameters_, p) != parameters_.end()) {
+    if (std::ranges::find(Parameters(), p) != Parameters().end()) {
       return std::unexpected{"adding duplicate parameter"};
     } else {
-      parameters_.push_back(std::move(p));
+      Edit().parameters.push_back(std::move(p));
+      data_.Share();
       return {};
     }
   });
 }
 
 Result<void> Method::ClearParameters() {
-  parameters_.clear();
+  Edit().parameters.clear();
+  data_.Share();
   return {};
 }
 
 Result<void> Method::RemoveParameter(std::vector<Parameter>::const_iterator iter) {
-  parameters_.erase(iter);
+  // iter may refer to shared storage, so locate it by index within our own copy
+  auto const index = std::distance(Parameters().begin(), iter);
+  auto& parameters = Edit().parameters;
+  parameters.erase(std::next(parameters.begin(), index));
+  data_.Share();
   return {};
 }
 
 Result<void> Method::Rename(std::string_view name) {
-  return Check<ValidIdentifier>(name, "method name").transform([&] { name_ = name; });
+  return Check<ValidIdentifier>(name, "method name").transform([&] {
+    Edit().name = name;
+    data_.Share();
+  });
 }
 
 Result<void> Method::RenameParameter(std::string_view parameter_name, std::string_view new_name) {
   return GetParameter(parameter_name).and_then([&](auto p) -> Result<void> {
-    if (std::ranges::contains(parameters_, new_name, &Parameter::Name)) {
+    if (std::ranges::contains(Parameters(), new_name, &Parameter::Name)) {
       return std::unexpected{"duplicate parameter name"};
     } else {
-      return p->Rename(new_name);
+      auto res = p->Rename(new_name);
+      data_.Share();
+      return res;
     }
   });
 }
 
 Result<void> Method::ChangeReturnType(std::string_view new_type) {
-  return Check<ValidType>(new_type, "method return type").transform([&] { return_type_ = new_type; });
+  return Check<ValidType>(new_type, "method return type").transform([&] {
+    Edit().return_type = new_type;
+    data_.Share();
+  });
 }
 
 Result<std::vector<Parameter>::iterator> Method::GetParameter(std::string_view parameter_name) {
-  if (auto i = std::ranges::find(parameters_, parameter_name, &Parameter::Name); i != parameters_.end()) {
-    return i;
-  } else {
+  if (not std::ranges::contains(Parameters(), parameter_name, &Parameter::Name)) {
     return std::unexpected{std::format("method parameter '{}' does not exist", parameter_name)};
   }
+  auto& parameters = Edit().parameters;
+  return std::ranges::find(parameters, parameter_name, &Parameter::Name);
 }
 
 Result<std::vector<Parameter>::const_iterator> Method::GetReadOnlyParameter(std::string_view parameter_name) const {
-  if (auto i = std::ranges::find(parameters_, parameter_name, &Parameter::Name); i != parameters_.end()) {
+  if (auto i = std::ranges::find(Parameters(), parameter_name, &Parameter::Name); i != Parameters().end()) {
     return i;
   } else {
     return std::unexpected{std::format("method parameter '{}' does not exist", parameter_name)};
@@ -122,11 +201,34 @@ Result<std::vector<Parameter>::const_iterator> Method::GetReadOnlyParameter(std:
 }
 
 std::size_t Method::GetParameterIndex(std::vector<Parameter>::const_iterator i) const {
-  return static_cast<std::size_t>(std::distance(parameters_.begin(), i));
+  return static_cast<std::size_t>(std::distance(Parameters().begin(), i));
 }
 
 [[nodiscard]] Result<void> Method::ChangeParameters(std::vector<Parameter> parameters) {
-  return Check(parameters).transform([&] { parameters_ = std::move(parameters); });
+  return Check(parameters).transform([&] {
+    Edit().parameters = std::move(parameters);
+    data_.Share();
+  });
+}
+
+void Method::Share() {
+  data_.Share();
+}
+
+bool Method::SharesWith(Method const& other) const noexcept {
+  return data_.SharesWith(other.data_);
+}
+
+Provenance const& Method::LastModified() const noexcept {
+  return provenance_;
+}
+
+Handle Method::GetHandle() const noexcept {
+  return handle_;
+}
+
+void Method::MarkModified() noexcept {
+  ProvenanceScope::Mark(provenance_);
 }
 
 Result<Method> Method::FromString(std::string_view str) {
@@ -161,20 +263,20 @@ Result<Method> Method::FromString(std::string_view str) {
 }
 
 std::string Method::ToSignatureString() const {
-  MethodSignature sig(name_, std::ranges::to<std::vector>(std::views::transform(parameters_, &Parameter::Type)));
+  MethodSignature sig(Name(), std::ranges::to<std::vector>(std::views::transform(Parameters(), &Parameter::Type)));
   return std::format("{}", sig);
 }
 
 std::strong_ordering Method::operator<=>(Method const& other) const noexcept {
-  auto res = (name_ <=> other.name_);
+  auto res = (Name() <=> other.Name());
   if (res != 0) {
     return res;
   }
-  res = (parameters_.size() <=> other.parameters_.size());
+  res = (Parameters().size() <=> other.Parameters().size());
   if (res != 0) {
     return res;
   }
-  for (auto [p1, p2] : std::views::zip(parameters_, other.parameters_)) {
+  for (auto [p1, p2] : std::views::zip(Parameters(), other.Parameters())) {
     res = (p1.Type() <=> p2.Type());
     if (res != 0) {
       break;
@@ -183,16 +285,16 @@ std::strong_ordering Method::operator<=>(Method const& other) const noexcept {
   if (res != 0) {
     return res;
   }
-  return return_type_ <=> other.return_type_;
+  return ReturnType() <=> other.ReturnType();
 }
 
 bool Method::operator==(Method const& other) const noexcept {
-  return (name_ == other.name_) and
-         std::ranges::equal(parameters_, other.parameters_, {}, &Parameter::Type, &Parameter::Type);
+  return (Name() == other.Name()) and
+         std::ranges::equal(Parameters(), other.Parameters(), {}, &Parameter::Type, &Parameter::Type);
 }
 
 bool Method::operator==(MethodSignature const& sig) const noexcept {
-  return (name_ == sig.Name()) and std::ranges::equal(parameters_, sig.ParameterTypes(), {}, &Parameter::Type);
+  return (Name() == sig.Name()) and std::ranges::equal(Parameters(), sig.ParameterTypes(), {}, &Parameter::Type);
 }
 
 } // namespace model
@@ -439,6 +541,31 @@ DOCTEST_TEST_SUITE("model::Method") {
       }
     }
   }
+  DOCTEST_TEST_CASE("model::Method.Share") {
+    ScopedSettings const scope;
+    REQUIRE(Settings::GetInstance().Set("hash-consing", "on"));
+    auto a = model::Method::FromString("f(a:int,b:str)->void");
+    auto b = model::Method::FromString("f(a:int,b:str)->void");
+    auto c = model::Method::FromString("f(x:int,y:str)->void");
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+    CHECK(a->SharesWith(*b));
+    // equal signatures but different parameter names must not share
+    CHECK_FALSE(a->SharesWith(*c));
+
+    auto p = b->GetParameter("a");
+    REQUIRE(p);
+    REQUIRE((*p)->ChangeType("float"));
+    b->Share();
+    CHECK_FALSE(a->SharesWith(*b));
+    CHECK_EQ(a->Parameters()[0].Type(), "int");
+    CHECK_EQ(b->Parameters()[0].Type(), "float");
+
+    REQUIRE(c->RenameParameter("x", "a"));
+    REQUIRE(c->RenameParameter("y", "b"));
+    CHECK(a->SharesWith(*c));
+  }
   DOCTEST_TEST_CASE("model::Method.Format") {
     auto m = model::Method::FromString("f(a:int,b:str)->void");
     REQUIRE(m.has_value());
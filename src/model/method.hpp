@@ -1,7 +1,10 @@
 #pragma once
 
+#include "model/handles.hpp"
 #include "model/method_signature.hpp"
 #include "model/parameter.hpp"
+#include "model/provenance.hpp"
+#include "utils/shared.hpp"
 #include "utils/utils.hpp"
 
 #include <nlohmann/json_fwd.hpp>
@@ -12,17 +15,37 @@
 #include <string_view>
 #include <utility>
 
+class BinaryReader;
+class BinaryWriter;
+
 namespace model {
 
 class Method {
-  std::string name_;
-  std::string return_type_;
-  std::vector<Parameter> parameters_;
+  struct Data {
+    std::string name;
+    std::string return_type;
+    std::vector<Parameter> parameters;
+
+    [[nodiscard]] bool operator==(Data const&) const noexcept;
+
+    [[nodiscard]] std::size_t Hash() const noexcept;
+  };
+
+  Shared<Data> data_;
+  Provenance provenance_;
+  /// allocated by the class the method belongs to
+  Handle handle_;
+
+  ///
+  /// @brief Get our own copy of the data to modify, marking the method as modified
+  ///
+  [[nodiscard]] Data& Edit();
 
   //NOLINTBEGIN(readability-identifier-naming)
   friend void to_json(nlohmann::json&, Method const&);
   friend void from_json(nlohmann::json const&, Method&);
   //NOLINTEND(readability-identifier-naming)
+  friend class Class;
 
 public:
   ///
@@ -36,6 +59,29 @@ public:
   [[nodiscard]] static Result<Method>
   From(std::string_view name, std::string_view return_type, std::vector<Parameter> parameters);
 
+  ///
+  /// @brief Create a method from its JSON representation without throwing
+  ///
+  /// @param json
+  /// @return error (prefixed by the location of the offending value) if the JSON is malformed or validation failed
+  ///
+  [[nodiscard]] static Result<Method> FromJson(nlohmann::json const& json);
+
+  ///
+  /// @brief Append the method to a binary buffer, to be read back by Decode
+  ///
+  /// @param out
+  ///
+  void Encode(BinaryWriter& out) const;
+
+  ///
+  /// @brief Read a method written by Encode, taking it as it was written rather than validating it again
+  ///
+  /// @param in
+  /// @return error if the buffer is truncated or corrupt
+  ///
+  [[nodiscard]] static Result<Method> Decode(BinaryReader& in);
+
   [[nodiscard]] std::string const& Name() const noexcept;
   [[nodiscard]] std::string const& ReturnType() const noexcept;
   [[nodiscard]] std::vector<Parameter> const& Parameters() const noexcept;
@@ -56,6 +102,8 @@ public:
   ///
   /// @brief Get an iterator to a parameter
   ///
+  /// This detaches the method from any storage it shares; call Share once modifications are complete.
+  ///
   /// @param parameter_name
   /// @return error if the name is malformed or if the parameter doesn't exist
   ///
@@ -134,6 +182,31 @@ public:
   ///
   [[nodiscard]] std::size_t GetParameterIndex(std::vector<model::Parameter>::const_iterator) const;
 
+  ///
+  /// @brief Share storage with every structurally identical method (no-op unless hash-consing is enabled)
+  ///
+  void Share();
+
+  ///
+  /// @brief Check whether two methods share the same storage
+  ///
+  [[nodiscard]] bool SharesWith(Method const& other) const noexcept;
+
+  ///
+  /// @brief Get the command which last modified the method
+  ///
+  [[nodiscard]] Provenance const& LastModified() const noexcept;
+
+  ///
+  /// @brief Get the handle of the method, which stays valid while the method belongs to its class
+  ///
+  [[nodiscard]] Handle GetHandle() const noexcept;
+
+  ///
+  /// @brief Record the active command (if any) as the last to modify the method
+  ///
+  void MarkModified() noexcept;
+
   ///
   /// @brief Parse a method from a string
   ///
@@ -0,0 +1,235 @@
+#include "name_index.hpp"
+
+#include "model/class.hpp"
+#include "model/diagram.hpp"
+#include "model/field.hpp"
+#include "model/method.hpp"
+#include "model/parameter.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <ranges>
+
+namespace model {
+
+static constexpr char Fold(char c) noexcept {
+  return InRange<'A', 'Z'>(c) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static bool ContainsFolded(std::string_view haystack, std::string_view needle) {
+  return not std::ranges::search(haystack, needle, {}, Fold, Fold).empty();
+}
+
+static void AppendTrigrams(std::string_view text, std::vector<std::uint32_t>& out) {
+  for (std::size_t i{0}; i + 3 <= text.size(); ++i) {
+    auto const byte = [&](std::size_t off) { return std::uint32_t{static_cast<unsigned char>(Fold(text[i + off]))}; };
+    out.push_back((byte(0) << 16U) | (byte(1) << 8U) | byte(2));
+  }
+}
+
+static void Deduplicate(std::vector<std::uint32_t>& trigrams) {
+  std::ranges::sort(trigrams);
+  auto const dups = std::ranges::unique(trigrams);
+  trigrams.erase(dups.begin(), dups.end());
+}
+
+std::vector<std::uint32_t> NameIndex::Trigrams(std::string_view text) {
+  std::vector<std::uint32_t> trigrams;
+  AppendTrigrams(text, trigrams);
+  Deduplicate(trigrams);
+  return trigrams;
+}
+
+void NameIndex::Remove(std::string_view class_name) {
+  auto contribution = contributions_.find(class_name);
+  if (contribution == contributions_.end()) {
+    return;
+  }
+  for (std::uint32_t trigram : contribution->second) {
+    if (auto posting = postings_.find(trigram); posting != postings_.end()) {
+      if (auto entry = posting->second.find(class_name); entry != posting->second.end()) {
+        posting->second.erase(entry);
+      }
+      if (posting->second.empty()) {
+        postings_.erase(posting);
+      }
+    }
+  }
+  contributions_.erase(contribution);
+}
+
+void NameIndex::Insert(Class const& cls) {
+  std::vector<std::uint32_t> trigrams;
+  AppendTrigrams(cls.Name(), trigrams);
+  for (Field const& f : cls.Fields()) {
+    AppendTrigrams(f.Name(), trigrams);
+  }
+  for (Method const& m : cls.Methods()) {
+    AppendTrigrams(m.Name(), trigrams);
+    for (Parameter const& p : m.Parameters()) {
+      AppendTrigrams(p.Name(), trigrams);
+    }
+  }
+  Deduplicate(trigrams);
+  for (std::uint32_t trigram : trigrams) {
+    postings_[trigram].insert(cls.Name());
+  }
+  contributions_.insert_or_assign(cls.Name(), std::move(trigrams));
+}
+
+void NameIndex::Invalidate(std::string_view class_name) {
+  if (not stale_.contains(class_name)) {
+    stale_.emplace(class_name);
+  }
+}
+
+void NameIndex::Erase(std::string_view class_name) {
+  Remove(class_name);
+  if (auto i = stale_.find(class_name); i != stale_.end()) {
+    stale_.erase(i);
+  }
+}
+
+void NameIndex::Reset(std::vector<Class> const& classes) {
+  postings_.clear();
+  contributions_.clear();
+  stale_.clear();
+  for (Class const& c : classes) {
+    stale_.insert(c.Name());
+  }
+}
+
+void NameIndex::Refresh(std::vector<Class> const& classes) {
+  for (std::string const& class_name : stale_) {
+    Remove(class_name);
+    if (auto c = std::ranges::lower_bound(classes, class_name, {}, &Class::Name);
+        c != classes.end() and c->Name() == class_name) {
+      Insert(*c);
+    }
+  }
+  stale_.clear();
+}
+
+bool NameIndex::Stale() const noexcept {
+  return not stale_.empty();
+}
+
+std::optional<std::vector<std::string>> NameIndex::Candidates(std::string_view text) const {
+  auto const trigrams = Trigrams(text);
+  if (trigrams.empty()) {
+    return std::nullopt;
+  }
+  std::vector<std::set<std::string, std::less<>> const*> postings;
+  for (std::uint32_t trigram : trigrams) {
+    if (auto posting = postings_.find(trigram); posting != postings_.end()) {
+      postings.push_back(&posting->second);
+    } else {
+      return std::vector<std::string>{};
+    }
+  }
+  // intersect starting from the rarest trigram so that the candidate set is as small as possible from the start
+  std::ranges::sort(postings, {}, [](auto const* posting) { return posting->size(); });
+  auto candidates = std::ranges::to<std::vector<std::string>>(*postings.front());
+  for (auto const* posting : postings | std::views::drop(1)) {
+    std::erase_if(candidates, [&](std::string const& name) { return not posting->contains(name); });
+  }
+  return candidates;
+}
+
+void Search(Diagram const& diagram, std::string_view text, std::function<void(NameMatch const&)> const& sink) {
+  auto const visit = [&](Class const& c) {
+    if (ContainsFolded(c.Name(), text)) {
+      sink(NameMatch{.owner = &c});
+    }
+    for (Field const& f : c.Fields()) {
+      if (ContainsFolded(f.Name(), text)) {
+        sink(NameMatch{.owner = &c, .field = &f});
+      }
+    }
+    for (Method const& m : c.Methods()) {
+      if (ContainsFolded(m.Name(), text)) {
+        sink(NameMatch{.owner = &c, .method = &m});
+      }
+      for (Parameter const& p : m.Parameters()) {
+        if (ContainsFolded(p.Name(), text)) {
+          sink(NameMatch{.owner = &c, .method = &m, .parameter = &p});
+        }
+      }
+    }
+  };
+  if (auto const candidates = diagram.GetNameIndex().Candidates(text); candidates) {
+    for (std::string const& name : *candidates) {
+      if (auto c = diagram.GetClass(name); c) {
+        visit(**c);
+      }
+    }
+  } else {
+    std::ranges::for_each(diagram.GetClasses(), visit);
+  }
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::NameIndex") {
+  DOCTEST_TEST_CASE("model::NameIndex.Trigrams") {
+    CHECK(model::NameIndex::Trigrams("").empty());
+    CHECK(model::NameIndex::Trigrams("ab").empty());
+    CHECK_EQ(model::NameIndex::Trigrams("abc").size(), 1);
+    CHECK_EQ(model::NameIndex::Trigrams("ABC"), model::NameIndex::Trigrams("abc"));
+    CHECK_EQ(model::NameIndex::Trigrams("aaaa").size(), 1);
+    CHECK_EQ(model::NameIndex::Trigrams("abcd").size(), 2);
+  }
+  DOCTEST_TEST_CASE("model::NameIndex.Candidates") {
+    std::vector<model::Class> classes;
+    classes.push_back(*model::Class::From("Account"));
+    classes.push_back(*model::Class::From("Customer"));
+    REQUIRE(classes[1].AddField("accountId", "int"));
+    REQUIRE(classes[1].AddMethod("open", "void", {*model::Parameter::From("initialBalance", "int")}));
+
+    model::NameIndex index;
+    index.Reset(classes);
+    CHECK(index.Stale());
+    index.Refresh(classes);
+    CHECK_FALSE(index.Stale());
+    CHECK_FALSE(index.Candidates("ac"));
+    CHECK_EQ(index.Candidates("count"), std::vector<std::string>{"Account", "Customer"});
+    CHECK_EQ(index.Candidates("BALANCE"), std::vector<std::string>{"Customer"});
+    CHECK_EQ(index.Candidates("zzz"), std::vector<std::string>{});
+
+    REQUIRE(classes[1].DeleteField("accountId"));
+    index.Invalidate("Customer");
+    index.Refresh(classes);
+    CHECK_EQ(index.Candidates("count"), std::vector<std::string>{"Account"});
+
+    index.Erase("Account");
+    CHECK_EQ(index.Candidates("count"), std::vector<std::string>{});
+  }
+  DOCTEST_TEST_CASE("model::Search") {
+    model::Diagram d;
+    REQUIRE(d.AddClass("Account"));
+    REQUIRE(d.AddClass("Customer"));
+    REQUIRE(d.EditClass("Customer", [](model::Class& c) { return c.AddField("accountId", "int"); }));
+    REQUIRE(d.EditClass("Customer", [](model::Class& c) {
+      return c.AddMethod("open", "void", {*model::Parameter::From("accountType", "int")});
+    }));
+    d.RefreshIndexes();
+    std::vector<std::string> found;
+    auto const collect = [&](model::NameMatch const& m) { found.push_back(std::format("{}", m)); };
+
+    model::Search(d, "ccount", collect);
+    CHECK_EQ(found,
+             std::vector<std::string>{"class Account",
+                                      "field Customer::accountId: int",
+                                      "parameter Customer::open(accountType: int) -> void accountType: int"});
+    found.clear();
+    model::Search(d, "pE", collect);
+    CHECK_EQ(found, std::vector<std::string>{"method Customer::open(accountType: int) -> void",
+                                             "parameter Customer::open(accountType: int) -> void accountType: int"});
+    found.clear();
+    REQUIRE(d.RenameClass("Account", "Ledger"));
+    d.RefreshIndexes();
+    model::Search(d, "ccount", collect);
+    CHECK_EQ(found.size(), 2);
+  }
+}
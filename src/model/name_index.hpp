@@ -0,0 +1,133 @@
+#pragma once
+
+#include "model/class.hpp"
+#include "model/field.hpp"
+#include "model/method.hpp"
+#include "model/parameter.hpp"
+
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace model {
+
+class Diagram;
+
+///
+/// @brief A case-insensitive trigram index over the names of every class and its fields, methods, and parameters
+///
+/// Like TypeIndex, mutations only mark a class as stale and Refresh re-indexes stale classes.
+///
+class NameIndex {
+  /// trigram -> classes having a name containing the trigram
+  std::unordered_map<std::uint32_t, std::set<std::string, std::less<>>> postings_;
+  /// class name -> distinct trigrams contributed when the class was last indexed
+  std::map<std::string, std::vector<std::uint32_t>, std::less<>> contributions_;
+  /// classes whose contributions are out of date
+  std::set<std::string, std::less<>> stale_;
+
+  void Remove(std::string_view class_name);
+
+  void Insert(Class const& cls);
+
+public:
+  ///
+  /// @brief Get the distinct trigrams of some text
+  ///
+  /// @param text
+  /// @return sorted, case-folded trigrams (empty if text is shorter than three characters)
+  ///
+  [[nodiscard]] static std::vector<std::uint32_t> Trigrams(std::string_view text);
+
+  ///
+  /// @brief Mark a class as needing to be re-indexed
+  ///
+  /// @param class_name
+  ///
+  void Invalidate(std::string_view class_name);
+
+  ///
+  /// @brief Remove every contribution of a class that no longer exists
+  ///
+  /// @param class_name
+  ///
+  void Erase(std::string_view class_name);
+
+  ///
+  /// @brief Discard the entire index and mark every class as stale
+  ///
+  /// @param classes the classes which will need to be indexed
+  ///
+  void Reset(std::vector<Class> const& classes);
+
+  ///
+  /// @brief Re-index every stale class
+  ///
+  /// @param classes all classes of the diagram, sorted by name
+  ///
+  void Refresh(std::vector<Class> const& classes);
+
+  ///
+  /// @brief Check whether any class has pending changes which are not yet reflected
+  ///
+  [[nodiscard]] bool Stale() const noexcept;
+
+  ///
+  /// @brief Get the classes which may have a name containing some text
+  ///
+  /// @param text the text to search for
+  /// @return sorted class names which contain every trigram of text, or nullopt if text is too short to be indexed
+  ///
+  [[nodiscard]] std::optional<std::vector<std::string>> Candidates(std::string_view text) const;
+};
+
+///
+/// @brief A name matched by a search: a class, or one of its fields, methods, or parameters
+///
+struct NameMatch {
+  Class const* owner{nullptr};
+  Field const* field{nullptr};
+  Method const* method{nullptr};
+  Parameter const* parameter{nullptr};
+};
+
+///
+/// @brief Find every class, field, method, and parameter whose name contains some text (ignoring case)
+///
+/// @param diagram the diagram to search, whose indexes are up to date (see Diagram::RefreshIndexes)
+/// @param text the text to search for
+/// @param sink invoked once per match in diagram order
+///
+void Search(Diagram const& diagram, std::string_view text, std::function<void(NameMatch const&)> const& sink);
+
+} // namespace model
+
+template <> struct std::formatter<model::NameMatch> {
+  template <typename FormatParseContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  constexpr inline auto parse(FormatParseContext& ctx) {
+    return ctx.begin();
+  }
+  template <typename FormatContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  auto format(model::NameMatch const& obj, FormatContext& ctx) const {
+    if (obj.parameter != nullptr) {
+      ctx.advance_to(
+          std::format_to(ctx.out(), "parameter {}::{: } {: }", obj.owner->Name(), *obj.method, *obj.parameter));
+    } else if (obj.method != nullptr) {
+      ctx.advance_to(std::format_to(ctx.out(), "method {}::{: }", obj.owner->Name(), *obj.method));
+    } else if (obj.field != nullptr) {
+      ctx.advance_to(std::format_to(ctx.out(), "field {}::{: }", obj.owner->Name(), *obj.field));
+    } else {
+      ctx.advance_to(std::format_to(ctx.out(), "class {}", obj.owner->Name()));
+    }
+    return ctx.out();
+  }
+};
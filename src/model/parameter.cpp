@@ -1,6 +1,8 @@
 #include "parameter.hpp"
 
 #include "model/checking.hpp"
+#include "utils/binary.hpp"
+#include "utils/json.hpp"
 #include "utils/utils.hpp"
 
 #include <doctest/doctest.h>
@@ -18,13 +20,34 @@ void to_json(nlohmann ::json& json, const Parameter& p) {
 
 // NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(const nlohmann ::json& json, Parameter& p) {
-  auto res = Parameter::From(json.at("name").get<std::string>(), json.at("type").get<std::string>())
-                 .transform([&](Parameter param) { p = std::move(param); });
+  auto res = Parameter::FromJson(json).transform([&](Parameter param) { p = std::move(param); });
   if (not res) {
     throw std::invalid_argument{res.error()};
   }
 }
 
+Result<Parameter> Parameter::FromJson(nlohmann::json const& json) {
+  return JsonMember(json, "name", JsonString).and_then([&](std::string_view name) {
+    return JsonMember(json, "type", JsonString).and_then([&](std::string_view type) { return From(name, type); });
+  });
+}
+
+void Parameter::Encode(BinaryWriter& out) const {
+  out.String(name_);
+  out.String(type_);
+}
+
+Result<Parameter> Parameter::Decode(BinaryReader& in) {
+  return in.String().and_then([&](std::string_view name) {
+    return in.String().transform([&](std::string_view type) {
+      Parameter param;
+      param.name_ = name;
+      param.type_ = type;
+      return param;
+    });
+  });
+}
+
 Result<Parameter> Parameter::From(std::string_view name, std::string_view type) {
   return Check<ValidIdentifier>(name, "parameter name").and_then([&] {
     return Check<ValidType>(type, "parameter type").transform([&] {
@@ -9,6 +9,9 @@
 #include <string>
 #include <string_view>
 
+class BinaryReader;
+class BinaryWriter;
+
 namespace model {
 
 class Parameter {
@@ -29,6 +32,29 @@ public:
   ///
   [[nodiscard]] static Result<Parameter> From(std::string_view name, std::string_view type);
 
+  ///
+  /// @brief Create a parameter from its JSON representation without throwing
+  ///
+  /// @param json
+  /// @return error (prefixed by the location of the offending value) if the JSON is malformed or validation failed
+  ///
+  [[nodiscard]] static Result<Parameter> FromJson(nlohmann::json const& json);
+
+  ///
+  /// @brief Append the parameter to a binary buffer, to be read back by Decode
+  ///
+  /// @param out
+  ///
+  void Encode(BinaryWriter& out) const;
+
+  ///
+  /// @brief Read a parameter written by Encode, taking it as it was written rather than validating it again
+  ///
+  /// @param in
+  /// @return error if the buffer is truncated or corrupt
+  ///
+  [[nodiscard]] static Result<Parameter> Decode(BinaryReader& in);
+
   ///
   /// @brief Construct a new Parameter object
   ///
@@ -0,0 +1,191 @@
+#include "paths.hpp"
+
+#include "model/adjacency.hpp"
+#include "model/diagram.hpp"
+#include "model/relationship.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <set>
+#include <span>
+#include <unordered_map>
+
+namespace model {
+
+/// whether the relationship from the first class to the second may be followed
+using EdgeFilter = std::function<bool(std::string_view, std::string_view)>;
+
+///
+/// @brief Bidirectional breadth-first search for a shortest path which only follows edges accepted by a filter
+///
+static std::optional<Path> Bidirectional(Adjacency const& adjacency,
+                                         std::string_view source,
+                                         std::string_view destination,
+                                         EdgeFilter const& usable) {
+  if (source == destination) {
+    return Path{{std::string{source}}};
+  }
+  // class -> the class it was reached from (empty for the origin of the search)
+  std::unordered_map<std::string_view, std::string_view> forward{{source, {}}};
+  std::unordered_map<std::string_view, std::string_view> backward{{destination, {}}};
+  std::vector<std::string_view> forward_frontier{source};
+  std::vector<std::string_view> backward_frontier{destination};
+  std::optional<std::string_view> meet;
+  while (not meet and not forward_frontier.empty() and not backward_frontier.empty()) {
+    // each step grows one search by a full level, so the first class reached by both lies on a shortest path
+    bool const outward{forward_frontier.size() <= backward_frontier.size()};
+    auto& frontier = outward ? forward_frontier : backward_frontier;
+    auto& reached = outward ? forward : backward;
+    auto const& other = outward ? backward : forward;
+    std::vector<std::string_view> next;
+    for (std::string_view node : frontier) {
+      for (std::string const& neighbor : outward ? adjacency.Successors(node) : adjacency.Predecessors(node)) {
+        if (reached.contains(neighbor) or not(outward ? usable(node, neighbor) : usable(neighbor, node))) {
+          continue;
+        }
+        reached.emplace(neighbor, node);
+        if (other.contains(neighbor)) {
+          meet = neighbor;
+          break;
+        }
+        next.push_back(neighbor);
+      }
+      if (meet) {
+        break;
+      }
+    }
+    frontier = std::move(next);
+  }
+  if (not meet) {
+    return std::nullopt;
+  }
+  Path path;
+  for (std::string_view c{*meet}; not c.empty(); c = forward.at(c)) {
+    path.classes.emplace_back(c);
+  }
+  std::ranges::reverse(path.classes);
+  for (std::string_view c{backward.at(*meet)}; not c.empty(); c = backward.at(c)) {
+    path.classes.emplace_back(c);
+  }
+  return path;
+}
+
+namespace {
+
+struct ShorterFirst {
+  bool operator()(Path const& a, Path const& b) const {
+    if (a.classes.size() != b.classes.size()) {
+      return a.classes.size() < b.classes.size();
+    }
+    return a.classes < b.classes;
+  }
+};
+
+} // namespace
+
+Result<std::vector<Path>> ShortestPaths(Diagram const& diagram,
+                                        std::string_view source,
+                                        std::string_view destination,
+                                        std::size_t k,
+                                        std::optional<RelationshipType> type) {
+  return diagram.GetClass(source)
+      .and_then([&](auto&&) { return diagram.GetClass(destination); })
+      .transform([&](auto&&) {
+        Adjacency const& adjacency = diagram.GetAdjacency();
+        auto const typed = [&](std::string_view from, std::string_view to) {
+          return not type or diagram.GetReadOnlyRelationship(from, to)
+                                 .transform([&](auto r) { return r->Type() == *type; })
+                                 .value_or(false);
+        };
+        std::vector<Path> found;
+        if (k == 0) {
+          return found;
+        }
+        if (auto first = Bidirectional(adjacency, source, destination, typed); first) {
+          found.push_back(std::move(*first));
+        }
+        // Yen's algorithm: deviate from the previous path at each of its classes in turn
+        std::set<Path, ShorterFirst> candidates;
+        while (not found.empty() and found.size() < k) {
+          Path const& previous = found.back();
+          for (std::size_t i{0}; i + 1 < previous.classes.size(); ++i) {
+            auto const root = std::span{previous.classes}.first(i + 1);
+            std::set<std::pair<std::string_view, std::string_view>> banned_edges;
+            for (Path const& p : found) {
+              if (p.classes.size() > i + 1 and std::ranges::equal(root, std::span{p.classes}.first(i + 1))) {
+                banned_edges.emplace(p.classes[i], p.classes[i + 1]);
+              }
+            }
+            // the deviation may not revisit the classes before it
+            std::set<std::string_view> const banned_classes(root.begin(), std::prev(root.end()));
+            auto const usable = [&](std::string_view from, std::string_view to) {
+              return not banned_classes.contains(from) and not banned_classes.contains(to) and
+                     not banned_edges.contains({from, to}) and typed(from, to);
+            };
+            if (auto spur = Bidirectional(adjacency, root.back(), destination, usable); spur) {
+              Path candidate{std::vector<std::string>(root.begin(), std::prev(root.end()))};
+              candidate.classes.insert(candidate.classes.end(), spur->classes.begin(), spur->classes.end());
+              if (not std::ranges::contains(found, candidate)) {
+                candidates.insert(std::move(candidate));
+              }
+            }
+          }
+          if (candidates.empty()) {
+            break;
+          }
+          found.push_back(std::move(candidates.extract(candidates.begin()).value()));
+        }
+        return found;
+      });
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::Paths") {
+  DOCTEST_TEST_CASE("model::ShortestPaths") {
+    model::Diagram d;
+    for (auto name : {"A", "B", "C", "D", "E"}) {
+      REQUIRE(d.AddClass(name));
+    }
+    REQUIRE(d.AddRelationship("A", "B", model::RelationshipType::Aggregation));
+    REQUIRE(d.AddRelationship("B", "D", model::RelationshipType::Aggregation));
+    REQUIRE(d.AddRelationship("A", "C", model::RelationshipType::Inheritance));
+    REQUIRE(d.AddRelationship("C", "D", model::RelationshipType::Inheritance));
+    REQUIRE(d.AddRelationship("A", "D", model::RelationshipType::Realization));
+    REQUIRE(d.AddRelationship("D", "E", model::RelationshipType::Composition));
+    auto const path = [](std::initializer_list<std::string> classes) { return model::Path{classes}; };
+
+    CHECK_EQ(model::ShortestPaths(d, "A", "E"), std::vector{path({"A", "D", "E"})});
+    CHECK_EQ(model::ShortestPaths(d, "A", "E", 5),
+             std::vector{path({"A", "D", "E"}), path({"A", "B", "D", "E"}), path({"A", "C", "D", "E"})});
+    CHECK_EQ(model::ShortestPaths(d, "A", "D", 1, model::RelationshipType::Inheritance),
+             std::vector{path({"A", "C", "D"})});
+    CHECK_EQ(model::ShortestPaths(d, "A", "E", 1, model::RelationshipType::Aggregation), std::vector<model::Path>{});
+    CHECK_EQ(model::ShortestPaths(d, "A", "A"), std::vector{path({"A"})});
+    CHECK_EQ(model::ShortestPaths(d, "E", "A"), std::vector<model::Path>{});
+    CHECK_EQ(model::ShortestPaths(d, "A", "E", 0), std::vector<model::Path>{});
+    CHECK_FALSE(model::ShortestPaths(d, "A", "Z"));
+    CHECK_FALSE(model::ShortestPaths(d, "Z", "A"));
+
+    CHECK_EQ(std::format("{}", path({"A", "D", "E"})), "A -> D -> E");
+  }
+  DOCTEST_TEST_CASE("model::ShortestPaths.Long") {
+    model::Diagram d;
+    constexpr int Length{500};
+    for (int i{0}; i <= Length; ++i) {
+      REQUIRE(d.AddClass(std::format("C{:03}", i)));
+    }
+    for (int i{0}; i < Length; ++i) {
+      auto const src = std::format("C{:03}", i);
+      auto const dst = std::format("C{:03}", i + 1);
+      REQUIRE(d.AddRelationship(src, dst, model::RelationshipType::Aggregation));
+    }
+    auto const paths = model::ShortestPaths(d, "C000", std::format("C{:03}", Length), 2);
+    REQUIRE(paths);
+    REQUIRE_EQ(paths->size(), 1);
+    CHECK_EQ(paths->front().classes.size(), Length + 1);
+  }
+}
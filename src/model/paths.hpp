@@ -0,0 +1,65 @@
+#pragma once
+
+#include "model/relationship_type.hpp"
+#include "utils/utils.hpp"
+
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace model {
+
+class Diagram;
+
+///
+/// @brief A chain of classes in which every class has a relationship to the next
+///
+struct Path {
+  std::vector<std::string> classes;
+
+  [[nodiscard]] bool operator==(Path const&) const = default;
+};
+
+///
+/// @brief Find the shortest relationship chains from one class to another
+///
+/// The first path is found with a bidirectional breadth-first search over the diagram's adjacency index, which
+/// expands whichever frontier is smaller and so visits far fewer classes than a one-sided search on large diagrams.
+/// Alternatives are found with Yen's algorithm, which re-runs the same search from every class of the previous path
+/// with the edges taken by already-found paths removed.
+///
+/// @param diagram the diagram to search
+/// @param source the class to start from
+/// @param destination the class to reach
+/// @param k the maximum number of paths to find
+/// @param type if present, only relationships of this type may be followed
+/// @return up to k loopless paths ordered by length (empty if destination is unreachable), or an error if either
+///         class doesn't exist
+///
+[[nodiscard]] Result<std::vector<Path>> ShortestPaths(Diagram const& diagram,
+                                                      std::string_view source,
+                                                      std::string_view destination,
+                                                      std::size_t k = 1,
+                                                      std::optional<RelationshipType> type = std::nullopt);
+
+} // namespace model
+
+template <> struct std::formatter<model::Path> {
+  template <typename FormatParseContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  constexpr inline auto parse(FormatParseContext& ctx) {
+    return ctx.begin();
+  }
+  template <typename FormatContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  auto format(model::Path const& obj, FormatContext& ctx) const {
+    for (char const* sep = ""; auto const& name : obj.classes) {
+      ctx.advance_to(std::format_to(ctx.out(), "{}{}", std::exchange(sep, " -> "), name));
+    }
+    return ctx.out();
+  }
+};
@@ -0,0 +1,136 @@
+#include "provenance.hpp"
+
+#include "utils/binary.hpp"
+#include "utils/json.hpp"
+
+#include <doctest/doctest.h>
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace model {
+
+/// each thread commits its own commands (e.g. tests, or a diagram edited off the main thread)
+static thread_local Provenance current;
+
+///
+/// @brief Get a copy of a command's name which lives as long as the program
+///
+/// @param name
+/// @return the interned name, shared by every entity loaded with the same command
+///
+static std::string_view Intern(std::string_view name) {
+  static std::mutex mutex;
+  static std::set<std::string, std::less<>> interned;
+  std::scoped_lock const lock{mutex};
+  if (auto i = interned.find(name); i != interned.end()) {
+    return *i;
+  }
+  return *interned.emplace(name).first;
+}
+
+bool Provenance::Known() const noexcept {
+  return not command.empty();
+}
+
+void Provenance::Encode(BinaryWriter& out) const {
+  out.Integer(step);
+  out.String(command);
+}
+
+Result<Provenance> Provenance::Decode(BinaryReader& in) {
+  return in.Integer<std::uint32_t>().and_then([&](std::uint32_t step) {
+    return in.String().transform([&](std::string_view command) {
+      return Provenance{.step = step, .command = Intern(command)};
+    });
+  });
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+void to_json(nlohmann::json& json, Provenance const& p) {
+  json = nlohmann::json::array({p.step, p.command});
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+void from_json(nlohmann::json const& json, Provenance& p) {
+  json.at(0).get_to(p.step);
+  p.command = Intern(json.at(1).get_ref<nlohmann::json::string_t const&>());
+}
+
+Result<Provenance> ModifiedFromJson(nlohmann::json const& entity) {
+  if (not entity.contains("modified")) {
+    return Provenance{};
+  }
+  return JsonMember(entity, "modified", [](nlohmann::json const& value) {
+    return JsonArray(value).and_then([](nlohmann::json::array_t const* pair) -> Result<Provenance> {
+      if (pair->size() != 2) {
+        return std::unexpected{"expected [step, command]"};
+      }
+      return JsonInteger<std::uint32_t>((*pair)[0]).and_then([&](std::uint32_t step) {
+        return JsonString((*pair)[1]).transform([&](std::string_view command) {
+          return Provenance{.step = step, .command = Intern(command)};
+        });
+      });
+    });
+  });
+}
+
+ProvenanceScope::ProvenanceScope(Provenance active) noexcept : previous_{current} {
+  current = active;
+}
+
+ProvenanceScope::~ProvenanceScope() noexcept {
+  current = previous_;
+}
+
+Provenance ProvenanceScope::Current() noexcept {
+  return current;
+}
+
+void ProvenanceScope::Mark(Provenance& last_modified) noexcept {
+  if (current.Known()) {
+    last_modified = current;
+  }
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::Provenance") {
+  DOCTEST_TEST_CASE("model::ProvenanceScope") {
+    model::Provenance p;
+    model::ProvenanceScope::Mark(p);
+    CHECK_FALSE(p.Known());
+    {
+      model::ProvenanceScope const outer{{.step = 1, .command = "class add"}};
+      {
+        model::ProvenanceScope const inner{{.step = 3, .command = "class delete"}};
+        CHECK_EQ(model::ProvenanceScope::Current(), model::Provenance{3, "class delete"});
+        // the scope is only active on the thread which opened it
+        std::thread{[] { CHECK_FALSE(model::ProvenanceScope::Current().Known()); }}.join();
+      }
+      model::ProvenanceScope::Mark(p);
+    }
+    CHECK_EQ(p, model::Provenance{1, "class add"});
+    CHECK_FALSE(model::ProvenanceScope::Current().Known());
+    model::ProvenanceScope::Mark(p);
+    CHECK_EQ(p, model::Provenance{1, "class add"});
+  }
+  DOCTEST_TEST_CASE("model::Provenance.Json") {
+    nlohmann::json json = model::Provenance{7, "class add"};
+    CHECK_EQ(json, R"([7, "class add"])"_json);
+    CHECK_EQ(json.get<model::Provenance>(), model::Provenance{7, "class add"});
+
+    auto const loaded = model::ModifiedFromJson(R"({"modified": [7, "field add"]})"_json);
+    CHECK_EQ(loaded, model::Provenance{7, "field add"});
+    // the text outlives the JSON it was read from, and is shared by every entity loaded with the same command
+    CHECK_EQ(model::ModifiedFromJson(R"({"modified": [1, "field add"]})"_json)->command.data(), loaded->command.data());
+    CHECK_EQ(model::ModifiedFromJson(R"({})"_json), model::Provenance{});
+    CHECK_FALSE(model::ModifiedFromJson(R"({"modified": [7, 3]})"_json));
+    CHECK_FALSE(model::ModifiedFromJson(R"({"modified": [7]})"_json));
+    CHECK_FALSE(model::ModifiedFromJson(R"({"modified": [7, null]})"_json));
+  }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "utils/utils.hpp"
+
+#include <nlohmann/json_fwd.hpp>
+
+#include <cstdint>
+#include <string_view>
+
+class BinaryReader;
+class BinaryWriter;
+
+namespace model {
+
+///
+/// @brief Which command last modified an entity
+///
+struct Provenance {
+  /// the position of the command in the timeline (1 for the first command)
+  std::uint32_t step{0};
+  /// the name of the command (e.g. "class add"), or empty if unknown
+  ///
+  /// The name is stored rather than a position in the list of commands, so it stays meaningful when commands are
+  /// added or reordered. It always has static storage: commands refer to their own syntax, and names read from a file
+  /// are interned.
+  std::string_view command;
+
+  [[nodiscard]] bool operator==(Provenance const&) const noexcept = default;
+
+  ///
+  /// @brief Check whether the entity was modified by a known command
+  ///
+  [[nodiscard]] bool Known() const noexcept;
+
+  ///
+  /// @brief Append the provenance to a binary buffer, to be read back by Decode
+  ///
+  /// @param out
+  ///
+  void Encode(BinaryWriter& out) const;
+
+  ///
+  /// @brief Read a provenance written by Encode, interning the name of the command
+  ///
+  /// @param in
+  /// @return error if the buffer is truncated or corrupt
+  ///
+  [[nodiscard]] static Result<Provenance> Decode(BinaryReader& in);
+};
+
+// NOLINTBEGIN(readability-identifier-naming)
+void to_json(nlohmann::json&, Provenance const&);
+void from_json(nlohmann::json const&, Provenance&);
+// NOLINTEND(readability-identifier-naming)
+
+///
+/// @brief Read the provenance stored in the optional "modified" member of an entity without throwing
+///
+/// @param entity the JSON object of a class, field, method, or relationship
+/// @return the stored provenance (unknown if absent), or an error if it is malformed
+///
+[[nodiscard]] Result<Provenance> ModifiedFromJson(nlohmann::json const& entity);
+
+///
+/// @brief Attributes every modification made while the scope is alive to a command
+///
+/// Entities call Mark whenever they are modified, which is a single copy of the active provenance. Outside of any
+/// scope nothing is recorded, so loading or editing a diagram directly leaves provenance untouched.
+///
+class ProvenanceScope {
+  Provenance previous_;
+
+public:
+  explicit ProvenanceScope(Provenance active) noexcept;
+  ~ProvenanceScope() noexcept;
+  ProvenanceScope(ProvenanceScope const&) = delete;
+  ProvenanceScope(ProvenanceScope&&) = delete;
+  ProvenanceScope& operator=(ProvenanceScope const&) = delete;
+  ProvenanceScope& operator=(ProvenanceScope&&) = delete;
+
+  ///
+  /// @brief Get the provenance of the active scope
+  ///
+  /// @return the provenance, which is not Known if there is no active scope
+  ///
+  [[nodiscard]] static Provenance Current() noexcept;
+
+  ///
+  /// @brief Record the active command (if any) as the last to modify an entity
+  ///
+  /// @param last_modified the entity's provenance
+  ///
+  static void Mark(Provenance& last_modified) noexcept;
+};
+
+} // namespace model
@@ -0,0 +1,598 @@
+#include "query.hpp"
+
+#include "model/class.hpp"
+#include "model/diagram.hpp"
+#include "model/field.hpp"
+#include "model/method.hpp"
+#include "model/parameter.hpp"
+#include "model/relationship.hpp"
+#include "model/relationship_type.hpp"
+#include "model/type_index.hpp"
+#include "utils/parallel.hpp"
+#include "utils/utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+namespace model {
+
+struct AttributeName {
+  QueryTarget target;
+  std::string_view name;
+  QueryAttribute attribute;
+  bool numeric{false};
+};
+
+constexpr static std::array TargetNames{std::pair{"classes", QueryTarget::Classes},
+                                        std::pair{"fields", QueryTarget::Fields},
+                                        std::pair{"methods", QueryTarget::Methods},
+                                        std::pair{"relationships", QueryTarget::Relationships}};
+
+constexpr static std::array AttributeNames{
+    AttributeName{QueryTarget::Classes, "name", QueryAttribute::ClassName},
+    AttributeName{QueryTarget::Classes, "fields", QueryAttribute::FieldCount, true},
+    AttributeName{QueryTarget::Classes, "methods", QueryAttribute::MethodCount, true},
+    AttributeName{QueryTarget::Classes, "field_type", QueryAttribute::FieldType},
+    AttributeName{QueryTarget::Classes, "param_type", QueryAttribute::ParamType},
+    AttributeName{QueryTarget::Classes, "return_type", QueryAttribute::ReturnType},
+    AttributeName{QueryTarget::Classes, "uses", QueryAttribute::Uses},
+    AttributeName{QueryTarget::Classes, "field", QueryAttribute::Field},
+    AttributeName{QueryTarget::Classes, "method", QueryAttribute::Method},
+    AttributeName{QueryTarget::Classes, "inherits", QueryAttribute::Inherits},
+    AttributeName{QueryTarget::Classes, "realizes", QueryAttribute::Realizes},
+    AttributeName{QueryTarget::Classes, "aggregates", QueryAttribute::Aggregates},
+    AttributeName{QueryTarget::Classes, "composes", QueryAttribute::Composes},
+    AttributeName{QueryTarget::Fields, "class", QueryAttribute::ClassName},
+    AttributeName{QueryTarget::Fields, "name", QueryAttribute::Name},
+    AttributeName{QueryTarget::Fields, "type", QueryAttribute::Type},
+    AttributeName{QueryTarget::Methods, "class", QueryAttribute::ClassName},
+    AttributeName{QueryTarget::Methods, "name", QueryAttribute::Name},
+    AttributeName{QueryTarget::Methods, "return_type", QueryAttribute::ReturnType},
+    AttributeName{QueryTarget::Methods, "param_type", QueryAttribute::ParamType},
+    AttributeName{QueryTarget::Methods, "params", QueryAttribute::ParamCount, true},
+    AttributeName{QueryTarget::Relationships, "source", QueryAttribute::Source},
+    AttributeName{QueryTarget::Relationships, "destination", QueryAttribute::Destination},
+    AttributeName{QueryTarget::Relationships, "type", QueryAttribute::Type}};
+
+static Result<QueryPredicate> ParsePredicate(QueryTarget target, std::string_view text) {
+  std::size_t const attr_end{text.find_first_of("=!~<>")};
+  if (attr_end == 0 or attr_end == std::string_view::npos) {
+    return std::unexpected{std::format("malformed predicate '{}'", text)};
+  }
+  std::string_view const attr{text.substr(0, attr_end)};
+  auto const info = std::ranges::find_if(
+      AttributeNames, [&](AttributeName const& a) { return a.target == target and a.name == attr; });
+  if (info == AttributeNames.end()) {
+    return std::unexpected{std::format("unknown attribute '{}' in predicate '{}'", attr, text)};
+  }
+  QueryPredicate pred{.attribute = info->attribute};
+  std::string_view rest{text.substr(attr_end)};
+  if (rest.starts_with('!')) {
+    pred.negated = true;
+    rest.remove_prefix(1);
+  }
+  if (rest.starts_with('=')) {
+    pred.op = QueryOperator::Equal;
+  } else if (rest.starts_with('~')) {
+    pred.op = QueryOperator::Contains;
+  } else if (rest.starts_with('<') and not pred.negated) {
+    pred.op = QueryOperator::Less;
+  } else if (rest.starts_with('>') and not pred.negated) {
+    pred.op = QueryOperator::Greater;
+  } else {
+    return std::unexpected{std::format("malformed operator in predicate '{}'", text)};
+  }
+  rest.remove_prefix(1);
+  if (rest.empty()) {
+    return std::unexpected{std::format("missing value in predicate '{}'", text)};
+  }
+  pred.value = rest;
+  if (info->numeric) {
+    if (pred.op == QueryOperator::Contains) {
+      return std::unexpected{std::format("'{}' is a count and cannot be searched for text", attr)};
+    }
+    return IntFromString(rest).transform([&](int n) {
+      pred.number = n;
+      return pred;
+    });
+  }
+  if (pred.op == QueryOperator::Less or pred.op == QueryOperator::Greater) {
+    return std::unexpected{std::format("'{}' is not a count and cannot be ordered", attr)};
+  }
+  if (pred.attribute == QueryAttribute::Type and target == QueryTarget::Relationships and
+      pred.op == QueryOperator::Equal) {
+    return RelationshipTypeFromString(rest).transform([&](auto&&) { return pred; });
+  }
+  return pred;
+}
+
+Result<Query> Query::FromString(std::string_view str) {
+  std::size_t const colon{str.find(':')};
+  std::string_view const target{str.substr(0, colon)};
+  auto const found = std::ranges::find(TargetNames, target, [](auto const& p) { return std::string_view{p.first}; });
+  if (found == TargetNames.end()) {
+    return std::unexpected{std::format("unknown query target '{}'", target)};
+  }
+  Query query;
+  query.target_ = found->second;
+  query.text_ = str;
+  if (colon != std::string_view::npos) {
+    if (colon + 1 == str.size()) {
+      return std::unexpected{std::format("query '{}' is missing predicates", str)};
+    }
+    for (auto part : std::views::split(str.substr(colon + 1), '&')) {
+      if (auto pred = ParsePredicate(query.target_, std::string_view{part.begin(), part.end()}); not pred) {
+        return std::unexpected{pred.error()};
+      } else {
+        query.predicates_.push_back(std::move(*pred));
+      }
+    }
+  }
+  query.Plan();
+  return query;
+}
+
+///
+/// @brief Rank how selective an access path is expected to be (lower is better)
+///
+static std::optional<std::pair<int, QueryAccess>> AccessFor(QueryTarget target, QueryPredicate const& pred) {
+  if (pred.negated or pred.op != QueryOperator::Equal) {
+    return std::nullopt;
+  }
+  switch (pred.attribute) {
+  case QueryAttribute::ClassName:
+    return std::pair{0, QueryAccess::ClassName};
+  case QueryAttribute::Source:
+    return std::pair{1, QueryAccess::Outgoing};
+  case QueryAttribute::Destination:
+    return std::pair{1, QueryAccess::Incoming};
+  case QueryAttribute::Inherits:
+  case QueryAttribute::Realizes:
+  case QueryAttribute::Aggregates:
+  case QueryAttribute::Composes:
+    return std::pair{2, QueryAccess::Incoming};
+  case QueryAttribute::Uses:
+  case QueryAttribute::FieldType:
+  case QueryAttribute::ParamType:
+  case QueryAttribute::ReturnType:
+    return std::pair{3, QueryAccess::TypeUsage};
+  case QueryAttribute::Type:
+    if (target != QueryTarget::Relationships) {
+      return std::pair{3, QueryAccess::TypeUsage};
+    }
+    return std::nullopt;
+  default:
+    return std::nullopt;
+  }
+}
+
+void Query::Plan() {
+  std::optional<int> best;
+  for (QueryPredicate const& pred : predicates_) {
+    if (auto access = AccessFor(target_, pred); access and (not best or access->first < *best)) {
+      best = access->first;
+      access_ = access->second;
+      access_key_ = pred.value;
+    }
+  }
+}
+
+QueryTarget Query::Target() const noexcept {
+  return target_;
+}
+
+QueryAccess Query::Access() const noexcept {
+  return access_;
+}
+
+std::vector<QueryPredicate> const& Query::Predicates() const noexcept {
+  return predicates_;
+}
+
+std::string const& Query::AccessKey() const noexcept {
+  return access_key_;
+}
+
+std::string const& Query::Text() const noexcept {
+  return text_;
+}
+
+static bool Compare(QueryPredicate const& pred, std::string_view text) {
+  switch (pred.op) {
+  case QueryOperator::Equal:
+    return text == pred.value;
+  case QueryOperator::Contains:
+    return text.contains(pred.value);
+  default:
+    return false;
+  }
+}
+
+static bool Compare(QueryPredicate const& pred, std::size_t count) {
+  switch (pred.op) {
+  case QueryOperator::Equal:
+    return std::cmp_equal(count, pred.number);
+  case QueryOperator::Less:
+    return std::cmp_less(count, pred.number);
+  case QueryOperator::Greater:
+    return std::cmp_greater(count, pred.number);
+  default:
+    return false;
+  }
+}
+
+static bool AnyOf(QueryPredicate const& pred, std::ranges::input_range auto&& texts) {
+  return std::ranges::any_of(texts, [&](std::string_view text) { return Compare(pred, text); });
+}
+
+static bool Uses(QueryPredicate const& pred, Class const& cls) {
+  auto const types = TypesOf(cls);
+  if (pred.op == QueryOperator::Contains) {
+    return AnyOf(pred, types);
+  }
+  return std::ranges::any_of(types, [&](std::string_view type) { return AnyOf(pred, TypeIdentifiers(type)); });
+}
+
+static bool Related(QueryPredicate const& pred, Class const& cls, Diagram const& diagram, RelationshipType type) {
+  return std::ranges::any_of(diagram.GetAdjacency().Outgoing(cls.Name()), [&](std::string_view dst) {
+    auto const rel = diagram.GetReadOnlyRelationship(cls.Name(), dst);
+    return rel and (*rel)->Type() == type and Compare(pred, dst);
+  });
+}
+
+static bool Holds(QueryPredicate const& pred, Class const& cls, Diagram const& diagram) {
+  auto const param_types = [&] {
+    return cls.Methods() | std::views::transform(&Method::Parameters) | std::views::join |
+           std::views::transform(&Parameter::Type);
+  };
+  switch (pred.attribute) {
+  case QueryAttribute::ClassName:
+    return Compare(pred, cls.Name());
+  case QueryAttribute::FieldCount:
+    return Compare(pred, cls.Fields().size());
+  case QueryAttribute::MethodCount:
+    return Compare(pred, cls.Methods().size());
+  case QueryAttribute::FieldType:
+    return AnyOf(pred, std::views::transform(cls.Fields(), &Field::Type));
+  case QueryAttribute::ParamType:
+    return AnyOf(pred, param_types());
+  case QueryAttribute::ReturnType:
+    return AnyOf(pred, std::views::transform(cls.Methods(), &Method::ReturnType));
+  case QueryAttribute::Uses:
+    return Uses(pred, cls);
+  case QueryAttribute::Field:
+    return AnyOf(pred, std::views::transform(cls.Fields(), &Field::Name));
+  case QueryAttribute::Method:
+    return AnyOf(pred, std::views::transform(cls.Methods(), &Method::Name));
+  case QueryAttribute::Inherits:
+    return Related(pred, cls, diagram, RelationshipType::Inheritance);
+  case QueryAttribute::Realizes:
+    return Related(pred, cls, diagram, RelationshipType::Realization);
+  case QueryAttribute::Aggregates:
+    return Related(pred, cls, diagram, RelationshipType::Aggregation);
+  case QueryAttribute::Composes:
+    return Related(pred, cls, diagram, RelationshipType::Composition);
+  default:
+    return false;
+  }
+}
+
+static bool Holds(QueryPredicate const& pred, Class const& owner, Field const& field) {
+  switch (pred.attribute) {
+  case QueryAttribute::ClassName:
+    return Compare(pred, owner.Name());
+  case QueryAttribute::Name:
+    return Compare(pred, field.Name());
+  case QueryAttribute::Type:
+    return Compare(pred, field.Type());
+  default:
+    return false;
+  }
+}
+
+static bool Holds(QueryPredicate const& pred, Class const& owner, Method const& method) {
+  switch (pred.attribute) {
+  case QueryAttribute::ClassName:
+    return Compare(pred, owner.Name());
+  case QueryAttribute::Name:
+    return Compare(pred, method.Name());
+  case QueryAttribute::ReturnType:
+    return Compare(pred, method.ReturnType());
+  case QueryAttribute::ParamType:
+    return AnyOf(pred, std::views::transform(method.Parameters(), &Parameter::Type));
+  case QueryAttribute::ParamCount:
+    return Compare(pred, method.Parameters().size());
+  default:
+    return false;
+  }
+}
+
+static bool Holds(QueryPredicate const& pred, Relationship const& rel) {
+  switch (pred.attribute) {
+  case QueryAttribute::Source:
+    return Compare(pred, rel.Source());
+  case QueryAttribute::Destination:
+    return Compare(pred, rel.Destination());
+  case QueryAttribute::Type:
+    return Compare(pred, std::format("{}", rel.Type()));
+  default:
+    return false;
+  }
+}
+
+///
+/// @brief Check that every predicate holds (or, when negated, does not hold)
+///
+static bool All(std::vector<QueryPredicate> const& predicates, auto const&... entity) {
+  return std::ranges::all_of(predicates,
+                             [&](QueryPredicate const& pred) { return Holds(pred, entity...) != pred.negated; });
+}
+
+///
+/// @brief Evaluate each candidate, delivering matches in candidate order
+///
+/// @param candidates the entities to evaluate
+/// @param produce invoked as produce(candidate, emit) where emit accepts a QueryMatch
+/// @param sink the consumer of the matches
+///
+template <typename Candidate, typename Produce>
+static void Stream(std::vector<Candidate> const& candidates,
+                   Produce const& produce,
+                   std::function<void(QueryMatch const&)> const& sink) {
+  std::size_t const chunks{ChunkCount(candidates.size())};
+  if (chunks == 1) {
+    for (Candidate const& candidate : candidates) {
+      produce(candidate, sink);
+    }
+    return;
+  }
+  std::vector<std::vector<QueryMatch>> results(chunks);
+  ParallelFor(candidates.size(), [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+    auto const emit = [&matches = results[chunk]](QueryMatch const& match) { matches.push_back(match); };
+    for (std::size_t i{begin}; i < end; ++i) {
+      produce(candidates[i], emit);
+    }
+  });
+  for (auto const& matches : results) {
+    std::ranges::for_each(matches, sink);
+  }
+}
+
+///
+/// @brief Pick the identifier of a type which is mentioned the fewest times across the diagram
+///
+static std::optional<std::string_view> RarestIdentifier(TypeIndex const& index, std::string_view type) {
+  auto const identifiers = TypeIdentifiers(type);
+  if (identifiers.empty()) {
+    return std::nullopt;
+  }
+  return *std::ranges::min_element(identifiers, {}, [&](std::string_view id) { return index.Mentions(id); });
+}
+
+///
+/// @brief Evaluate the entities owned by a class (itself, its members, or its outgoing relationships)
+///
+template <typename Emit>
+static void Produce(QueryTarget target,
+                    std::vector<QueryPredicate> const& predicates,
+                    Diagram const& diagram,
+                    Class const& c,
+                    Emit const& emit) {
+  switch (target) {
+  case QueryTarget::Classes:
+    if (All(predicates, c, diagram)) {
+      emit(&c);
+    }
+    break;
+  case QueryTarget::Fields:
+    for (Field const& f : c.Fields()) {
+      if (All(predicates, c, f)) {
+        emit(FieldMatch{&c, &f});
+      }
+    }
+    break;
+  case QueryTarget::Methods:
+    for (Method const& m : c.Methods()) {
+      if (All(predicates, c, m)) {
+        emit(MethodMatch{&c, &m});
+      }
+    }
+    break;
+  case QueryTarget::Relationships:
+    for (std::string_view dst : diagram.GetAdjacency().Outgoing(c.Name())) {
+      if (auto r = diagram.GetReadOnlyRelationship(c.Name(), dst); r and All(predicates, **r)) {
+        emit(std::to_address(*r));
+      }
+    }
+    break;
+  }
+}
+
+void Query::Execute(Diagram const& diagram, std::function<void(QueryMatch const&)> const& sink) const {
+  auto const class_ptr = [&](std::string_view name) -> Class const* {
+    auto const c = diagram.GetClass(name);
+    return c ? std::to_address(*c) : nullptr;
+  };
+  auto const rel_ptr = [&](std::string_view src, std::string_view dst) -> Relationship const* {
+    auto const r = diagram.GetReadOnlyRelationship(src, dst);
+    return r ? std::to_address(*r) : nullptr;
+  };
+
+  if (target_ == QueryTarget::Relationships) {
+    std::vector<Relationship const*> candidates;
+    if (access_ == QueryAccess::Outgoing) {
+      for (std::string_view dst : diagram.GetAdjacency().Outgoing(access_key_)) {
+        candidates.push_back(rel_ptr(access_key_, dst));
+      }
+    } else if (access_ == QueryAccess::Incoming) {
+      for (std::string_view src : diagram.GetAdjacency().Incoming(access_key_)) {
+        candidates.push_back(rel_ptr(src, access_key_));
+      }
+    } else {
+      candidates = std::ranges::to<std::vector>(
+          std::views::transform(diagram.GetRelationships(), [](Relationship const& r) { return &r; }));
+    }
+    std::erase(candidates, nullptr);
+    Stream(
+        candidates,
+        [&](Relationship const* r, auto const& emit) {
+          if (All(predicates_, *r)) {
+            emit(r);
+          }
+        },
+        sink);
+    return;
+  }
+
+  std::optional<std::string_view> const identifier{
+      access_ == QueryAccess::TypeUsage ? RarestIdentifier(diagram.GetTypeIndex(), access_key_) : std::nullopt};
+  std::vector<Class const*> candidates;
+  if (access_ == QueryAccess::ClassName) {
+    candidates.push_back(class_ptr(access_key_));
+  } else if (access_ == QueryAccess::Incoming) {
+    for (std::string_view src : diagram.GetAdjacency().Incoming(access_key_)) {
+      candidates.push_back(class_ptr(src));
+    }
+  } else if (identifier) {
+    for (std::string const& user : diagram.GetTypeIndex().UsersOf(*identifier)) {
+      candidates.push_back(class_ptr(user));
+    }
+  } else {
+    candidates = std::ranges::to<std::vector>(
+        std::views::transform(diagram.GetClasses(), [](Class const& c) { return &c; }));
+  }
+  std::erase(candidates, nullptr);
+
+  Stream(
+      candidates, [&](Class const* c, auto const& emit) { Produce(target_, predicates_, diagram, *c, emit); }, sink);
+}
+
+void Query::ExecuteFor(Diagram const& diagram,
+                       Class const& owner,
+                       std::function<void(QueryMatch const&)> const& sink) const {
+  Produce(target_, predicates_, diagram, owner, sink);
+}
+
+std::vector<QueryMatch> Query::Collect(Diagram const& diagram) const {
+  std::vector<QueryMatch> matches;
+  Execute(diagram, [&](QueryMatch const& match) { matches.push_back(match); });
+  return matches;
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::Query") {
+  static model::Diagram MakeDiagram() {
+    model::Diagram d;
+    REQUIRE(d.AddClass("Animal"));
+    REQUIRE(d.AddClass("Dog"));
+    REQUIRE(d.AddClass("Owner"));
+    REQUIRE(d.EditClass("Dog", [](model::Class& c) { return c.AddField("owner", "Owner"); }));
+    REQUIRE(d.EditClass("Dog", [](model::Class& c) { return c.AddField("age", "int"); }));
+    REQUIRE(d.EditClass("Owner", [](model::Class& c) { return c.AddField("pets", "vector<Dog>"); }));
+    REQUIRE(d.EditClass("Owner", [](model::Class& c) {
+      return c.AddMethod("adopt", "void", {*model::Parameter::From("a", "Animal")});
+    }));
+    REQUIRE(d.AddRelationship("Dog", "Animal", model::RelationshipType::Inheritance));
+    REQUIRE(d.AddRelationship("Owner", "Dog", model::RelationshipType::Aggregation));
+    d.RefreshIndexes();
+    return d;
+  }
+
+  static std::vector<std::string> Run(model::Diagram const& d, std::string_view text) {
+    auto query = model::Query::FromString(text);
+    REQUIRE(query);
+    return std::ranges::to<std::vector>(
+        std::views::transform(query->Collect(d), [](model::QueryMatch const& m) { return std::format("{}", m); }));
+  }
+
+  DOCTEST_TEST_CASE("model::Query.FromString") {
+    CHECK_FALSE(model::Query::FromString("things"));
+    CHECK_FALSE(model::Query::FromString("classes:"));
+    CHECK_FALSE(model::Query::FromString("classes:name"));
+    CHECK_FALSE(model::Query::FromString("classes:=a"));
+    CHECK_FALSE(model::Query::FromString("classes:name="));
+    CHECK_FALSE(model::Query::FromString("classes:bogus=a"));
+    CHECK_FALSE(model::Query::FromString("classes:name<a"));
+    CHECK_FALSE(model::Query::FromString("classes:fields~1"));
+    CHECK_FALSE(model::Query::FromString("classes:fields=x"));
+    CHECK_FALSE(model::Query::FromString("classes:fields!<1"));
+    CHECK_FALSE(model::Query::FromString("fields:fields=1"));
+    CHECK_FALSE(model::Query::FromString("relationships:type=Friendship"));
+    CHECK(model::Query::FromString("classes"));
+    CHECK(model::Query::FromString("relationships:type~ion"));
+    auto q = model::Query::FromString("classes:fields>1&name!~x");
+    REQUIRE(q);
+    CHECK_EQ(q->Target(), model::QueryTarget::Classes);
+    CHECK_EQ(q->Predicates().size(), 2);
+  }
+  DOCTEST_TEST_CASE("model::Query.Plan") {
+    CHECK_EQ(model::Query::FromString("classes")->Access(), model::QueryAccess::Scan);
+    CHECK_EQ(model::Query::FromString("classes:name!=a")->Access(), model::QueryAccess::Scan);
+    CHECK_EQ(model::Query::FromString("classes:uses=a&name=b")->Access(), model::QueryAccess::ClassName);
+    CHECK_EQ(model::Query::FromString("classes:uses=a")->Access(), model::QueryAccess::TypeUsage);
+    CHECK_EQ(model::Query::FromString("classes:inherits=a")->Access(), model::QueryAccess::Incoming);
+    CHECK_EQ(model::Query::FromString("fields:type=int")->Access(), model::QueryAccess::TypeUsage);
+    CHECK_EQ(model::Query::FromString("relationships:source=a")->Access(), model::QueryAccess::Outgoing);
+    CHECK_EQ(model::Query::FromString("relationships:destination=a")->Access(), model::QueryAccess::Incoming);
+    CHECK_EQ(model::Query::FromString("relationships:type=Inheritance")->Access(), model::QueryAccess::Scan);
+  }
+  DOCTEST_TEST_CASE("model::Query.Execute") {
+    auto const d = MakeDiagram();
+    CHECK_EQ(Run(d, "classes"), std::vector<std::string>{"Animal", "Dog", "Owner"});
+    CHECK_EQ(Run(d, "classes:name=Dog"), std::vector<std::string>{"Dog"});
+    CHECK_EQ(Run(d, "classes:name=Cat"), std::vector<std::string>{});
+    CHECK_EQ(Run(d, "classes:name~o"), std::vector<std::string>{"Dog"});
+    CHECK_EQ(Run(d, "classes:fields>0"), std::vector<std::string>{"Dog", "Owner"});
+    CHECK_EQ(Run(d, "classes:fields=0"), std::vector<std::string>{"Animal"});
+    CHECK_EQ(Run(d, "classes:uses=Dog"), std::vector<std::string>{"Owner"});
+    CHECK_EQ(Run(d, "classes:uses~int"), std::vector<std::string>{"Dog"});
+    CHECK_EQ(Run(d, "classes:param_type=Animal"), std::vector<std::string>{"Owner"});
+    CHECK_EQ(Run(d, "classes:field_type=vector<Dog>"), std::vector<std::string>{"Owner"});
+    CHECK_EQ(Run(d, "classes:field_type!=int"), std::vector<std::string>{"Animal", "Owner"});
+    CHECK_EQ(Run(d, "classes:inherits=Animal"), std::vector<std::string>{"Dog"});
+    CHECK_EQ(Run(d, "classes:aggregates=Dog&method=adopt"), std::vector<std::string>{"Owner"});
+    CHECK_EQ(Run(d, "fields:type=int"), std::vector<std::string>{"Dog::age: int"});
+    CHECK_EQ(Run(d, "fields:class=Dog&name!=age"), std::vector<std::string>{"Dog::owner: Owner"});
+    CHECK_EQ(Run(d, "methods:params=1"), std::vector<std::string>{"Owner::adopt(a: Animal) -> void"});
+    CHECK_EQ(Run(d, "relationships:source=Owner"), std::vector<std::string>{"Owner -> Dog (Aggregation)"});
+    CHECK_EQ(Run(d, "relationships:destination=Animal"), std::vector<std::string>{"Dog -> Animal (Inheritance)"});
+    CHECK_EQ(Run(d, "relationships:type=Inheritance"), std::vector<std::string>{"Dog -> Animal (Inheritance)"});
+  }
+  DOCTEST_TEST_CASE("model::Query.ExecuteFor") {
+    auto const d = MakeDiagram();
+    auto const run_for = [&](std::string_view text, std::string_view owner) {
+      auto query = model::Query::FromString(text);
+      REQUIRE(query);
+      CHECK_EQ(query->Text(), text);
+      std::vector<std::string> found;
+      query->ExecuteFor(
+          d, **d.GetClass(owner), [&](model::QueryMatch const& m) { found.push_back(std::format("{}", m)); });
+      return found;
+    };
+    CHECK_EQ(run_for("classes:inherits=Animal", "Dog"), std::vector<std::string>{"Dog"});
+    CHECK_EQ(run_for("classes:inherits=Animal", "Owner"), std::vector<std::string>{});
+    CHECK_EQ(run_for("fields", "Dog"), std::vector<std::string>{"Dog::age: int", "Dog::owner: Owner"});
+    CHECK_EQ(run_for("relationships", "Owner"), std::vector<std::string>{"Owner -> Dog (Aggregation)"});
+    CHECK_EQ(run_for("relationships", "Animal"), std::vector<std::string>{});
+  }
+  DOCTEST_TEST_CASE("model::Query.ExecuteParallel") {
+    model::Diagram d;
+    constexpr std::size_t Count{10'000};
+    for (std::size_t i{0}; i < Count; ++i) {
+      REQUIRE(d.AddClass(std::format("C{:05}", i)));
+    }
+    REQUIRE(d.EditClass("C04242", [](model::Class& c) { return c.AddField("x", "int"); }));
+    d.RefreshIndexes();
+    CHECK_EQ(Run(d, "classes:fields=1"), std::vector<std::string>{"C04242"});
+    CHECK_EQ(Run(d, "classes:fields=0").size(), Count - 1);
+    auto const all = Run(d, "classes");
+    CHECK(std::ranges::is_sorted(all));
+  }
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "model/class.hpp"
+#include "model/field.hpp"
+#include "model/method.hpp"
+#include "model/relationship.hpp"
+#include "utils/utils.hpp"
+
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace model {
+
+class Diagram;
+
+enum class QueryTarget : std::uint8_t { Classes, Fields, Methods, Relationships };
+
+enum class QueryAttribute : std::uint8_t {
+  ClassName,
+  Name,
+  Type,
+  FieldCount,
+  MethodCount,
+  ParamCount,
+  FieldType,
+  ParamType,
+  ReturnType,
+  Uses,
+  Field,
+  Method,
+  Inherits,
+  Realizes,
+  Aggregates,
+  Composes,
+  Source,
+  Destination
+};
+
+enum class QueryOperator : std::uint8_t { Equal, Contains, Less, Greater };
+
+///
+/// @brief How the candidates of a query are produced before predicates are evaluated
+///
+enum class QueryAccess : std::uint8_t {
+  Scan,      ///< visit everything of the target kind
+  ClassName, ///< look up a single class by name
+  TypeUsage, ///< visit the classes which mention an identifier within a type
+  Outgoing,  ///< visit the relationships (or classes) leaving a class
+  Incoming   ///< visit the relationships (or classes) entering a class
+};
+
+struct QueryPredicate {
+  QueryAttribute attribute{QueryAttribute::Name};
+  QueryOperator op{QueryOperator::Equal};
+  bool negated{false};
+  std::string value;
+  int number{0};
+};
+
+struct FieldMatch {
+  Class const* owner;
+  Field const* field;
+};
+
+struct MethodMatch {
+  Class const* owner;
+  Method const* method;
+};
+
+using QueryMatch = std::variant<Class const*, FieldMatch, MethodMatch, Relationship const*>;
+
+///
+/// @brief A compiled filter over the classes, members, or relationships of a diagram
+///
+/// The textual form is `target[:predicate[&predicate...]]` where target is one of classes, fields, methods, or
+/// relationships and each predicate is `attribute op value` with op being one of `=`, `!=`, `~` (contains), `!~`,
+/// `<`, or `>` (the latter two only for counts). Predicates on collections (e.g. `field_type`) hold when any element
+/// matches; their negations hold when no element matches.
+///
+class Query {
+  QueryTarget target_{QueryTarget::Classes};
+  std::vector<QueryPredicate> predicates_;
+  QueryAccess access_{QueryAccess::Scan};
+  std::string access_key_;
+  std::string text_;
+
+  void Plan();
+
+public:
+  ///
+  /// @brief Parse and plan a query
+  ///
+  /// @param str the query text
+  /// @return error IFF the query is malformed
+  ///
+  [[nodiscard]] static Result<Query> FromString(std::string_view str);
+
+  [[nodiscard]] QueryTarget Target() const noexcept;
+  [[nodiscard]] QueryAccess Access() const noexcept;
+  [[nodiscard]] std::vector<QueryPredicate> const& Predicates() const noexcept;
+
+  ///
+  /// @brief Get the value which the access path is keyed on (a class name or type), if any
+  ///
+  [[nodiscard]] std::string const& AccessKey() const noexcept;
+
+  ///
+  /// @brief Get the text the query was parsed from
+  ///
+  [[nodiscard]] std::string const& Text() const noexcept;
+
+  ///
+  /// @brief Evaluate the query against a diagram
+  ///
+  /// Matches are delivered in diagram order. Large candidate sets are evaluated in parallel and delivered once
+  /// evaluation completes; small candidate sets are delivered as they are found.
+  ///
+  /// @param diagram the diagram to query, whose indexes are up to date (see Diagram::RefreshIndexes)
+  /// @param sink invoked once per match
+  ///
+  void Execute(Diagram const& diagram, std::function<void(QueryMatch const&)> const& sink) const;
+
+  ///
+  /// @brief Evaluate the query against only what a single class owns
+  ///
+  /// A class owns itself, its fields and methods, and the relationships it is the source of. The access path is not
+  /// consulted, so the class need not be one of its candidates.
+  ///
+  /// @param diagram the diagram the class belongs to
+  /// @param owner the class whose entities are evaluated
+  /// @param sink invoked once per match in diagram order
+  ///
+  void ExecuteFor(Diagram const& diagram,
+                  Class const& owner,
+                  std::function<void(QueryMatch const&)> const& sink) const;
+
+  ///
+  /// @brief Evaluate the query and collect all matches
+  ///
+  /// @param diagram the diagram to query
+  /// @return all matches in diagram order
+  ///
+  [[nodiscard]] std::vector<QueryMatch> Collect(Diagram const& diagram) const;
+};
+
+} // namespace model
+
+template <> struct std::formatter<model::QueryMatch> {
+  template <typename FormatParseContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  constexpr inline auto parse(FormatParseContext& ctx) {
+    return ctx.begin();
+  }
+  template <typename FormatContext>
+  //NOLINTNEXTLINE(readability-identifier-naming)
+  auto format(model::QueryMatch const& obj, FormatContext& ctx) const {
+    struct {
+      FormatContext& ctx;
+      void operator()(model::Class const* c) const {
+        ctx.advance_to(std::format_to(ctx.out(), "{}", c->Name()));
+      }
+      void operator()(model::FieldMatch const& m) const {
+        ctx.advance_to(std::format_to(ctx.out(), "{}::{: }", m.owner->Name(), *m.field));
+      }
+      void operator()(model::MethodMatch const& m) const {
+        ctx.advance_to(std::format_to(ctx.out(), "{}::{: }", m.owner->Name(), *m.method));
+      }
+      void operator()(model::Relationship const* r) const {
+        ctx.advance_to(std::format_to(ctx.out(), "{}", *r));
+      }
+    } visitor{ctx};
+    std::visit(visitor, obj);
+    return ctx.out();
+  }
+};
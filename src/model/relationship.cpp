@@ -2,6 +2,8 @@
 
 #include "model/checking.hpp"
 #include "model/relationship_type.hpp"
+#include "utils/binary.hpp"
+#include "utils/json.hpp"
 #include "nlohmann/json_fwd.hpp"
 
 #include <doctest/doctest.h>
@@ -15,14 +17,14 @@ void to_json(nlohmann ::json& json, const Relationship& r) {
   json["source"] = r.Source();
   json["destination"] = r.Destination();
   json["type"] = r.Type();
+  if (r.provenance_.Known()) {
+    json["modified"] = r.provenance_;
+  }
 }
 
 // NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(const nlohmann ::json& json, Relationship& r) {
-  auto res = Relationship::From(json.at("source").get<std::string>(),
-                                json.at("destination").get<std::string>(),
-                                json.at("type").get<RelationshipType>())
-                 .transform([&](Relationship rel) { r = std::move(rel); });
+  auto res = Relationship::FromJson(json).transform([&](Relationship rel) { r = std::move(rel); });
   if (not res) {
     throw std::runtime_error{res.error()};
   }
@@ -30,6 +32,50 @@ void from_json(const nlohmann ::json& json, Relationship& r) {
 
 Relationship::Relationship() = default;
 
+Result<Relationship> Relationship::FromJson(nlohmann::json const& json) {
+  return JsonMember(json, "source", JsonString)
+      .and_then([&](std::string_view source) {
+        return JsonMember(json, "destination", JsonString).and_then([&](std::string_view destination) {
+          return JsonMember(json, "type", RelationshipTypeFromJson).and_then([&](RelationshipType type) {
+            return From(source, destination, type);
+          });
+        });
+      })
+      .and_then([&](Relationship r) {
+        return ModifiedFromJson(json).transform([&](Provenance modified) {
+          r.provenance_ = modified;
+          return std::move(r);
+        });
+      });
+}
+
+void Relationship::Encode(BinaryWriter& out) const {
+  out.String(source_);
+  out.String(destination_);
+  out.Integer(std::to_underlying(type_));
+  provenance_.Encode(out);
+}
+
+Result<Relationship> Relationship::Decode(BinaryReader& in) {
+  return in.String().and_then([&](std::string_view source) {
+    return in.String().and_then([&](std::string_view destination) {
+      return in.Integer<std::uint8_t>().and_then([&](std::uint8_t type) -> Result<Relationship> {
+        if (type > std::to_underlying(RelationshipType::Realization)) {
+          return std::unexpected{std::format("{} is not a relationship type", type)};
+        }
+        return Provenance::Decode(in).transform([&](Provenance modified) {
+          Relationship rel;
+          rel.source_ = source;
+          rel.destination_ = destination;
+          rel.type_ = static_cast<RelationshipType>(type);
+          rel.provenance_ = modified;
+          return rel;
+        });
+      });
+    });
+  });
+}
+
 Result<Relationship> Relationship::From(std::string_view source, std::string_view destination, RelationshipType type) {
   return Check<ValidType>(source, "class name")
       .and_then([&] { return Check<ValidType>(destination, "class name"); })
@@ -54,14 +100,34 @@ RelationshipType Relationship::Type() const noexcept {
 
 void Relationship::ChangeType(RelationshipType new_type) {
   type_ = new_type;
+  MarkModified();
 }
 
 Result<void> Relationship::ChangeSource(std::string_view new_source) {
-  return Check<ValidType>(new_source, "class name").transform([&] { source_ = new_source; });
+  return Check<ValidType>(new_source, "class name").transform([&] {
+    source_ = new_source;
+    MarkModified();
+  });
 }
 
 Result<void> Relationship::ChangeDestination(std::string_view new_destination) {
-  return Check<ValidType>(new_destination, "class name").transform([&] { destination_ = new_destination; });
+  return Check<ValidType>(new_destination, "class name").transform([&] {
+    destination_ = new_destination;
+    MarkModified();
+  });
+}
+
+Provenance const& Relationship::LastModified() const noexcept {
+  return provenance_;
+}
+
+void Relationship::MarkModified() noexcept {
+  ProvenanceScope::Mark(provenance_);
+}
+
+void Relationship::ShrinkToFit() {
+  source_.shrink_to_fit();
+  destination_.shrink_to_fit();
 }
 
 bool Relationship::operator==(Relationship const& other) const noexcept {
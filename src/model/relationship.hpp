@@ -1,5 +1,6 @@
 #pragma once
 
+#include "model/provenance.hpp"
 #include "model/relationship_type.hpp"
 #include "utils/utils.hpp"
 
@@ -10,12 +11,16 @@
 #include <string>
 #include <string_view>
 
+class BinaryReader;
+class BinaryWriter;
+
 namespace model {
 
 class Relationship {
   std::string source_;
   std::string destination_;
   RelationshipType type_{RelationshipType::Inheritance};
+  Provenance provenance_;
 
   //NOLINTBEGIN(readability-identifier-naming)
   friend void to_json(nlohmann::json&, Relationship const&);
@@ -34,6 +39,29 @@ public:
   [[nodiscard]] static Result<Relationship>
   From(std::string_view source, std::string_view destination, RelationshipType type);
 
+  ///
+  /// @brief Create a relationship from its JSON representation without throwing
+  ///
+  /// @param json
+  /// @return error (prefixed by the location of the offending value) if the JSON is malformed or validation failed
+  ///
+  [[nodiscard]] static Result<Relationship> FromJson(nlohmann::json const& json);
+
+  ///
+  /// @brief Append the relationship to a binary buffer, to be read back by Decode
+  ///
+  /// @param out
+  ///
+  void Encode(BinaryWriter& out) const;
+
+  ///
+  /// @brief Read a relationship written by Encode, taking it as it was written rather than validating it again
+  ///
+  /// @param in
+  /// @return error if the buffer is truncated or corrupt
+  ///
+  [[nodiscard]] static Result<Relationship> Decode(BinaryReader& in);
+
   Relationship();
 
   [[nodiscard]] std::string const& Source() const noexcept;
@@ -66,6 +94,21 @@ public:
   /// @param new_type
   ///
   void ChangeType(RelationshipType new_type);
+
+  ///
+  /// @brief Get the command which last modified the relationship
+  ///
+  [[nodiscard]] Provenance const& LastModified() const noexcept;
+
+  ///
+  /// @brief Record the active command (if any) as the last to modify the relationship
+  ///
+  void MarkModified() noexcept;
+
+  ///
+  /// @brief Release the spare capacity of the names of the relationship's classes
+  ///
+  void ShrinkToFit();
 };
 
 } // namespace model
@@ -1,5 +1,7 @@
 #include "relationship_type.hpp"
 
+#include "utils/json.hpp"
+
 #include <doctest/doctest.h>
 #include <nlohmann/json.hpp>
 
@@ -14,12 +16,16 @@ void to_json(nlohmann::json& j, RelationshipType t) {
 
 // NOLINTNEXTLINE(readability-identifier-naming)
 void from_json(const nlohmann::json& j, RelationshipType& t) {
-  auto res = RelationshipTypeFromString(std::string{j}).transform([&](RelationshipType type) { t = type; });
+  auto res = RelationshipTypeFromJson(j).transform([&](RelationshipType type) { t = type; });
   if (not res) {
     throw std::invalid_argument{res.error()};
   }
 }
 
+Result<RelationshipType> RelationshipTypeFromJson(nlohmann::json const& j) {
+  return JsonString(j).and_then(RelationshipTypeFromString);
+}
+
 Result<RelationshipType> RelationshipTypeFromString(std::string_view s) {
   if (s == "Aggregation") {
     return RelationshipType::Aggregation;
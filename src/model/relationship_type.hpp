@@ -18,6 +18,8 @@ void from_json(nlohmann::json const&, RelationshipType&);
 
 [[nodiscard]] Result<RelationshipType> RelationshipTypeFromString(std::string_view);
 
+[[nodiscard]] Result<RelationshipType> RelationshipTypeFromJson(nlohmann::json const&);
+
 } // namespace model
 
 template <> struct std::formatter<model::RelationshipType> {
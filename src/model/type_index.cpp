@@ -0,0 +1,289 @@
+#include "type_index.hpp"
+
+#include "model/class.hpp"
+#include "model/field.hpp"
+#include "model/method.hpp"
+#include "model/parameter.hpp"
+#include "utils/utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <functional>
+#include <ranges>
+
+namespace model {
+
+std::vector<std::string_view> TypesOf(Class const& cls) {
+  std::vector<std::string_view> types;
+  for (Field const& f : cls.Fields()) {
+    types.push_back(f.Type());
+  }
+  for (Method const& m : cls.Methods()) {
+    types.push_back(m.ReturnType());
+    for (Parameter const& p : m.Parameters()) {
+      types.push_back(p.Type());
+    }
+  }
+  return types;
+}
+
+std::vector<std::string> TypeIndex::Remove(std::string_view class_name) {
+  auto contribution = contributions_.find(class_name);
+  if (contribution == contributions_.end()) {
+    return {};
+  }
+  for (std::string const& identifier : contribution->second.identifiers) {
+    if (auto users = users_.find(identifier); users != users_.end()) {
+      if (auto user = users->second.find(class_name); user != users->second.end() and --user->second == 0) {
+        users->second.erase(user);
+      }
+      if (users->second.empty()) {
+        users_.erase(users);
+        Reclassify(identifier);
+      }
+    }
+  }
+  auto types = std::move(contribution->second.types);
+  contributions_.erase(contribution);
+  return types;
+}
+
+std::vector<std::string> const& TypeIndex::Insert(Class const& cls) {
+  Contribution contribution;
+  for (std::string_view type : TypesOf(cls)) {
+    contribution.types.emplace_back(type);
+    for (std::string_view identifier : TypeIdentifiers(type)) {
+      contribution.identifiers.emplace_back(identifier);
+    }
+  }
+  for (std::string const& identifier : contribution.identifiers) {
+    auto users = users_.find(identifier);
+    if (users == users_.end()) {
+      users = users_.emplace(identifier, std::map<std::string, std::size_t, std::less<>>{}).first;
+      Reclassify(identifier);
+    }
+    ++users->second[cls.Name()];
+  }
+  return contributions_.insert_or_assign(cls.Name(), std::move(contribution)).first->second.types;
+}
+
+void TypeIndex::Invalidate(std::string_view class_name) {
+  if (not stale_.contains(class_name)) {
+    stale_.emplace(class_name);
+  }
+}
+
+void TypeIndex::Erase(std::string_view class_name) {
+  for (std::string const& type : Remove(class_name)) {
+    ranking_.Edit().Count(type, -1);
+  }
+  if (auto i = stale_.find(class_name); i != stale_.end()) {
+    stale_.erase(i);
+  }
+}
+
+void TypeIndex::Reclassify(std::string_view identifier) {
+  if (not unclassified_.contains(identifier)) {
+    unclassified_.emplace(identifier);
+  }
+}
+
+void TypeIndex::Reset(std::vector<Class> const& classes) {
+  users_.clear();
+  contributions_.clear();
+  ranking_ = {};
+  stale_.clear();
+  unresolved_.clear();
+  unclassified_.clear();
+  for (Class const& c : classes) {
+    stale_.insert(c.Name());
+  }
+}
+
+void TypeIndex::Refresh(std::vector<Class> const& classes, std::set<std::string, std::less<>> const& builtins) {
+  auto const names_class = [&](std::string_view name) {
+    auto c = std::ranges::lower_bound(classes, name, {}, &Class::Name);
+    return c != classes.end() and c->Name() == name ? c : classes.end();
+  };
+  std::vector<std::string> const none;
+  for (std::string const& class_name : stale_) {
+    auto const removed = Remove(class_name);
+    auto const c = names_class(class_name);
+    auto const& inserted = c == classes.end() ? none : Insert(*c);
+    // most edits (e.g. moving a class or renaming a member) leave the mentioned types as they were
+    if (inserted != removed) {
+      for (std::string const& type : removed) {
+        ranking_.Edit().Count(type, -1);
+      }
+      for (std::string const& type : inserted) {
+        ranking_.Edit().Count(type, +1);
+      }
+    }
+  }
+  stale_.clear();
+  if (ranking_->Unranked()) {
+    ranking_.Edit().Rank();
+  }
+  if (builtins != builtins_) {
+    builtins_ = builtins;
+    for (std::string const& identifier : std::views::keys(users_)) {
+      Reclassify(identifier);
+    }
+  }
+  for (std::string const& identifier : unclassified_) {
+    if (users_.contains(identifier) and not builtins_.contains(identifier) and
+        names_class(identifier) == classes.end()) {
+      unresolved_.insert(identifier);
+    } else if (auto i = unresolved_.find(identifier); i != unresolved_.end()) {
+      unresolved_.erase(i);
+    }
+  }
+  unclassified_.clear();
+}
+
+bool TypeIndex::Stale() const noexcept {
+  return not stale_.empty() or not unclassified_.empty() or ranking_->Unranked();
+}
+
+std::set<std::string, std::less<>> const& TypeIndex::Builtins() const noexcept {
+  return builtins_;
+}
+
+std::set<std::string, std::less<>> const& TypeIndex::Unresolved() const noexcept {
+  return unresolved_;
+}
+
+std::vector<std::string> TypeIndex::UsersOf(std::string_view identifier) const {
+  if (auto users = users_.find(identifier); users != users_.end()) {
+    return std::ranges::to<std::vector>(std::views::keys(users->second));
+  } else {
+    return {};
+  }
+}
+
+std::size_t TypeIndex::Mentions(std::string_view identifier) const {
+  if (auto users = users_.find(identifier); users != users_.end()) {
+    return std::ranges::fold_left(std::views::values(users->second), 0ZU, std::plus{});
+  } else {
+    return 0;
+  }
+}
+
+Shared<TypeRanking> const& TypeIndex::Ranking() const noexcept {
+  return ranking_;
+}
+
+std::vector<std::string> TypeIndex::TypesByFrequency(std::string_view prefix) const {
+  return ranking_->Top(prefix);
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::TypeIndex") {
+  DOCTEST_TEST_CASE("model::TypeIndex.Refresh") {
+    std::vector<model::Class> classes;
+    classes.push_back(*model::Class::From("A"));
+    classes.push_back(*model::Class::From("B"));
+    REQUIRE(classes[0].AddField("x", "vector<B>"));
+    REQUIRE(classes[0].AddMethod("f", "B", {*model::Parameter::From("a", "int")}));
+    REQUIRE(classes[1].AddField("y", "int"));
+
+    std::set<std::string, std::less<>> const builtins{"int", "vector"};
+    model::TypeIndex index;
+    index.Reset(classes);
+    CHECK(index.Stale());
+    index.Refresh(classes, builtins);
+    CHECK_FALSE(index.Stale());
+    CHECK_EQ(index.UsersOf("B"), std::vector<std::string>{"A"});
+    CHECK_EQ(index.UsersOf("int"), std::vector<std::string>{"A", "B"});
+    CHECK_EQ(index.UsersOf("vector"), std::vector<std::string>{"A"});
+    CHECK(index.UsersOf("C").empty());
+    CHECK_EQ(index.Mentions("B"), 2);
+    CHECK_EQ(index.Mentions("int"), 2);
+
+    REQUIRE(classes[0].DeleteField("x"));
+    index.Invalidate("A");
+    CHECK(index.Stale());
+    index.Refresh(classes, builtins);
+    CHECK(index.UsersOf("vector").empty());
+    CHECK_EQ(index.Mentions("B"), 1);
+
+    index.Erase("B");
+    CHECK_EQ(index.UsersOf("int"), std::vector<std::string>{"A"});
+  }
+  DOCTEST_TEST_CASE("model::TypeIndex.Unresolved") {
+    std::vector<model::Class> classes;
+    classes.push_back(*model::Class::From("A"));
+    REQUIRE(classes[0].AddField("x", "vector<B>"));
+    REQUIRE(classes[0].AddField("y", "Money"));
+
+    model::TypeIndex index;
+    index.Reset(classes);
+    index.Refresh(classes, {"vector"});
+    CHECK_EQ(index.Unresolved(), std::set<std::string, std::less<>>{"B", "Money"});
+
+    // a class of the same name resolves an identifier
+    classes.push_back(*model::Class::From("B"));
+    index.Invalidate("B");
+    index.Reclassify("B");
+    CHECK(index.Stale());
+    index.Refresh(classes, {"vector"});
+    CHECK_EQ(index.Unresolved(), std::set<std::string, std::less<>>{"Money"});
+
+    // so does a builtin
+    index.Refresh(classes, {"vector", "Money"});
+    CHECK(index.Unresolved().empty());
+    index.Refresh(classes, {"Money"});
+    CHECK_EQ(index.Unresolved(), std::set<std::string, std::less<>>{"vector"});
+
+    // identifiers which are no longer mentioned are forgotten
+    index.Erase("A");
+    index.Refresh(classes, {"Money"});
+    CHECK(index.Unresolved().empty());
+
+    classes.pop_back();
+    index.Erase("B");
+    index.Reclassify("B");
+    index.Refresh(classes, {"Money"});
+    CHECK(index.Unresolved().empty());
+  }
+  DOCTEST_TEST_CASE("model::TypeIndex.TypesByFrequency") {
+    std::vector<model::Class> classes;
+    classes.push_back(*model::Class::From("A"));
+    REQUIRE(classes[0].AddField("x", "int"));
+    REQUIRE(classes[0].AddField("y", "string"));
+    REQUIRE(classes[0].AddMethod("f", "int", {*model::Parameter::From("a", "int64")}));
+    REQUIRE(classes[0].AddMethod("g", "string", {}));
+    REQUIRE(classes[0].AddMethod("h", "int64", {*model::Parameter::From("b", "int")}));
+
+    model::TypeIndex index;
+    index.Reset(classes);
+    index.Refresh(classes, {});
+    CHECK_EQ(index.TypesByFrequency(""), std::vector<std::string>{"int", "int64", "string"});
+    CHECK_EQ(index.TypesByFrequency("i"), std::vector<std::string>{"int", "int64"});
+    CHECK_EQ(index.TypesByFrequency("int6"), std::vector<std::string>{"int64"});
+    CHECK(index.TypesByFrequency("x").empty());
+
+    // the rankings follow the mentions
+    REQUIRE(classes[0].DeleteField("x"));
+    REQUIRE(classes[0].AddField("z", "int64"));
+    index.Invalidate("A");
+    index.Refresh(classes, {});
+    CHECK_EQ(index.TypesByFrequency("i"), std::vector<std::string>{"int64", "int"});
+    CHECK_EQ(index.TypesByFrequency("int6"), std::vector<std::string>{"int64"});
+
+    // erasing a class re-ranks on the next refresh
+    index.Erase("A");
+    CHECK(index.Stale());
+    CHECK_EQ(index.TypesByFrequency("i"), std::vector<std::string>{"int64", "int"});
+    index.Refresh(classes, {});
+    CHECK(index.TypesByFrequency("").empty());
+  }
+  DOCTEST_TEST_CASE("model::TypesOf") {
+    auto c = *model::Class::From("A");
+    REQUIRE(c.AddField("x", "T"));
+    REQUIRE(c.AddMethod("f", "R", {*model::Parameter::From("a", "P1"), *model::Parameter::From("b", "P2")}));
+    CHECK_EQ(model::TypesOf(c), std::vector<std::string_view>{"T", "R", "P1", "P2"});
+  }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "model/type_ranking.hpp"
+#include "utils/shared.hpp"
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace model {
+
+class Class;
+
+///
+/// @brief An index from type identifiers to the classes whose fields, parameters, or return types mention them
+///
+/// The index is maintained lazily: mutations only mark a class as stale and the next Refresh re-scans stale classes,
+/// so the cost of keeping it current is proportional to what changed rather than to the size of the diagram.
+///
+/// The index also maintains the set of unresolved identifiers: those mentioned somewhere which neither name a class
+/// nor a builtin. Only identifiers whose mentions changed, or which were marked with Reclassify, are re-examined.
+///
+class TypeIndex {
+  /// identifier -> (class name -> number of mentions)
+  std::map<std::string, std::map<std::string, std::size_t, std::less<>>, std::less<>> users_;
+  struct Contribution {
+    /// the identifiers mentioned by the class (duplicates included)
+    std::vector<std::string> identifiers;
+    /// the whole types mentioned by the class (duplicates included)
+    std::vector<std::string> types;
+  };
+  /// class name -> what the class contributed when it was last indexed
+  std::map<std::string, Contribution, std::less<>> contributions_;
+  /// the whole types by number of mentions across all classes, shared with readers until the next change
+  Shared<TypeRanking> ranking_;
+  /// classes whose contributions are out of date
+  std::set<std::string, std::less<>> stale_;
+  /// identifiers which are mentioned but name neither a class nor a builtin
+  std::set<std::string, std::less<>> unresolved_;
+  /// identifiers whose resolution may have changed
+  std::set<std::string, std::less<>> unclassified_;
+  /// the builtins used to classify identifiers
+  std::set<std::string, std::less<>> builtins_;
+
+  ///
+  /// @brief Remove every contribution of a class
+  ///
+  /// @param class_name
+  /// @return the whole types the class contributed
+  ///
+  std::vector<std::string> Remove(std::string_view class_name);
+
+  ///
+  /// @brief Add the contributions of a class which has none
+  ///
+  /// @param cls
+  /// @return the whole types the class contributed
+  ///
+  std::vector<std::string> const& Insert(Class const& cls);
+
+public:
+  ///
+  /// @brief Mark a class as needing to be re-indexed
+  ///
+  /// @param class_name
+  ///
+  void Invalidate(std::string_view class_name);
+
+  ///
+  /// @brief Remove every contribution of a class that no longer exists
+  ///
+  /// @param class_name
+  ///
+  void Erase(std::string_view class_name);
+
+  ///
+  /// @brief Mark an identifier as needing its resolution re-examined, e.g. when a class of that name comes or goes
+  ///
+  /// @param identifier
+  ///
+  void Reclassify(std::string_view identifier);
+
+  ///
+  /// @brief Discard the entire index and mark every class as stale
+  ///
+  /// @param classes the classes which will need to be indexed
+  ///
+  void Reset(std::vector<Class> const& classes);
+
+  ///
+  /// @brief Re-index every stale class and re-classify every identifier whose resolution may have changed
+  ///
+  /// @param classes all classes of the diagram, sorted by name
+  /// @param builtins the identifiers which resolve without naming a class
+  ///
+  void Refresh(std::vector<Class> const& classes, std::set<std::string, std::less<>> const& builtins);
+
+  ///
+  /// @brief Check whether any class has pending changes (including erasures) which are not yet reflected
+  ///
+  [[nodiscard]] bool Stale() const noexcept;
+
+  ///
+  /// @brief Get the builtins which were used by the previous Refresh
+  ///
+  [[nodiscard]] std::set<std::string, std::less<>> const& Builtins() const noexcept;
+
+  ///
+  /// @brief Get every identifier which is mentioned but names neither a class nor a builtin
+  ///
+  /// @return the sorted unresolved identifiers as of the previous Refresh
+  ///
+  [[nodiscard]] std::set<std::string, std::less<>> const& Unresolved() const noexcept;
+
+  ///
+  /// @brief Get the names of the classes which mention an identifier in any of their types
+  ///
+  /// @param identifier
+  /// @return sorted class names
+  ///
+  [[nodiscard]] std::vector<std::string> UsersOf(std::string_view identifier) const;
+
+  ///
+  /// @brief Get the number of times an identifier is mentioned across all classes
+  ///
+  /// @param identifier
+  /// @return the mention count
+  ///
+  [[nodiscard]] std::size_t Mentions(std::string_view identifier) const;
+
+  ///
+  /// @brief Get the whole types mentioned anywhere, ranked for every prefix
+  ///
+  /// Refresh copies the ranking before changing it while it is still shared, so a copy of the returned value can be
+  /// read from another thread as the index goes on changing.
+  ///
+  /// @return the ranking as of the previous Refresh
+  ///
+  [[nodiscard]] Shared<TypeRanking> const& Ranking() const noexcept;
+
+  ///
+  /// @brief Get the whole types mentioned anywhere which start with a prefix, most mentioned first
+  ///
+  /// @param prefix
+  /// @return at most TypeRanking::RankedPerPrefix matching types as of the previous Refresh
+  ///
+  [[nodiscard]] std::vector<std::string> TypesByFrequency(std::string_view prefix) const;
+};
+
+///
+/// @brief Gather every type mentioned by a class: field types, return types, and parameter types
+///
+/// @param cls
+/// @return the types in declaration order (duplicates included)
+///
+[[nodiscard]] std::vector<std::string_view> TypesOf(Class const& cls);
+
+} // namespace model
@@ -0,0 +1,143 @@
+#include "type_ranking.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <ranges>
+
+namespace model {
+
+/// the character a child of a node is reached by
+static constexpr auto Character = &std::pair<char, std::uint32_t>::first;
+
+std::optional<std::uint32_t> TypeRanking::Find(std::string_view prefix) const noexcept {
+  std::uint32_t node{0};
+  for (char const c : prefix) {
+    auto const& children = nodes_[node].children;
+    auto const child = std::ranges::lower_bound(children, c, {}, Character);
+    if (child == children.end() or child->first != c) {
+      return std::nullopt;
+    }
+    node = child->second;
+  }
+  return node;
+}
+
+void TypeRanking::Count(std::string_view type, std::ptrdiff_t change) {
+  if (change == 0) {
+    return;
+  }
+  auto const mark = [&](std::uint32_t node) {
+    if (not nodes_[node].unranked) {
+      nodes_[node].unranked = true;
+      unranked_.push_back(node);
+    }
+  };
+  std::uint32_t node{0};
+  mark(node);
+  for (char const c : type) {
+    auto& children = nodes_[node].children;
+    if (auto const child = std::ranges::lower_bound(children, c, {}, Character);
+        child != children.end() and child->first == c) {
+      node = child->second;
+    } else {
+      // children refers into nodes_, so it is extended before nodes_ is
+      auto const added = static_cast<std::uint32_t>(nodes_.size());
+      children.emplace(child, c, added);
+      nodes_.emplace_back();
+      node = added;
+    }
+    mark(node);
+  }
+  Node& terminal = nodes_[node];
+  if (terminal.type.empty()) {
+    terminal.type = type;
+  }
+  terminal.mentions = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(terminal.mentions) + change);
+}
+
+void TypeRanking::Rank() {
+  // a child comes after its parent, so ranking from the last node up ranks every child before its parent
+  std::ranges::sort(unranked_, std::greater{});
+  auto const better = [&](std::uint32_t a, std::uint32_t b) {
+    return std::pair{nodes_[b].mentions, std::string_view{nodes_[a].type}} <
+           std::pair{nodes_[a].mentions, std::string_view{nodes_[b].type}};
+  };
+  for (std::uint32_t const index : unranked_) {
+    // the best types of a subtree are among the node's own type and the best types of its children
+    std::vector<std::uint32_t> candidates;
+    if (nodes_[index].mentions > 0) {
+      candidates.push_back(index);
+    }
+    for (std::uint32_t const child : std::views::values(nodes_[index].children)) {
+      candidates.insert(candidates.end(), nodes_[child].ranked.begin(), nodes_[child].ranked.end());
+    }
+    auto const kept = std::min(candidates.size(), RankedPerPrefix);
+    std::ranges::partial_sort(candidates, candidates.begin() + static_cast<std::ptrdiff_t>(kept), better);
+    candidates.resize(kept);
+    nodes_[index].ranked = std::move(candidates);
+    nodes_[index].unranked = false;
+  }
+  unranked_.clear();
+}
+
+bool TypeRanking::Unranked() const noexcept {
+  return not unranked_.empty();
+}
+
+std::vector<std::string> TypeRanking::Top(std::string_view prefix) const {
+  if (auto const node = Find(prefix); node) {
+    return nodes_[*node].ranked | std::views::transform([&](std::uint32_t i) { return nodes_[i].type; }) |
+           std::ranges::to<std::vector>();
+  } else {
+    return {};
+  }
+}
+
+} // namespace model
+
+DOCTEST_TEST_SUITE("model::TypeRanking") {
+  DOCTEST_TEST_CASE("model::TypeRanking.Top") {
+    model::TypeRanking ranking;
+    ranking.Count("int", 3);
+    ranking.Count("int64", 1);
+    ranking.Count("string", 2);
+    ranking.Count("i", 1);
+    CHECK(ranking.Unranked());
+    CHECK(ranking.Top("").empty());
+    ranking.Rank();
+    CHECK_FALSE(ranking.Unranked());
+    CHECK_EQ(ranking.Top(""), std::vector<std::string>{"int", "string", "i", "int64"});
+    CHECK_EQ(ranking.Top("i"), std::vector<std::string>{"int", "i", "int64"});
+    CHECK_EQ(ranking.Top("int6"), std::vector<std::string>{"int64"});
+    CHECK(ranking.Top("x").empty());
+    CHECK(ranking.Top("int645").empty());
+
+    // only the counted paths are re-ranked, and a type no longer mentioned is left out
+    ranking.Count("int64", 3);
+    ranking.Count("i", -1);
+    ranking.Rank();
+    CHECK_EQ(ranking.Top("i"), std::vector<std::string>{"int64", "int"});
+    CHECK_EQ(ranking.Top("s"), std::vector<std::string>{"string"});
+  }
+  DOCTEST_TEST_CASE("model::TypeRanking.RankedPerPrefix") {
+    model::TypeRanking ranking;
+    for (std::size_t i{0}; i <= model::TypeRanking::RankedPerPrefix; ++i) {
+      ranking.Count(std::format("t{:02}", i), static_cast<std::ptrdiff_t>(i + 1));
+    }
+    ranking.Rank();
+    auto top = ranking.Top("t");
+    REQUIRE_EQ(top.size(), model::TypeRanking::RankedPerPrefix);
+    CHECK_EQ(top.front(), std::format("t{:02}", model::TypeRanking::RankedPerPrefix));
+    CHECK_FALSE(std::ranges::contains(top, "t00"));
+
+    // a type dropping out of the ranking makes way for the best one left out of it
+    ranking.Count(top.front(), -static_cast<std::ptrdiff_t>(model::TypeRanking::RankedPerPrefix + 1));
+    ranking.Rank();
+    top = ranking.Top("t");
+    REQUIRE_EQ(top.size(), model::TypeRanking::RankedPerPrefix);
+    CHECK_EQ(top.back(), "t00");
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace model {
+
+///
+/// @brief The types mentioned in a diagram, ranked by their number of mentions for every prefix
+///
+/// A trie over the types in which every node keeps the most mentioned types of its subtree, so looking up the best
+/// matches of a prefix takes time proportional to the prefix rather than to the number of types. Counting a mention
+/// only marks the nodes along the type's path, and Rank re-ranks each marked node once from the rankings of its
+/// children. The nodes of types which are no longer mentioned are kept, and ranked as if absent.
+///
+class TypeRanking {
+public:
+  /// the number of types kept for every prefix
+  static constexpr std::size_t RankedPerPrefix{16};
+
+private:
+  struct Node {
+    /// (character, index of the child), sorted by character
+    std::vector<std::pair<char, std::uint32_t>> children;
+    /// the type spelled by the path to the node
+    std::string type;
+    /// the number of mentions of the type, or 0 if no type ends here
+    std::size_t mentions{0};
+    /// the most mentioned types within the subtree (ties in alphabetical order), as indices of their nodes
+    std::vector<std::uint32_t> ranked;
+    /// whether ranked is out of date
+    bool unranked{false};
+  };
+  /// the root first; a child always comes after its parent
+  std::vector<Node> nodes_ = std::vector<Node>(1);
+  /// the nodes whose rankings are out of date
+  std::vector<std::uint32_t> unranked_;
+
+  ///
+  /// @brief Find the node of a prefix
+  ///
+  /// @param prefix
+  /// @return the index of the node, or nullopt if no type starts with the prefix
+  ///
+  [[nodiscard]] std::optional<std::uint32_t> Find(std::string_view prefix) const noexcept;
+
+public:
+  ///
+  /// @brief Change the number of mentions of a type, leaving the rankings as they are until the next Rank
+  ///
+  /// @param type
+  /// @param change the number of mentions added (or, if negative, removed)
+  ///
+  void Count(std::string_view type, std::ptrdiff_t change);
+
+  ///
+  /// @brief Re-rank every prefix whose types were counted since the previous Rank
+  ///
+  void Rank();
+
+  ///
+  /// @brief Check whether any type was counted since the previous Rank
+  ///
+  [[nodiscard]] bool Unranked() const noexcept;
+
+  ///
+  /// @brief Get the most mentioned types which start with a prefix
+  ///
+  /// @param prefix
+  /// @return at most RankedPerPrefix types, most mentioned first (ties in alphabetical order), as of the previous Rank
+  ///
+  [[nodiscard]] std::vector<std::string> Top(std::string_view prefix) const;
+};
+
+} // namespace model
@@ -0,0 +1,103 @@
+#include "binary.hpp"
+
+#include <doctest/doctest.h>
+
+#include <limits>
+
+/// the bits of a value held by every byte of a varint, below the bit marking that more bytes follow
+constexpr static unsigned VarintBits{7};
+constexpr static std::uint8_t VarintMore{0x80};
+
+void BinaryWriter::Varint(std::uint64_t value) {
+  for (; value >= VarintMore; value >>= VarintBits) {
+    bytes_.push_back(static_cast<char>((value & (VarintMore - 1U)) | VarintMore));
+  }
+  bytes_.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::String(std::string_view value) {
+  Varint(value.size());
+  bytes_.append(value);
+}
+
+std::string& BinaryWriter::Bytes() noexcept {
+  return bytes_;
+}
+
+BinaryReader::BinaryReader(std::string_view in) noexcept : in_{in} {
+}
+
+Result<std::uint64_t> BinaryReader::Varint() {
+  std::uint64_t value{0};
+  for (unsigned shift{0}; shift < std::numeric_limits<std::uint64_t>::digits; shift += VarintBits) {
+    if (in_.empty()) {
+      return std::unexpected{"unexpected end of data"};
+    }
+    auto const byte = static_cast<std::uint8_t>(in_.front());
+    in_.remove_prefix(1);
+    value |= std::uint64_t{byte & (VarintMore - 1U)} << shift;
+    if ((byte & VarintMore) == 0) {
+      return value;
+    }
+  }
+  return std::unexpected{"integer is too long"};
+}
+
+Result<std::string_view> BinaryReader::String() {
+  return Integer<std::size_t>().and_then([&](std::size_t size) -> Result<std::string_view> {
+    if (size > in_.size()) {
+      return std::unexpected{"unexpected end of data"};
+    }
+    std::string_view const value{in_.substr(0, size)};
+    in_.remove_prefix(size);
+    return value;
+  });
+}
+
+bool BinaryReader::AtEnd() const noexcept {
+  return in_.empty();
+}
+
+DOCTEST_TEST_SUITE("utils::Binary") {
+  DOCTEST_TEST_CASE("utils::BinaryReader") {
+    BinaryWriter out;
+    out.Integer(0U);
+    out.Integer(std::numeric_limits<std::uint64_t>::max());
+    out.Integer(-1);
+    out.Integer(std::numeric_limits<std::int64_t>::min());
+    out.String("");
+    out.String("text");
+    std::vector const elements{1, 300};
+    out.Elements(elements, [](int i, BinaryWriter& w) { w.Integer(i); });
+    // small integers take a byte whatever their sign
+    CHECK_EQ(out.Bytes().substr(0, 1), std::string(1, '\0'));
+    CHECK_EQ(out.Bytes().size(), 1 + 10 + 1 + 10 + 1 + 5 + 1 + 1 + 2);
+
+    BinaryReader in{out.Bytes()};
+    CHECK_EQ(in.Integer<unsigned>(), 0U);
+    CHECK_EQ(in.Integer<std::uint64_t>(), std::numeric_limits<std::uint64_t>::max());
+    CHECK_EQ(in.Integer<int>(), -1);
+    CHECK_EQ(in.Integer<std::int64_t>(), std::numeric_limits<std::int64_t>::min());
+    CHECK_EQ(in.String(), "");
+    CHECK_EQ(in.String(), "text");
+    CHECK_EQ(in.Elements([](BinaryReader& r) { return r.Integer<int>(); }), elements);
+    CHECK(in.AtEnd());
+  }
+  DOCTEST_TEST_CASE("utils::BinaryReader.Corrupt") {
+    BinaryWriter out;
+    out.Integer(300);
+    out.String("text");
+    std::string_view const bytes{out.Bytes()};
+    // a value which does not fit, or which the buffer ends within, is an error rather than a read past the end
+    CHECK_FALSE(BinaryReader{bytes}.Integer<std::uint8_t>());
+    CHECK_FALSE(BinaryReader{bytes.substr(0, 1)}.Integer<int>());
+    BinaryReader truncated{bytes.substr(0, bytes.size() - 1)};
+    REQUIRE(truncated.Integer<int>());
+    CHECK_FALSE(truncated.String());
+    CHECK_FALSE(BinaryReader{std::string(11, '\xFF')}.Integer<std::uint64_t>());
+    // a count larger than the buffer fails on the missing elements
+    BinaryWriter forged;
+    forged.Integer(std::numeric_limits<std::size_t>::max());
+    CHECK_FALSE(BinaryReader{forged.Bytes()}.Elements([](BinaryReader& r) { return r.Integer<int>(); }));
+  }
+}
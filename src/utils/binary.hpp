@@ -0,0 +1,143 @@
+#pragma once
+
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///
+/// @brief Appends values to a buffer in a compact binary layout, to be read back by a BinaryReader
+///
+/// Integers are written as variable-length (LEB128) numbers, signed ones zigzag-encoded first so that small negative
+/// numbers stay short, and strings as their length followed by their characters. Nothing describes the values, so
+/// they must be read back in the order they were written.
+///
+class BinaryWriter {
+  std::string bytes_;
+
+  void Varint(std::uint64_t value);
+
+public:
+  ///
+  /// @brief Append an integer
+  ///
+  /// @param value
+  ///
+  template <std::integral T> void Integer(T value) {
+    if constexpr (std::is_signed_v<T>) {
+      auto const v = static_cast<std::int64_t>(value);
+      Varint((static_cast<std::uint64_t>(v) << 1U) ^ static_cast<std::uint64_t>(v >> 63));
+    } else {
+      Varint(value);
+    }
+  }
+
+  ///
+  /// @brief Append a string
+  ///
+  /// @param value
+  ///
+  void String(std::string_view value);
+
+  ///
+  /// @brief Append a sequence as its number of elements followed by every element
+  ///
+  /// @param elements
+  /// @param encode appends a single element, called with the element and the writer
+  ///
+  template <std::ranges::sized_range Range, typename Encode> void Elements(Range const& elements, Encode&& encode) {
+    Integer(std::ranges::size(elements));
+    for (auto const& element : elements) {
+      std::invoke(encode, element, *this);
+    }
+  }
+
+  ///
+  /// @brief Get everything appended so far
+  ///
+  [[nodiscard]] std::string& Bytes() noexcept;
+};
+
+///
+/// @brief Reads values written by a BinaryWriter back in order, without copying the buffer
+///
+/// Every read is checked against the end of the buffer, so a truncated or corrupt buffer yields an error rather than
+/// a read out of bounds.
+///
+class BinaryReader {
+  std::string_view in_;
+
+  [[nodiscard]] Result<std::uint64_t> Varint();
+
+public:
+  explicit BinaryReader(std::string_view in) noexcept;
+
+  ///
+  /// @brief Read an integer
+  ///
+  /// @tparam T the integral type to convert to
+  /// @return Error if the buffer ends within the integer or it does not fit within T
+  ///
+  template <std::integral T> [[nodiscard]] Result<T> Integer() {
+    return Varint().and_then([](std::uint64_t raw) -> Result<T> {
+      auto const fits = [&](auto v) -> Result<T> {
+        if (std::in_range<T>(v)) {
+          return static_cast<T>(v);
+        } else {
+          return std::unexpected{std::format("{} is out of range", v)};
+        }
+      };
+      if constexpr (std::is_signed_v<T>) {
+        return fits(static_cast<std::int64_t>(raw >> 1U) ^ -static_cast<std::int64_t>(raw & 1U));
+      } else {
+        return fits(raw);
+      }
+    });
+  }
+
+  ///
+  /// @brief Read a string
+  ///
+  /// @return a view into the buffer, or an error if the buffer ends within the string
+  ///
+  [[nodiscard]] Result<std::string_view> String();
+
+  ///
+  /// @brief Read a sequence written as its number of elements followed by every element
+  ///
+  /// @param decode reads a single element from the reader, returning Result<T>
+  /// @return the elements, or the first error of any element
+  ///
+  template <typename Decode>
+  [[nodiscard]] auto Elements(Decode&& decode)
+      -> Result<std::vector<typename std::invoke_result_t<Decode, BinaryReader&>::value_type>> {
+    using Element = typename std::invoke_result_t<Decode, BinaryReader&>::value_type;
+    return Integer<std::size_t>().and_then([&](std::size_t count) -> Result<std::vector<Element>> {
+      std::vector<Element> decoded;
+      // every element takes at least a byte, so a corrupt count cannot reserve more than the buffer holds
+      decoded.reserve(std::min(count, in_.size()));
+      for (std::size_t i{0}; i < count; ++i) {
+        if (auto element = std::invoke(decode, *this); element) {
+          decoded.push_back(std::move(*element));
+        } else {
+          return std::unexpected{std::move(element.error())};
+        }
+      }
+      return decoded;
+    });
+  }
+
+  ///
+  /// @brief Check whether everything was read
+  ///
+  [[nodiscard]] bool AtEnd() const noexcept;
+};
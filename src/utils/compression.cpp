@@ -0,0 +1,294 @@
+#include "compression.hpp"
+
+#include "utils/parallel.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <span>
+
+/// identifies the container (followed by a format version)
+constexpr static std::string_view Magic{"UMLZ"};
+constexpr static std::uint8_t Version{1};
+/// the amount of data compressed independently of the rest
+constexpr static std::size_t BlockSize{256 * 1024};
+/// a match is only worth encoding from this length on
+constexpr static std::size_t MinMatch{4};
+/// the furthest back a match can refer to
+constexpr static std::size_t MaxOffset{65535};
+constexpr static unsigned HashBits{16};
+/// a length nibble with this value continues in the following bytes
+constexpr static std::size_t ExtendedLength{15};
+
+static std::uint32_t Load32(char const* data) noexcept {
+  std::uint32_t value{0};
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static std::size_t Hash(std::uint32_t value) noexcept {
+  return (value * 2654435761U) >> (32U - HashBits);
+}
+
+static void AppendInteger(std::string& out, std::uint64_t value, std::size_t bytes) {
+  for (std::size_t i{0}; i < bytes; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFFU));
+  }
+}
+
+static std::uint64_t ReadInteger(std::string_view in, std::size_t bytes) noexcept {
+  std::uint64_t value{0};
+  for (std::size_t i{0}; i < bytes; ++i) {
+    value |= std::uint64_t{static_cast<unsigned char>(in[i])} << (8 * i);
+  }
+  return value;
+}
+
+static void AppendLength(std::string& out, std::size_t length) {
+  for (; length >= 255; length -= 255) {
+    out.push_back(static_cast<char>(255));
+  }
+  out.push_back(static_cast<char>(length));
+}
+
+///
+/// @brief Append a sequence of literals followed by a match
+///
+/// A sequence starts with a token holding the literal length in its high nibble and the match length (less MinMatch)
+/// in its low nibble, followed by the literals and the little-endian offset of the match. The last sequence of a block
+/// has no match.
+///
+static void AppendSequence(std::string& out, std::string_view literals, std::size_t offset, std::size_t match) {
+  std::size_t const literal_nibble{std::min(literals.size(), ExtendedLength)};
+  std::size_t const match_nibble{match == 0 ? 0 : std::min(match - MinMatch, ExtendedLength)};
+  out.push_back(static_cast<char>(literal_nibble << 4U | match_nibble));
+  if (literal_nibble == ExtendedLength) {
+    AppendLength(out, literals.size() - ExtendedLength);
+  }
+  out.append(literals);
+  if (match != 0) {
+    AppendInteger(out, offset, 2);
+    if (match_nibble == ExtendedLength) {
+      AppendLength(out, match - MinMatch - ExtendedLength);
+    }
+  }
+}
+
+static std::string CompressBlock(std::string_view in) {
+  std::string out;
+  out.reserve(in.size() / 2);
+  // the position (plus one) at which each hashed four bytes were last seen
+  std::vector<std::uint32_t> seen(std::size_t{1} << HashBits, 0);
+  std::size_t anchor{0};
+  std::size_t pos{0};
+  while (pos + MinMatch <= in.size()) {
+    std::uint32_t const value{Load32(&in[pos])};
+    std::uint32_t& slot = seen[Hash(value)];
+    std::size_t const candidate{slot};
+    slot = static_cast<std::uint32_t>(pos + 1);
+    if (candidate == 0 or pos + 1 - candidate > MaxOffset or Load32(&in[candidate - 1]) != value) {
+      ++pos;
+      continue;
+    }
+    std::size_t const reference{candidate - 1};
+    std::size_t length{MinMatch};
+    while (pos + length < in.size() and in[reference + length] == in[pos + length]) {
+      ++length;
+    }
+    AppendSequence(out, in.substr(anchor, pos - anchor), pos - reference, length);
+    pos += length;
+    anchor = pos;
+  }
+  AppendSequence(out, in.substr(anchor), 0, 0);
+  return out;
+}
+
+static bool DecompressBlock(std::string_view in, std::span<char> out) noexcept {
+  std::size_t ip{0};
+  std::size_t op{0};
+  auto const read_length = [&](std::size_t length) -> std::optional<std::size_t> {
+    if (length != ExtendedLength) {
+      return length;
+    }
+    while (ip < in.size()) {
+      auto const extension = static_cast<unsigned char>(in[ip++]);
+      length += extension;
+      if (extension != 255) {
+        return length;
+      }
+    }
+    return std::nullopt;
+  };
+  while (ip < in.size()) {
+    auto const token = static_cast<unsigned char>(in[ip++]);
+    auto const literals = read_length(token >> 4U);
+    if (not literals or *literals > in.size() - ip or *literals > out.size() - op) {
+      return false;
+    }
+    std::copy_n(&in[ip], *literals, &out[op]);
+    ip += *literals;
+    op += *literals;
+    if (ip == in.size()) {
+      break;
+    }
+    if (in.size() - ip < 2) {
+      return false;
+    }
+    auto const offset = static_cast<std::size_t>(ReadInteger(in.substr(ip, 2), 2));
+    ip += 2;
+    auto const match = read_length(token & 0xFU);
+    if (not match or offset == 0 or offset > op or *match + MinMatch > out.size() - op) {
+      return false;
+    }
+    // matches may overlap the bytes they produce, so they are copied front to back
+    for (std::size_t i{0}; i < *match + MinMatch; ++i, ++op) {
+      out[op] = out[op - offset];
+    }
+  }
+  return op == out.size();
+}
+
+std::vector<std::string> Compress(std::string_view data) {
+  std::size_t const blocks{(data.size() + BlockSize - 1) / BlockSize};
+  std::vector<std::string> buffers(blocks + 1);
+  ParallelFor(
+      blocks,
+      [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t block{begin}; block < end; ++block) {
+          std::string_view const raw{data.substr(block * BlockSize, BlockSize)};
+          std::string compressed{CompressBlock(raw)};
+          buffers[block + 1] = compressed.size() < raw.size() ? std::move(compressed) : std::string{raw};
+        }
+      },
+      /*min_items_per_chunk=*/1);
+  std::string& header = buffers.front();
+  header.append(Magic);
+  AppendInteger(header, Version, 1);
+  AppendInteger(header, data.size(), 8);
+  for (std::size_t block{0}; block < blocks; ++block) {
+    AppendInteger(header, buffers[block + 1].size(), 4);
+  }
+  return buffers;
+}
+
+Result<std::string> Decompress(std::string_view container) {
+  auto const corrupt = [](std::string_view reason) {
+    return std::unexpected{std::format("Corrupt compressed file: {}", reason)};
+  };
+  std::size_t const fixed{Magic.size() + 1 + 8};
+  if (container.size() < fixed or not container.starts_with(Magic)) {
+    return corrupt("missing header");
+  }
+  if (ReadInteger(container.substr(Magic.size()), 1) != Version) {
+    return corrupt("unsupported version");
+  }
+  auto const size = static_cast<std::size_t>(ReadInteger(container.substr(Magic.size() + 1), 8));
+  // rounding up without adding, which would wrap a forged size near the maximum around to no blocks at all
+  std::size_t const blocks{size / BlockSize + (size % BlockSize == 0 ? 0 : 1)};
+  // every block has an entry in the table, which also bounds the size of the data by the size of the file
+  if (blocks > (container.size() - fixed) / 4) {
+    return corrupt("truncated block table");
+  }
+  // where each block starts, followed by where the last one ends
+  std::vector<std::size_t> offsets(blocks + 1, fixed + 4 * blocks);
+  for (std::size_t block{0}; block < blocks; ++block) {
+    offsets[block + 1] = offsets[block] + static_cast<std::size_t>(ReadInteger(container.substr(fixed + 4 * block), 4));
+  }
+  if (offsets.back() != container.size()) {
+    return corrupt("block sizes do not match the file size");
+  }
+  std::string data(size, '\0');
+  std::atomic<bool> failed{false};
+  ParallelFor(
+      blocks,
+      [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t block{begin}; block < end and not failed; ++block) {
+          std::string_view const in{container.substr(offsets[block], offsets[block + 1] - offsets[block])};
+          std::size_t const begin_at{block * BlockSize};
+          std::span<char> const out{std::span{data}.subspan(begin_at, std::min(BlockSize, size - begin_at))};
+          if (in.size() == out.size()) {
+            std::ranges::copy(in, out.begin());
+          } else if (not DecompressBlock(in, out)) {
+            failed = true;
+          }
+        }
+      },
+      /*min_items_per_chunk=*/1);
+  if (failed) {
+    return corrupt("malformed block");
+  }
+  return data;
+}
+
+DOCTEST_TEST_SUITE("utils::Compression") {
+  DOCTEST_TEST_CASE("utils::Compress") {
+    auto const round_trip = [](std::string_view data) {
+      std::string container;
+      for (std::string const& buffer : Compress(data)) {
+        container += buffer;
+      }
+      return std::pair{container.size(), Decompress(container)};
+    };
+    CHECK_EQ(round_trip("").second, "");
+    CHECK_EQ(round_trip("abc").second, "abc");
+
+    // repetitive text spanning several blocks shrinks, including matches which overlap themselves
+    std::string json{R"({"classes": [)"};
+    for (int i{0}; json.size() < 3 * BlockSize; ++i) {
+      json += std::format(R"({{"name": "C{}", "fields": [], "methods": [], "position": {{"x": 0, "y": 0}}}},)", i);
+    }
+    json += std::string(1000, ' ') + "]}";
+    auto const [compressed_size, restored] = round_trip(json);
+    CHECK_EQ(restored, json);
+    CHECK_LT(compressed_size, json.size() / 4);
+
+    // incompressible blocks are stored as they are
+    std::string noise(BlockSize + 100, '\0');
+    std::uint32_t state{1};
+    for (char& c : noise) {
+      state = state * 1664525U + 1013904223U;
+      c = static_cast<char>(state >> 24U);
+    }
+    auto const [noise_size, noise_restored] = round_trip(noise);
+    CHECK_EQ(noise_restored, noise);
+    CHECK_LE(noise_size, noise.size() + 64);
+  }
+  DOCTEST_TEST_CASE("utils::Decompress.Corrupt") {
+    std::string container;
+    for (std::string const& buffer : Compress(std::string(10000, 'a'))) {
+      container += buffer;
+    }
+    CHECK_FALSE(Decompress(""));
+    CHECK_FALSE(Decompress("not a container"));
+    CHECK_FALSE(Decompress(container.substr(0, container.size() - 1)));
+    std::string wrong_version{container};
+    wrong_version[Magic.size()] = 2;
+    CHECK_FALSE(Decompress(wrong_version));
+    // a block of one literal followed by a match of four bytes at the given offset
+    auto const forged = [](std::size_t size, std::size_t offset) {
+      std::string out{Magic};
+      AppendInteger(out, Version, 1);
+      AppendInteger(out, size, 8);
+      AppendInteger(out, 4, 4);
+      out += "\x10"
+             "a";
+      AppendInteger(out, offset, 2);
+      return out;
+    };
+    CHECK_EQ(Decompress(forged(5, 1)), "aaaaa");
+    CHECK_FALSE(Decompress(forged(5, 2)));
+    CHECK_FALSE(Decompress(forged(6, 1)));
+    // a bare header claiming a size so large that rounding it up to whole blocks would overflow
+    std::string header{Magic};
+    AppendInteger(header, Version, 1);
+    AppendInteger(header, std::numeric_limits<std::uint64_t>::max(), 8);
+    CHECK_FALSE(Decompress(header));
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "utils/utils.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// the file extension which selects the compressed container for saving and loading
+constexpr inline std::string_view CompressedExtension{".umlz"};
+
+///
+/// @brief Compress data into a framed container of independently compressed blocks
+///
+/// The container starts with a header listing the size of every block, so that the blocks can be located up front
+/// and both compressed and decompressed in parallel. Blocks which do not shrink are stored as they are.
+///
+/// @param data
+/// @return the header followed by one buffer per block, to be written in order
+///
+[[nodiscard]] std::vector<std::string> Compress(std::string_view data);
+
+///
+/// @brief Restore the data held by a container produced by Compress
+///
+/// @param container
+/// @return the original data, or an error if the container is truncated or corrupt
+///
+[[nodiscard]] Result<std::string> Decompress(std::string_view container);
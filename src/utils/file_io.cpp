@@ -0,0 +1,577 @@
+#include "file_io.hpp"
+
+#include "utils/settings.hpp"
+
+#include <doctest/doctest.h>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <ranges>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+/// the number of reads or writes a ring holds at once
+static constexpr unsigned RingEntries{64};
+/// the most a single write on a ring transfers (the rest of a larger buffer follows once it completes)
+static constexpr std::size_t MaxWrite{std::size_t{1} << 30};
+/// the size of the pieces a regular file is read in, all of which are requested at once
+static constexpr std::size_t ReadPiece{std::size_t{1} << 20};
+
+///
+/// @brief An io_uring set up through the raw system calls, for reads and writes at explicit offsets
+///
+/// The caller keeps at most Capacity() operations queued or in flight. The completion queue holds twice that, so no
+/// completion is ever dropped.
+///
+class IoRing {
+  int fd_;
+  /// the submission and completion queues, mapped together
+  void* rings_{MAP_FAILED};
+  std::size_t rings_size_;
+  io_uring_sqe* sqes_{static_cast<io_uring_sqe*>(MAP_FAILED)};
+  std::size_t sqes_size_;
+  unsigned* sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned* sq_array_{nullptr};
+  unsigned* cq_head_{nullptr};
+  unsigned* cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe* cqes_{nullptr};
+  unsigned capacity_;
+  /// the operations queued since the kernel was last entered
+  unsigned unsubmitted_{0};
+
+  IoRing(int fd, io_uring_params const& params) noexcept
+      : fd_{fd},
+        rings_size_{std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                             params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe))},
+        sqes_size_{params.sq_entries * sizeof(io_uring_sqe)},
+        capacity_{params.sq_entries} {
+    rings_ = ::mmap(nullptr, rings_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    void* const sqes{
+        ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES)};
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+    if (rings_ == MAP_FAILED or sqes == MAP_FAILED) {
+      return;
+    }
+    sq_tail_ = At<unsigned>(params.sq_off.tail);
+    sq_mask_ = *At<unsigned>(params.sq_off.ring_mask);
+    sq_array_ = At<unsigned>(params.sq_off.array);
+    cq_head_ = At<unsigned>(params.cq_off.head);
+    cq_tail_ = At<unsigned>(params.cq_off.tail);
+    cq_mask_ = *At<unsigned>(params.cq_off.ring_mask);
+    cqes_ = At<io_uring_cqe>(params.cq_off.cqes);
+  }
+
+  ///
+  /// @brief Locate a field of the queues, which the kernel describes by its offset into their mapping
+  ///
+  template <typename T> [[nodiscard]] T* At(std::uint32_t offset) const noexcept {
+    return reinterpret_cast<T*>(static_cast<char*>(rings_) + offset);
+  }
+
+public:
+  ///
+  /// @brief Set up a ring if the kernel offers one with reads and writes at explicit offsets (Linux 5.6 and later)
+  ///
+  /// @param entries the number of operations the ring should hold at once
+  /// @return the ring, or null if io_uring is unavailable or turned off in Settings
+  ///
+  [[nodiscard]] static std::unique_ptr<IoRing> Create(unsigned entries) {
+    if (not Settings::GetInstance().IoUring()) {
+      return nullptr;
+    }
+    io_uring_params params{};
+    int const fd{static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params))};
+    if (fd < 0) {
+      return nullptr;
+    }
+    // IORING_OP_READ and IORING_OP_WRITE arrived in Linux 5.6 along with IORING_FEAT_RW_CUR_POS, which tells that
+    // release apart without a probe
+    std::unique_ptr<IoRing> ring{new IoRing{fd, params}};
+    if (ring->cqes_ == nullptr or (params.features & IORING_FEAT_SINGLE_MMAP) == 0 or
+        (params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return nullptr;
+    }
+    return ring;
+  }
+
+  IoRing(IoRing const&) = delete;
+  IoRing(IoRing&&) = delete;
+  IoRing& operator=(IoRing const&) = delete;
+  IoRing& operator=(IoRing&&) = delete;
+
+  ~IoRing() noexcept {
+    if (sqes_ != MAP_FAILED) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (rings_ != MAP_FAILED) {
+      ::munmap(rings_, rings_size_);
+    }
+    ::close(fd_);
+  }
+
+  ///
+  /// @brief Get the number of operations which may be queued or in flight at once
+  ///
+  [[nodiscard]] unsigned Capacity() const noexcept {
+    return capacity_;
+  }
+
+  ///
+  /// @brief Queue a read or write without handing it to the kernel yet
+  ///
+  /// @param opcode IORING_OP_READ or IORING_OP_WRITE
+  /// @param fd the file to read or write
+  /// @param data the buffer, which must stay in place until the operation completes
+  /// @param size the number of bytes to transfer
+  /// @param offset where in the file to transfer them
+  /// @param tag passed back with the completion
+  ///
+  void
+  Queue(std::uint8_t opcode, int fd, void const* data, std::uint32_t size, off_t offset, std::uint64_t tag) noexcept {
+    // only this thread moves the tail
+    unsigned const tail{*sq_tail_};
+    unsigned const index{tail & sq_mask_};
+    sqes_[index] = io_uring_sqe{};
+    sqes_[index].opcode = opcode;
+    sqes_[index].fd = fd;
+    sqes_[index].off = static_cast<std::uint64_t>(offset);
+    sqes_[index].addr = reinterpret_cast<std::uintptr_t>(data);
+    sqes_[index].len = size;
+    sqes_[index].user_data = tag;
+    sq_array_[index] = index;
+    std::atomic_ref{*sq_tail_}.store(tail + 1, std::memory_order_release);
+    ++unsubmitted_;
+  }
+
+  ///
+  /// @brief Hand every queued operation to the kernel, and optionally wait for completions
+  ///
+  /// @param wait the number of completions to wait for
+  /// @return 0, or the errno of the failure
+  ///
+  [[nodiscard]] int Enter(unsigned wait) noexcept {
+    while (true) {
+      long const submitted{
+          ::syscall(__NR_io_uring_enter, fd_, unsubmitted_, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0U, nullptr, 0)};
+      if (submitted >= 0) {
+        unsubmitted_ -= static_cast<unsigned>(submitted);
+        return 0;
+      } else if (errno != EINTR) {
+        return errno;
+      }
+    }
+  }
+
+  ///
+  /// @brief Consume every completion posted so far
+  ///
+  /// @param fn invoked as fn(tag, result) where the result is the number of bytes transferred or a negated errno;
+  ///           it may queue further operations
+  ///
+  template <std::invocable<std::uint64_t, int> Fn> void Reap(Fn&& fn) noexcept {
+    unsigned head{*cq_head_};
+    unsigned const tail{std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire)};
+    for (; head != tail; ++head) {
+      io_uring_cqe const& cqe = cqes_[head & cq_mask_];
+      std::invoke(fn, cqe.user_data, cqe.res);
+    }
+    std::atomic_ref{*cq_head_}.store(head, std::memory_order_release);
+  }
+};
+
+FileWriter::FileWriter(std::string path, int fd, std::unique_ptr<IoRing> ring) noexcept
+    : path_{std::move(path)}, fd_{fd}, ring_{std::move(ring)} {
+}
+
+Result<FileWriter> FileWriter::Create(std::string_view path) {
+  std::string name{path};
+  int const fd{::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)};
+  if (fd < 0) {
+    return std::unexpected{std::format("Cannot write file \"{}\"", path)};
+  }
+  return FileWriter{std::move(name), fd, IoRing::Create(RingEntries)};
+}
+
+// the buffers stay where they are: the nodes of pending_ move over as a whole
+FileWriter::FileWriter(FileWriter&& other) noexcept
+    : path_{std::move(other.path_)},
+      fd_{std::exchange(other.fd_, -1)},
+      ring_{std::move(other.ring_)},
+      pending_{std::move(other.pending_)},
+      next_tag_{other.next_tag_},
+      size_{other.size_},
+      error_{other.error_} {
+}
+
+FileWriter::~FileWriter() noexcept {
+  if (fd_ >= 0) {
+    Submit();
+    Drain();
+    ::close(fd_);
+  }
+}
+
+void FileWriter::Enqueue(std::uint64_t tag) {
+  Pending const& pending = pending_.at(tag);
+  std::size_t const size{std::min(pending.data.size() - pending.written, MaxWrite)};
+  ring_->Queue(IORING_OP_WRITE,
+               fd_,
+               pending.data.data() + pending.written,
+               static_cast<std::uint32_t>(size),
+               pending.offset + static_cast<off_t>(pending.written),
+               tag);
+}
+
+void FileWriter::Reap() noexcept {
+  ring_->Reap([&](std::uint64_t tag, int result) {
+    auto const pending = pending_.find(tag);
+    if (result == -EINTR or result == -EAGAIN) {
+      Enqueue(tag);
+      return;
+    } else if (result <= 0) {
+      // writing nothing at all means the device is full
+      error_ = error_ != 0 ? error_ : (result < 0 ? -result : ENOSPC);
+      pending_.erase(pending);
+      return;
+    }
+    pending->second.written += static_cast<std::size_t>(result);
+    if (pending->second.written < pending->second.data.size()) {
+      Enqueue(tag);
+    } else {
+      pending_.erase(pending);
+    }
+  });
+}
+
+void FileWriter::Drain() noexcept {
+  if (ring_ == nullptr) {
+    // nothing is in flight
+    pending_.clear();
+    return;
+  }
+  while (not pending_.empty()) {
+    if (int const error = ring_->Enter(1); error != 0 and error != EAGAIN and error != EBUSY) {
+      error_ = error_ != 0 ? error_ : error;
+      return;
+    }
+    Reap();
+  }
+}
+
+void FileWriter::Add(std::string buffer, std::string_view data) {
+  if ((buffer.empty() and data.empty()) or error_ != 0) {
+    return;
+  }
+  if (ring_ != nullptr) {
+    // make room for one more operation
+    while (pending_.size() >= ring_->Capacity() and error_ == 0) {
+      if (int const error = ring_->Enter(1); error != 0 and error != EAGAIN and error != EBUSY) {
+        error_ = error;
+      }
+      Reap();
+    }
+    if (error_ != 0) {
+      return;
+    }
+  }
+  std::uint64_t const tag{next_tag_++};
+  Pending& pending = pending_[tag];
+  pending.buffer = std::move(buffer);
+  // only now is the string in its final place (a short one holds its characters inline)
+  pending.data = pending.buffer.empty() ? data : pending.buffer;
+  pending.offset = size_;
+  size_ += static_cast<off_t>(pending.data.size());
+  if (ring_ != nullptr) {
+    Enqueue(tag);
+  }
+}
+
+void FileWriter::Write(std::string buffer) {
+  Add(std::move(buffer), {});
+}
+
+void FileWriter::WriteView(std::string_view buffer) {
+  Add({}, buffer);
+}
+
+void FileWriter::Submit() {
+  if (ring_ != nullptr) {
+    if (int const error = ring_->Enter(0); error != 0 and error != EAGAIN and error != EBUSY) {
+      error_ = error_ != 0 ? error_ : error;
+    }
+    // frees the buffers already written
+    Reap();
+    return;
+  }
+  if (pending_.empty() or error_ != 0) {
+    pending_.clear();
+    return;
+  }
+  std::vector<iovec> batch;
+  batch.reserve(pending_.size());
+  for (Pending const& pending : std::views::values(pending_)) {
+    // iovec is shared with readv, but nothing is written through it here
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    batch.push_back(iovec{.iov_base = const_cast<char*>(pending.data.data()), .iov_len = pending.data.size()});
+  }
+  off_t offset{pending_.begin()->second.offset};
+  std::size_t first{0};
+  while (first < batch.size()) {
+    auto const count = std::min(batch.size() - first, std::size_t{IOV_MAX});
+    ssize_t const written{::pwritev(fd_, &batch[first], static_cast<int>(count), offset)};
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      error_ = errno;
+      break;
+    }
+    offset += written;
+    // skip the buffers written completely and resume the one written partially
+    auto remaining = static_cast<std::size_t>(written);
+    while (first < batch.size() and remaining >= batch[first].iov_len) {
+      remaining -= batch[first].iov_len;
+      ++first;
+    }
+    if (remaining > 0) {
+      batch[first].iov_base = static_cast<char*>(batch[first].iov_base) + remaining;
+      batch[first].iov_len -= remaining;
+    }
+  }
+  pending_.clear();
+}
+
+Result<void> FileWriter::Finish() {
+  Submit();
+  Drain();
+  if (::close(std::exchange(fd_, -1)) != 0 or error_ != 0) {
+    return std::unexpected{std::format("Cannot write file \"{}\"", path_)};
+  }
+  return {};
+}
+
+Result<void> WriteBuffers(std::string_view path, std::span<std::string const> buffers) {
+  return FileWriter::Create(path).and_then([&](FileWriter writer) {
+    for (std::string const& buffer : buffers) {
+      writer.WriteView(buffer);
+    }
+    return writer.Finish();
+  });
+}
+
+///
+/// @brief Read a regular file in pieces which are all requested at once
+///
+/// @param fd
+/// @param contents sized to the file
+/// @return whether the whole file was read
+///
+static bool ReadPieces(int fd, std::string& contents) {
+  auto const ring = IoRing::Create(RingEntries);
+  if (ring == nullptr) {
+    for (std::size_t done{0}; done < contents.size();) {
+      ssize_t const read{::pread(fd, contents.data() + done, contents.size() - done, static_cast<off_t>(done))};
+      if (read < 0 and errno == EINTR) {
+        continue;
+      } else if (read <= 0) {
+        return false;
+      }
+      done += static_cast<std::size_t>(read);
+    }
+    return true;
+  }
+  // start of the part of a piece still to be read -> end of the piece
+  std::map<std::size_t, std::size_t> outstanding;
+  auto const request = [&](std::size_t begin, std::size_t end) {
+    outstanding.emplace(begin, end);
+    ring->Queue(IORING_OP_READ,
+                fd,
+                contents.data() + begin,
+                static_cast<std::uint32_t>(end - begin),
+                static_cast<off_t>(begin),
+                begin);
+  };
+  bool failed{false};
+  std::size_t next{0};
+  do {
+    for (; not failed and next < contents.size() and outstanding.size() < ring->Capacity(); next += ReadPiece) {
+      request(next, std::min(next + ReadPiece, contents.size()));
+    }
+    if (int const error = ring->Enter(1); error != 0 and error != EAGAIN and error != EBUSY) {
+      return false;
+    }
+    ring->Reap([&](std::uint64_t begin, int result) {
+      auto const piece = outstanding.extract(begin);
+      if (result == -EINTR or result == -EAGAIN) {
+        request(begin, piece.mapped());
+      } else if (result <= 0) {
+        // reading nothing at all means the file has shrunk
+        failed = true;
+      } else if (begin + static_cast<std::size_t>(result) < piece.mapped()) {
+        request(begin + static_cast<std::size_t>(result), piece.mapped());
+      }
+    });
+    // even after a failure, the pieces being read must stay in place until they complete
+  } while (not outstanding.empty() or (not failed and next < contents.size()));
+  return not failed;
+}
+
+Result<std::string> ReadFile(std::string_view path) {
+  std::string const name{path};
+  int const fd{::open(name.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (fd < 0) {
+    return std::unexpected{std::format("Cannot read file \"{}\"", path)};
+  }
+  std::string contents;
+  bool read_all{false};
+  // some regular files (e.g. in /proc) have no size until they are read
+  if (struct stat info{}; ::fstat(fd, &info) == 0 and S_ISREG(info.st_mode) and info.st_size > 0) {
+    contents.resize(static_cast<std::size_t>(info.st_size));
+    read_all = ReadPieces(fd, contents);
+  } else {
+    std::array<char, 64 * 1024> chunk{};
+    while (true) {
+      ssize_t const read{::read(fd, chunk.data(), chunk.size())};
+      if (read < 0 and errno == EINTR) {
+        continue;
+      } else if (read <= 0) {
+        read_all = read == 0;
+        break;
+      }
+      contents.append(chunk.data(), static_cast<std::size_t>(read));
+    }
+  }
+  ::close(fd);
+  if (not read_all) {
+    return std::unexpected{std::format("Cannot read file \"{}\"", path)};
+  }
+  return contents;
+}
+
+DOCTEST_TEST_SUITE("utils::WriteBuffers") {
+  DOCTEST_TEST_CASE("utils::WriteBuffers") {
+    ScopedSettings const scope;
+    DOCTEST_SUBCASE("io_uring") {
+    }
+    DOCTEST_SUBCASE("pwritev") {
+      REQUIRE(Settings::GetInstance().Set("io-uring", "off"));
+    }
+    auto const file = (std::filesystem::temp_directory_path() / "buffers.txt").string();
+    std::ofstream{file} << "previous contents which are longer than the new ones";
+
+    // more buffers than fit into a single vectored write or a ring
+    std::vector<std::string> buffers{"head", ""};
+    for (int i{0}; i < IOV_MAX + 10; ++i) {
+      buffers.push_back(std::format("{},", i));
+    }
+    std::string expected;
+    for (std::string const& buffer : buffers) {
+      expected += buffer;
+    }
+    REQUIRE(WriteBuffers(file, buffers));
+    std::ostringstream contents;
+    contents << std::ifstream{file}.rdbuf();
+    CHECK_EQ(contents.str(), expected);
+
+    REQUIRE(WriteBuffers(file, {}));
+    CHECK_EQ(std::filesystem::file_size(file), 0);
+
+    CHECK_FALSE(WriteBuffers("/nonexistent-directory/file", buffers));
+    std::filesystem::remove(file);
+  }
+  DOCTEST_TEST_CASE("utils::FileWriter") {
+    ScopedSettings const scope;
+    DOCTEST_SUBCASE("io_uring") {
+    }
+    DOCTEST_SUBCASE("pwritev") {
+      REQUIRE(Settings::GetInstance().Set("io-uring", "off"));
+    }
+    auto const file = (std::filesystem::temp_directory_path() / "writer.txt").string();
+    auto writer = FileWriter::Create(file);
+    REQUIRE(writer);
+    // buffers handed over after a submit follow the ones before it
+    writer->Write("a");
+    writer->Write(std::string(3 * 1024 * 1024, 'b'));
+    writer->Submit();
+    auto moved = std::move(*writer);
+    moved.Write("c");
+    REQUIRE(moved.Finish());
+    auto const contents = ReadFile(file);
+    REQUIRE(contents);
+    CHECK_EQ(*contents, "a" + std::string(3 * 1024 * 1024, 'b') + "c");
+    std::filesystem::remove(file);
+
+    // buffers which are lent rather than handed over stay with the caller
+    std::string const lent{"lent"};
+    {
+      // a writer which is never finished still writes what it was given
+      auto abandoned = FileWriter::Create(file);
+      REQUIRE(abandoned);
+      abandoned->WriteView(lent);
+      abandoned->Write("abandoned");
+    }
+    CHECK_EQ(ReadFile(file), "lentabandoned");
+    std::filesystem::remove(file);
+  }
+}
+
+DOCTEST_TEST_SUITE("utils::ReadFile") {
+  DOCTEST_TEST_CASE("utils::ReadFile") {
+    ScopedSettings const scope;
+    DOCTEST_SUBCASE("io_uring") {
+    }
+    DOCTEST_SUBCASE("pread") {
+      REQUIRE(Settings::GetInstance().Set("io-uring", "off"));
+    }
+    auto const file = (std::filesystem::temp_directory_path() / "read.txt").string();
+    // several pieces, the last one partial
+    std::string expected;
+    for (std::size_t i{0}; expected.size() < 5 * ReadPiece / 2; ++i) {
+      expected += std::format("{}\n", i);
+    }
+    std::ofstream{file} << expected;
+    auto const contents = ReadFile(file);
+    REQUIRE(contents);
+    CHECK_EQ(*contents, expected);
+
+    std::ofstream{file} << "";
+    auto const empty = ReadFile(file);
+    REQUIRE(empty);
+    CHECK(empty->empty());
+    std::filesystem::remove(file);
+
+    // anything which is not a regular file is read until it ends
+    std::array<int, 2> pipe{};
+    REQUIRE_EQ(::pipe(pipe.data()), 0);
+    REQUIRE_EQ(::write(pipe[1], "piped", 5), 5);
+    ::close(pipe[1]);
+    auto const piped = ReadFile(std::format("/dev/fd/{}", pipe[0]));
+    ::close(pipe[0]);
+    REQUIRE(piped);
+    CHECK_EQ(*piped, "piped");
+
+    CHECK_FALSE(ReadFile("/nonexistent-file"));
+    CHECK_FALSE(ReadFile(std::filesystem::temp_directory_path().string()));
+  }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "utils/utils.hpp"
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+/// a submission and a completion queue shared with the kernel, defined where it is used
+class IoRing;
+
+///
+/// @brief Writes a file from buffers handed over one after another, so that producing the later buffers overlaps
+///        writing the earlier ones
+///
+/// Buffers are queued by Write and handed to the kernel together by Submit. On Linux they are written through an
+/// io_uring: Submit returns at once, and the kernel writes while the caller goes on. Where io_uring is unavailable (or
+/// turned off in Settings), Submit writes the queued buffers with vectored pwritev calls before returning.
+///
+class FileWriter {
+  struct Pending {
+    /// the characters of data if they were handed over, or empty if they were lent
+    std::string buffer;
+    std::string_view data;
+    /// where the data starts in the file
+    off_t offset{0};
+    /// how much of the data is already written
+    std::size_t written{0};
+  };
+
+  std::string path_;
+  int fd_;
+  /// the ring the writes go through, or null to write them with pwritev
+  std::unique_ptr<IoRing> ring_;
+  /// tag -> data which is not yet written completely (tags increase with the offset)
+  std::map<std::uint64_t, Pending> pending_;
+  std::uint64_t next_tag_{0};
+  /// the size of the file once every buffer handed over is written
+  off_t size_{0};
+  /// the first error of any write, or 0
+  int error_{0};
+
+  FileWriter(std::string path, int fd, std::unique_ptr<IoRing> ring) noexcept;
+
+  ///
+  /// @brief Queue data to be written after everything queued before it
+  ///
+  /// @param buffer the characters handed over, or empty
+  /// @param data the characters lent if none were handed over
+  ///
+  void Add(std::string buffer, std::string_view data);
+
+  ///
+  /// @brief Queue the rest of a pending buffer on the ring, making room first if the ring is full
+  ///
+  /// @param tag
+  ///
+  void Enqueue(std::uint64_t tag);
+
+  ///
+  /// @brief Account for every write the ring has completed, queueing the rest of partially written buffers
+  ///
+  void Reap() noexcept;
+
+  ///
+  /// @brief Wait until every buffer handed over is written (or has failed)
+  ///
+  void Drain() noexcept;
+
+public:
+  ///
+  /// @brief Create a file, or truncate an existing one
+  ///
+  /// @param path
+  /// @return the writer, or an error if the file cannot be opened for writing
+  ///
+  [[nodiscard]] static Result<FileWriter> Create(std::string_view path);
+
+  FileWriter(FileWriter&& other) noexcept;
+  FileWriter& operator=(FileWriter&&) = delete;
+  FileWriter(FileWriter const&) = delete;
+  FileWriter& operator=(FileWriter const&) = delete;
+  ///
+  /// @brief Write everything still queued, wait for every write, and close the file, discarding any error (call
+  ///        Finish to see it)
+  ///
+  ~FileWriter() noexcept;
+
+  ///
+  /// @brief Queue a buffer to be written after every buffer queued before it
+  ///
+  /// @param buffer the contents (empty buffers are allowed), kept by the writer until they are written
+  ///
+  void Write(std::string buffer);
+
+  ///
+  /// @brief Queue a buffer to be written after every buffer queued before it, without copying it
+  ///
+  /// @param buffer the contents, which must stay in place until Finish returns (or the writer is destroyed)
+  ///
+  void WriteView(std::string_view buffer);
+
+  ///
+  /// @brief Start writing every queued buffer without waiting for the writes to complete, where possible
+  ///
+  void Submit();
+
+  ///
+  /// @brief Write everything still queued, wait for every write, and close the file
+  ///
+  /// @return Error IFF any buffer could not be written completely or the file could not be closed
+  ///
+  [[nodiscard]] Result<void> Finish();
+};
+
+///
+/// @brief Replace the contents of a file with the concatenation of several buffers
+///
+/// The buffers are handed to the kernel as they are, in a single batch, so that output which was produced in pieces
+/// (e.g. by several threads) is neither joined nor copied through a stream buffer first.
+///
+/// @param path
+/// @param buffers the contents in order (empty buffers are allowed)
+/// @return Error IFF the file could not be created or written completely
+///
+[[nodiscard]] Result<void> WriteBuffers(std::string_view path, std::span<std::string const> buffers);
+
+///
+/// @brief Read a whole file
+///
+/// A regular file is read in pieces which are all requested at once (through io_uring where available, otherwise
+/// with pread); anything else, such as a pipe, is read from front to back until it ends.
+///
+/// @param path
+/// @return the contents, or an error if the file cannot be opened or read
+///
+[[nodiscard]] Result<std::string> ReadFile(std::string_view path);
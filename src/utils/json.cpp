@@ -0,0 +1,197 @@
+#include "json.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+namespace {
+
+///
+/// @brief Builds a document like the default parser, but records the first error instead of throwing it
+///
+struct RecordingParser : nlohmann::detail::json_sax_dom_parser<nlohmann::json> {
+  std::string error;
+
+  explicit RecordingParser(nlohmann::json& result) : json_sax_dom_parser{result, /*allow_exceptions_=*/false} {
+  }
+
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  bool parse_error(std::size_t, std::string const&, nlohmann::detail::exception const& ex) {
+    error = ex.what();
+    return false;
+  }
+};
+
+} // namespace
+
+Result<nlohmann::json> ParseJson(std::istream& input) {
+  nlohmann::json result;
+  RecordingParser parser{result};
+  if (nlohmann::json::sax_parse(input, &parser)) {
+    return result;
+  } else {
+    return std::unexpected{std::move(parser.error)};
+  }
+}
+
+Result<nlohmann::json> ParseJson(std::string_view input) {
+  nlohmann::json result;
+  RecordingParser parser{result};
+  if (nlohmann::json::sax_parse(input.data(), input.data() + input.size(), &parser)) {
+    return result;
+  } else {
+    return std::unexpected{std::move(parser.error)};
+  }
+}
+
+std::string Within(std::string_view location, std::string_view error) {
+  if (error.starts_with('.') or error.starts_with('[')) {
+    return std::format("{}{}", location, error);
+  } else {
+    return std::format("{}: {}", location, error);
+  }
+}
+
+Result<std::string_view> JsonString(nlohmann::json const& value) {
+  if (auto const* s = value.get_ptr<nlohmann::json::string_t const*>(); s != nullptr) {
+    return *s;
+  } else {
+    return std::unexpected{"expected a string"};
+  }
+}
+
+Result<nlohmann::json::array_t const*> JsonArray(nlohmann::json const& value) {
+  if (auto const* a = value.get_ptr<nlohmann::json::array_t const*>(); a != nullptr) {
+    return a;
+  } else {
+    return std::unexpected{"expected an array"};
+  }
+}
+
+JsonWriter::JsonWriter(std::FILE* out) noexcept : out_{out} {
+}
+
+void JsonWriter::Separate() {
+  if (after_key_) {
+    after_key_ = false;
+  } else if (not nonempty_.empty()) {
+    if (nonempty_.back()) {
+      std::fputc(',', out_);
+    }
+    nonempty_.back() = true;
+  }
+}
+
+void JsonWriter::Finish() {
+  if (nonempty_.empty()) {
+    std::fputc('\n', out_);
+  }
+}
+
+void JsonWriter::BeginObject() {
+  Separate();
+  std::fputc('{', out_);
+  nonempty_.push_back(false);
+}
+
+void JsonWriter::EndObject() {
+  nonempty_.pop_back();
+  std::fputc('}', out_);
+  Finish();
+}
+
+void JsonWriter::BeginArray() {
+  Separate();
+  std::fputc('[', out_);
+  nonempty_.push_back(false);
+}
+
+void JsonWriter::EndArray() {
+  nonempty_.pop_back();
+  std::fputc(']', out_);
+  Finish();
+}
+
+void JsonWriter::Key(std::string_view key) {
+  Separate();
+  std::fputs(nlohmann::json(key).dump().c_str(), out_);
+  std::fputc(':', out_);
+  after_key_ = true;
+}
+
+void JsonWriter::Value(nlohmann::json const& value) {
+  Separate();
+  std::fputs(value.dump().c_str(), out_);
+  Finish();
+}
+
+DOCTEST_TEST_SUITE("utils::Json") {
+  DOCTEST_TEST_CASE("utils::ParseJson") {
+    std::istringstream valid{R"({"a": [1, 2]})"};
+    auto const json = ParseJson(valid);
+    REQUIRE(json);
+    CHECK_EQ(*json, R"({"a": [1, 2]})"_json);
+
+    std::istringstream invalid{"{\n  \"a\": [1,\n}"};
+    auto const error = ParseJson(invalid);
+    REQUIRE_FALSE(error);
+    CHECK_NE(error.error().find("line 3"), std::string::npos);
+
+    std::istringstream empty{""};
+    CHECK_FALSE(ParseJson(empty));
+  }
+  DOCTEST_TEST_CASE("utils::ParseJson.InMemory") {
+    auto const json = ParseJson(std::string_view{R"({"a": [1, 2]})"});
+    REQUIRE(json);
+    CHECK_EQ(*json, R"({"a": [1, 2]})"_json);
+    auto const error = ParseJson(std::string_view{"{\n  \"a\": [1,\n}"});
+    REQUIRE_FALSE(error);
+    CHECK_NE(error.error().find("line 3"), std::string::npos);
+    CHECK_FALSE(ParseJson(std::string_view{}));
+  }
+  DOCTEST_TEST_CASE("utils::JsonMember") {
+    auto const json = R"({"name": "a", "size": 3, "big": -5000000000, "items": [true]})"_json;
+    CHECK_EQ(JsonMember(json, "name", JsonString), "a");
+    CHECK_EQ(JsonMember(json, "size", JsonInteger<int>), 3);
+    CHECK_EQ(JsonMember(json, "items", JsonArray).value()->size(), 1);
+    CHECK_EQ(JsonMember(json, "missing", JsonString).error(), "missing 'missing'");
+    CHECK_EQ(JsonMember(json, "size", JsonString).error(), ".size: expected a string");
+    CHECK_FALSE(JsonMember(json, "big", JsonInteger<int>));
+    CHECK_EQ(JsonMember(json, "size", JsonInteger<unsigned>), 3U);
+    CHECK_EQ(JsonMember(json.at("items"), "name", JsonString).error(), "expected an object");
+  }
+  DOCTEST_TEST_CASE("utils::JsonElements") {
+    auto const json = R"({"outer": [[1, 2], [3, "x"]]})"_json;
+    auto const ints = [](nlohmann::json const& v) { return JsonElements(v, JsonInteger<int>); };
+    CHECK_EQ(JsonElements(json.at("outer").at(0), JsonInteger<int>), std::vector{1, 2});
+    CHECK_EQ(JsonMember(json, "outer", [&](auto const& v) { return JsonElements(v, ints); }).error(),
+             ".outer[1][1]: expected an integer");
+    CHECK_EQ(JsonElements(json, ints).error(), "expected an array");
+  }
+  DOCTEST_TEST_CASE("utils::JsonWriter") {
+    std::FILE* file = std::tmpfile();
+    REQUIRE_NE(file, nullptr);
+    JsonWriter writer{file};
+    writer.BeginObject();
+    writer.Key("a");
+    writer.BeginArray();
+    writer.Value(1);
+    writer.Value("two");
+    writer.BeginObject();
+    writer.EndObject();
+    writer.EndArray();
+    writer.Key("b");
+    writer.Value(nullptr);
+    writer.EndObject();
+    writer.Value(3);
+
+    std::rewind(file);
+    std::string written(64, '\0');
+    written.resize(std::fread(written.data(), 1, written.size(), file));
+    std::ignore = std::fclose(file);
+    CHECK_EQ(written, "{\"a\":[1,\"two\",{}],\"b\":null}\n3\n");
+  }
+}
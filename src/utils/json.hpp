@@ -0,0 +1,195 @@
+#pragma once
+
+#include "utils/utils.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <functional>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///
+/// @brief Parse a JSON document without throwing
+///
+/// @param input the stream to read the document from
+/// @return the document, or an error naming the line and column of the first syntax error
+///
+[[nodiscard]] Result<nlohmann::json> ParseJson(std::istream& input);
+
+///
+/// @brief Parse a JSON document held in memory without throwing or copying it
+///
+/// @param input the text of the document
+/// @return the document, or an error naming the line and column of the first syntax error
+///
+[[nodiscard]] Result<nlohmann::json> ParseJson(std::string_view input);
+
+///
+/// @brief Prefix an error with the location of the value it is about
+///
+/// Locations are written as paths such as ".classes[3].fields[0]", so nested prefixes join into a single path.
+///
+/// @param location the path of the value within its parent, e.g. ".name" or "[2]"
+/// @param error the error about the value
+/// @return the prefixed error
+///
+[[nodiscard]] std::string Within(std::string_view location, std::string_view error);
+
+///
+/// @brief Get the value of a JSON string without throwing
+///
+/// @param value
+/// @return Error if the value is not a string
+///
+[[nodiscard]] Result<std::string_view> JsonString(nlohmann::json const& value);
+
+///
+/// @brief Get the elements of a JSON array without throwing
+///
+/// @param value
+/// @return Error if the value is not an array
+///
+[[nodiscard]] Result<nlohmann::json::array_t const*> JsonArray(nlohmann::json const& value);
+
+///
+/// @brief Get the value of a JSON integer without throwing
+///
+/// @tparam T the integral type to convert to
+/// @param value
+/// @return Error if the value is not an integer or does not fit within T
+///
+template <std::integral T> [[nodiscard]] Result<T> JsonInteger(nlohmann::json const& value) {
+  auto const fits = [](auto v) -> Result<T> {
+    if (std::in_range<T>(v)) {
+      return static_cast<T>(v);
+    } else {
+      return std::unexpected{std::format("{} is out of range", v)};
+    }
+  };
+  if (value.is_number_unsigned()) {
+    return fits(value.get<std::uint64_t>());
+  } else if (value.is_number_integer()) {
+    return fits(value.get<std::int64_t>());
+  } else {
+    return std::unexpected{"expected an integer"};
+  }
+}
+
+///
+/// @brief Convert a member of a JSON object without throwing
+///
+/// @param object the JSON object
+/// @param key the name of the member
+/// @param convert a conversion from the member's value to a Result
+/// @return the converted member, or an error (prefixed by the key) if the member is missing or cannot be converted
+///
+template <typename Convert>
+[[nodiscard]] auto JsonMember(nlohmann::json const& object, std::string_view key, Convert&& convert)
+    -> std::invoke_result_t<Convert, nlohmann::json const&> {
+  if (not object.is_object()) {
+    return std::unexpected{"expected an object"};
+  } else if (auto i = object.find(std::string{key}); i == object.end()) {
+    return std::unexpected{std::format("missing '{}'", key)};
+  } else {
+    return std::invoke(std::forward<Convert>(convert), *i).transform_error([&](std::string&& error) {
+      return Within(std::format(".{}", key), error);
+    });
+  }
+}
+
+///
+/// @brief Convert every element of a JSON array without throwing
+///
+/// @param value the JSON array
+/// @param convert a conversion from each element to a Result
+/// @return the converted elements, or the first error (prefixed by the element's index)
+///
+template <typename Convert>
+[[nodiscard]] auto JsonElements(nlohmann::json const& value, Convert&& convert)
+    -> Result<std::vector<typename std::invoke_result_t<Convert, nlohmann::json const&>::value_type>> {
+  using Element = typename std::invoke_result_t<Convert, nlohmann::json const&>::value_type;
+  return JsonArray(value).and_then([&](nlohmann::json::array_t const* elements) -> Result<std::vector<Element>> {
+    std::vector<Element> converted;
+    converted.reserve(elements->size());
+    for (std::size_t i{0}; i < elements->size(); ++i) {
+      if (auto element = std::invoke(convert, (*elements)[i]); element) {
+        converted.push_back(std::move(*element));
+      } else {
+        return std::unexpected{Within(std::format("[{}]", i), element.error())};
+      }
+    }
+    return converted;
+  });
+}
+
+///
+/// @brief Writes compact JSON to a stream piece by piece, so a large document is never built in memory as a whole
+///
+/// Commas and colons are inserted automatically. A newline follows every top-level value.
+///
+class JsonWriter {
+  std::FILE* out_;
+  /// for every open object or array, whether it has a member yet
+  std::vector<bool> nonempty_;
+  /// whether a key was just written, so the next value belongs to it
+  bool after_key_{false};
+
+  ///
+  /// @brief Write the comma due before a new member of the innermost object or array, if any
+  ///
+  void Separate();
+
+  ///
+  /// @brief Write the newline due after a complete top-level value
+  ///
+  void Finish();
+
+public:
+  ///
+  /// @param out the stream to write to, which must outlive the writer
+  ///
+  explicit JsonWriter(std::FILE* out) noexcept;
+
+  ///
+  /// @brief Open an object, whose members are written as pairs of Key() and a value
+  ///
+  void BeginObject();
+
+  ///
+  /// @brief Close the innermost object
+  ///
+  void EndObject();
+
+  ///
+  /// @brief Open an array, whose elements are written as values
+  ///
+  void BeginArray();
+
+  ///
+  /// @brief Close the innermost array
+  ///
+  void EndArray();
+
+  ///
+  /// @brief Write the key of the next member of the innermost object
+  ///
+  /// @param key
+  ///
+  void Key(std::string_view key);
+
+  ///
+  /// @brief Write a complete value
+  ///
+  /// @param value
+  ///
+  void Value(nlohmann::json const& value);
+};
@@ -0,0 +1,86 @@
+#include "mapped_file.hpp"
+
+#include <doctest/doctest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <utility>
+
+MappedFile::MappedFile(char const* data, std::size_t size) noexcept : data_{data}, size_{size} {
+}
+
+Result<MappedFile> MappedFile::Open(std::string_view path) {
+  std::string const name{path};
+  int const fd{::open(name.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (fd < 0) {
+    return std::unexpected{std::format("Cannot open \"{}\"", path)};
+  }
+  struct stat info{};
+  if (::fstat(fd, &info) != 0 or not S_ISREG(info.st_mode)) {
+    ::close(fd);
+    return std::unexpected{std::format("\"{}\" is not a regular file", path)};
+  }
+  auto const size = static_cast<std::size_t>(info.st_size);
+  if (size == 0) {
+    // empty mappings are not allowed
+    ::close(fd);
+    return MappedFile{nullptr, 0};
+  }
+  void* data{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+  // the mapping keeps the file alive on its own
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return std::unexpected{std::format("Cannot map \"{}\"", path)};
+  }
+  ::madvise(data, size, MADV_SEQUENTIAL);
+  return MappedFile{static_cast<char const*>(data), size};
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)} {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
+MappedFile::~MappedFile() noexcept {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+std::string_view MappedFile::Contents() const noexcept {
+  return {data_, size_};
+}
+
+DOCTEST_TEST_SUITE("utils::MappedFile") {
+  DOCTEST_TEST_CASE("utils::MappedFile.Open") {
+    auto const file = (std::filesystem::temp_directory_path() / "mapped.txt").string();
+    std::ofstream{file} << "mapped contents";
+    auto mapped = MappedFile::Open(file);
+    REQUIRE(mapped);
+    CHECK_EQ(mapped->Contents(), "mapped contents");
+
+    auto moved = std::move(*mapped);
+    CHECK_EQ(moved.Contents(), "mapped contents");
+    CHECK(mapped->Contents().empty());
+
+    std::ofstream{file} << "";
+    auto const empty = MappedFile::Open(file);
+    REQUIRE(empty);
+    CHECK(empty->Contents().empty());
+
+    CHECK_FALSE(MappedFile::Open("/nonexistent-file"));
+    CHECK_FALSE(MappedFile::Open(std::filesystem::temp_directory_path().string()));
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "utils/utils.hpp"
+
+#include <cstddef>
+#include <string_view>
+
+///
+/// @brief A read-only view of a whole file mapped into memory, advised for reading from front to back
+///
+/// Reading a mapped file copies nothing: the contents are the page cache's own pages.
+///
+class MappedFile {
+  char const* data_{nullptr};
+  std::size_t size_{0};
+
+  MappedFile(char const* data, std::size_t size) noexcept;
+
+public:
+  ///
+  /// @brief Map a regular file
+  ///
+  /// @param path
+  /// @return the mapping, or an error if the file cannot be opened, is not a regular file, or cannot be mapped
+  ///
+  [[nodiscard]] static Result<MappedFile> Open(std::string_view path);
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+  ~MappedFile() noexcept;
+
+  ///
+  /// @brief Get the contents of the file, valid for as long as the mapping
+  ///
+  [[nodiscard]] std::string_view Contents() const noexcept;
+};
@@ -0,0 +1,43 @@
+#include "parallel.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+std::size_t ChunkCount(std::size_t count, std::size_t min_items_per_chunk) noexcept {
+  std::size_t const threads{std::max(1U, std::thread::hardware_concurrency())};
+  return std::clamp(count / std::max(min_items_per_chunk, 1ZU), 1ZU, threads);
+}
+
+DOCTEST_TEST_SUITE("utils::Parallel") {
+  DOCTEST_TEST_CASE("utils::ChunkCount") {
+    CHECK_EQ(ChunkCount(0), 1);
+    CHECK_EQ(ChunkCount(1), 1);
+    CHECK_GE(ChunkCount(1'000'000), 1);
+    CHECK_LE(ChunkCount(1'000'000), std::max(1U, std::thread::hardware_concurrency()));
+    CHECK_EQ(ChunkCount(2, 1), std::min(2U, std::max(1U, std::thread::hardware_concurrency())));
+  }
+  DOCTEST_TEST_CASE("utils::ChunkBegin") {
+    CHECK_EQ(ChunkBegin(0, 4, 10), 0);
+    CHECK_EQ(ChunkBegin(1, 4, 10), 2);
+    CHECK_EQ(ChunkBegin(2, 4, 10), 5);
+    CHECK_EQ(ChunkBegin(4, 4, 10), 10);
+  }
+  DOCTEST_TEST_CASE("utils::ParallelFor") {
+    for (std::size_t count : {0ZU, 1ZU, 100ZU, 100'000ZU}) {
+      std::vector<int> seen(count, 0);
+      std::atomic<std::size_t> chunks_seen{0};
+      ParallelFor(count, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i{begin}; i < end; ++i) {
+          ++seen[i];
+        }
+        ++chunks_seen;
+      });
+      CHECK_EQ(chunks_seen.load(), ChunkCount(count));
+      CHECK_EQ(std::accumulate(seen.begin(), seen.end(), 0ZU), count);
+      CHECK(std::ranges::all_of(seen, [](int n) { return n == 1; }));
+    }
+  }
+}
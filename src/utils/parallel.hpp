@@ -0,0 +1,60 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/// the fewest cheap work items worth starting a thread for
+constexpr inline std::size_t DefaultItemsPerChunk{2048};
+
+///
+/// @brief Determine how many contiguous chunks a workload of a given size should be split into
+///
+/// Small workloads are never split so that thread start-up cost is only paid when it can be amortized
+///
+/// @param count the number of work items
+/// @param min_items_per_chunk the fewest items worth starting a thread for (1 if every item is expensive)
+/// @return a chunk count in [1, hardware threads]
+///
+[[nodiscard]] std::size_t ChunkCount(std::size_t count,
+                                     std::size_t min_items_per_chunk = DefaultItemsPerChunk) noexcept;
+
+///
+/// @brief Get the half-open bounds of a chunk
+///
+/// @param chunk the zero-based chunk index
+/// @param chunks the total number of chunks
+/// @param count the number of work items
+/// @return the first item of the chunk (the last chunk ends at count)
+///
+[[nodiscard]] constexpr std::size_t ChunkBegin(std::size_t chunk, std::size_t chunks, std::size_t count) noexcept {
+  return chunk * count / chunks;
+}
+
+///
+/// @brief Invoke a function over [0, count) split into ChunkCount(count, min_items_per_chunk) contiguous chunks, one
+///        per thread
+///
+/// The calling thread processes the first chunk. All chunks have completed when this returns.
+///
+/// @param count the number of work items
+/// @param fn invoked as fn(chunk, begin, end)
+/// @param min_items_per_chunk the fewest items worth starting a thread for
+///
+template <std::invocable<std::size_t, std::size_t, std::size_t> Fn>
+void ParallelFor(std::size_t count, Fn&& fn, std::size_t min_items_per_chunk = DefaultItemsPerChunk) {
+  std::size_t const chunks{ChunkCount(count, min_items_per_chunk)};
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (std::size_t chunk{1}; chunk < chunks; ++chunk) {
+    workers.emplace_back([&fn, chunk, chunks, count] {
+      std::invoke(fn, chunk, ChunkBegin(chunk, chunks, count), ChunkBegin(chunk + 1, chunks, count));
+    });
+  }
+  std::invoke(fn, 0ZU, 0ZU, ChunkBegin(1, chunks, count));
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
@@ -0,0 +1,141 @@
+#include "settings.hpp"
+
+#include <doctest/doctest.h>
+
+#include <format>
+#include <ranges>
+#include <utility>
+
+static Result<bool> ToggleFromString(std::string_view value) {
+  if (value == "on") {
+    return true;
+  } else if (value == "off") {
+    return false;
+  } else {
+    return std::unexpected{std::format("expected 'on' or 'off' but got '{}'", value)};
+  }
+}
+
+static Result<std::set<std::string, std::less<>>> BuiltinsFromString(std::string_view value) {
+  if (value == "default") {
+    return Settings::DefaultBuiltins();
+  }
+  std::set<std::string, std::less<>> builtins;
+  for (auto part : std::views::split(value, ',')) {
+    if (part.empty()) {
+      return std::unexpected{std::format("expected a comma-separated list of types but got '{}'", value)};
+    }
+    builtins.emplace(std::string_view{part});
+  }
+  return builtins;
+}
+
+static Result<OutputFormat> OutputFormatFromString(std::string_view value) {
+  if (value == "text") {
+    return OutputFormat::Text;
+  } else if (value == "json") {
+    return OutputFormat::Json;
+  } else {
+    return std::unexpected{std::format("expected 'text' or 'json' but got '{}'", value)};
+  }
+}
+
+std::set<std::string, std::less<>> Settings::DefaultBuiltins() {
+  return {"any",  "array",  "auto",   "bool",       "byte",  "char",       "double",   "float",  "int",
+          "list", "long",   "map",    "optional",   "pair",  "set",        "short",    "signed", "size_t",
+          "std",  "str",    "string", "shared_ptr", "tuple", "unique_ptr", "unsigned", "vector", "void"};
+}
+
+Settings& Settings::GetInstance() noexcept {
+  static Settings settings;
+  return settings;
+}
+
+Result<void> Settings::Set(std::string_view setting, std::string_view value) {
+  if (setting == "hash-consing") {
+    return ToggleFromString(value).transform([&](bool on) { hash_consing_ = on; });
+  } else if (setting == "strict-types") {
+    return ToggleFromString(value).transform([&](bool on) { strict_types_ = on; });
+  } else if (setting == "io-uring") {
+    return ToggleFromString(value).transform([&](bool on) { io_uring_ = on; });
+  } else if (setting == "builtins") {
+    return BuiltinsFromString(value).transform([&](auto&& builtins) { builtins_ = std::move(builtins); });
+  } else if (setting == "output") {
+    return OutputFormatFromString(value).transform([&](OutputFormat format) { output_ = format; });
+  } else {
+    return std::unexpected{std::format("unknown setting '{}'", setting)};
+  }
+}
+
+bool Settings::HashConsing() const noexcept {
+  return hash_consing_;
+}
+
+bool Settings::StrictTypes() const noexcept {
+  return strict_types_;
+}
+
+bool Settings::IoUring() const noexcept {
+  return io_uring_;
+}
+
+std::set<std::string, std::less<>> const& Settings::Builtins() const noexcept {
+  return builtins_;
+}
+
+OutputFormat Settings::Output() const noexcept {
+  return output_;
+}
+
+ScopedSettings::~ScopedSettings() noexcept {
+  Settings::GetInstance() = std::move(saved_);
+}
+
+DOCTEST_TEST_SUITE("utils::Settings") {
+  DOCTEST_TEST_CASE("utils::Settings.Set") {
+    Settings s;
+    CHECK_FALSE(s.HashConsing());
+    CHECK(s.Set("hash-consing", "on"));
+    CHECK(s.HashConsing());
+    CHECK_FALSE(s.Set("hash-consing", "yes"));
+    CHECK(s.HashConsing());
+    CHECK(s.Set("hash-consing", "off"));
+    CHECK_FALSE(s.HashConsing());
+    CHECK_FALSE(s.Set("bogus", "on"));
+
+    CHECK_FALSE(s.StrictTypes());
+    CHECK(s.Set("strict-types", "on"));
+    CHECK(s.StrictTypes());
+
+    CHECK(s.IoUring());
+    CHECK(s.Set("io-uring", "off"));
+    CHECK_FALSE(s.IoUring());
+
+    CHECK_EQ(s.Output(), OutputFormat::Text);
+    CHECK(s.Set("output", "json"));
+    CHECK_EQ(s.Output(), OutputFormat::Json);
+    CHECK_FALSE(s.Set("output", "xml"));
+    CHECK_EQ(s.Output(), OutputFormat::Json);
+  }
+  DOCTEST_TEST_CASE("utils::Settings.Builtins") {
+    Settings s;
+    CHECK(s.Builtins().contains("int"));
+    CHECK(s.Set("builtins", "int,Money"));
+    CHECK_EQ(s.Builtins(), std::set<std::string, std::less<>>{"Money", "int"});
+    CHECK_FALSE(s.Set("builtins", "int,,bool"));
+    CHECK_FALSE(s.Set("builtins", ","));
+    CHECK_EQ(s.Builtins().size(), 2);
+    CHECK(s.Set("builtins", "default"));
+    CHECK_EQ(s.Builtins(), Settings::DefaultBuiltins());
+  }
+  DOCTEST_TEST_CASE("utils::ScopedSettings") {
+    {
+      ScopedSettings const scope;
+      REQUIRE(Settings::GetInstance().Set("hash-consing", "on"));
+      REQUIRE(Settings::GetInstance().Set("builtins", "Money"));
+      CHECK(Settings::GetInstance().HashConsing());
+    }
+    CHECK_FALSE(Settings::GetInstance().HashConsing());
+    CHECK_EQ(Settings::GetInstance().Builtins(), Settings::DefaultBuiltins());
+  }
+}
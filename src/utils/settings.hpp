@@ -0,0 +1,96 @@
+#pragma once
+
+#include "utils/utils.hpp"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+
+///
+/// @brief How commands which report on a diagram print their results
+///
+enum class OutputFormat : std::uint8_t {
+  Text, ///< human-readable text and class boxes
+  Json  ///< compact JSON, one document per command
+};
+
+///
+/// @brief Session-wide options which change how the editor behaves but not what a diagram contains
+///
+class Settings {
+  bool hash_consing_{false};
+  bool strict_types_{false};
+  bool io_uring_{true};
+  OutputFormat output_{OutputFormat::Text};
+  std::set<std::string, std::less<>> builtins_{DefaultBuiltins()};
+
+public:
+  ///
+  /// @brief The name of every setting which may be passed to Set
+  ///
+  static constexpr std::array<std::string_view, 5> Names{
+      "hash-consing", "strict-types", "io-uring", "builtins", "output"};
+
+  ///
+  /// @brief The type names which are considered resolved without naming a class unless configured otherwise
+  ///
+  [[nodiscard]] static std::set<std::string, std::less<>> DefaultBuiltins();
+
+  ///
+  /// @brief Singleton for Settings
+  ///
+  [[nodiscard]] static Settings& GetInstance() noexcept;
+
+  ///
+  /// @brief Change a setting
+  ///
+  /// @param setting the name of the setting
+  /// @param value the new value ("on" or "off" for toggles; a comma-separated list or "default" for builtins; "text"
+  ///              or "json" for output)
+  /// @return error IFF the setting doesn't exist or the value is invalid for it
+  ///
+  [[nodiscard]] Result<void> Set(std::string_view setting, std::string_view value);
+
+  ///
+  /// @brief Whether structurally identical fields and methods share storage
+  ///
+  [[nodiscard]] bool HashConsing() const noexcept;
+
+  ///
+  /// @brief Whether commands may only leave type identifiers which name a class or a builtin
+  ///
+  [[nodiscard]] bool StrictTypes() const noexcept;
+
+  ///
+  /// @brief Whether files are read and written through io_uring where the kernel offers it
+  ///
+  [[nodiscard]] bool IoUring() const noexcept;
+
+  ///
+  /// @brief Get the type names which do not need to name a class
+  ///
+  [[nodiscard]] std::set<std::string, std::less<>> const& Builtins() const noexcept;
+
+  ///
+  /// @brief Get how list, query, and search commands print their results
+  ///
+  [[nodiscard]] OutputFormat Output() const noexcept;
+};
+
+///
+/// @brief Restores every setting to its value at construction once destroyed, however the scope is left
+///
+class ScopedSettings {
+  Settings saved_{Settings::GetInstance()};
+
+public:
+  ScopedSettings() = default;
+  ScopedSettings(ScopedSettings const&) = delete;
+  ScopedSettings(ScopedSettings&&) = delete;
+  ScopedSettings& operator=(ScopedSettings const&) = delete;
+  ScopedSettings& operator=(ScopedSettings&&) = delete;
+  ~ScopedSettings() noexcept;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "utils/settings.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+///
+/// @brief Immutable, reference-counted storage which is copied only when it is about to be modified
+///
+/// When hash-consing is enabled (see Settings), Share replaces the storage with an existing structurally equal
+/// instance so that identical values throughout every diagram (and every history snapshot) are stored once. T must
+/// be copyable, equality comparable, and provide `std::size_t Hash() const noexcept`.
+///
+/// A default-constructed value allocates nothing until it is first edited; until then it reads as a single empty T
+/// shared by every such value.
+///
+template <typename T> class Shared {
+  static constexpr std::size_t MinimumSweep{1024};
+
+  struct Pool {
+    std::mutex mutex;
+    std::unordered_multimap<std::size_t, std::weak_ptr<T>> entries;
+    /// pool size at which expired entries are next swept
+    std::size_t sweep_at{MinimumSweep};
+  };
+
+  /// the value, or null for a default-constructed value which was never edited
+  std::shared_ptr<T> data_;
+  /// whether data_ is reachable from the pool (and must never be modified in place)
+  bool interned_{false};
+
+  [[nodiscard]] static Pool& GetPool() noexcept {
+    static Pool pool;
+    return pool;
+  }
+
+  [[nodiscard]] static T const& Empty() noexcept {
+    static T const empty{};
+    return empty;
+  }
+
+public:
+  Shared() = default;
+
+  explicit Shared(T value) : data_{std::make_shared<T>(std::move(value))} {
+    Share();
+  }
+
+  [[nodiscard]] T const& operator*() const noexcept {
+    return data_ != nullptr ? *data_ : Empty();
+  }
+
+  [[nodiscard]] T const* operator->() const noexcept {
+    return &**this;
+  }
+
+  ///
+  /// @brief Get mutable access, copying the value first unless this is its only owner
+  ///
+  /// The value stays private until Share is called.
+  ///
+  /// @return the (now unshared) value
+  ///
+  [[nodiscard]] T& Edit() {
+    if (data_ == nullptr) {
+      data_ = std::make_shared<T>();
+    } else if (interned_ or data_.use_count() > 1) {
+      data_ = std::make_shared<T>(std::as_const(*data_));
+      interned_ = false;
+    }
+    return *data_;
+  }
+
+  ///
+  /// @brief Intern the value if hash-consing is enabled
+  ///
+  void Share() {
+    if (interned_ or data_ == nullptr or not Settings::GetInstance().HashConsing()) {
+      return;
+    }
+    Pool& pool = GetPool();
+    std::size_t const hash{data_->Hash()};
+    std::scoped_lock const lock{pool.mutex};
+    auto [entry, last] = pool.entries.equal_range(hash);
+    while (entry != last) {
+      if (auto existing = entry->second.lock(); not existing) {
+        entry = pool.entries.erase(entry);
+      } else if (*existing == *data_) {
+        data_ = std::move(existing);
+        interned_ = true;
+        return;
+      } else {
+        ++entry;
+      }
+    }
+    pool.entries.emplace(hash, data_);
+    interned_ = true;
+    if (pool.entries.size() >= pool.sweep_at) {
+      std::erase_if(pool.entries, [](auto const& e) { return e.second.expired(); });
+      pool.sweep_at = std::max(MinimumSweep, 2 * pool.entries.size());
+    }
+  }
+
+  ///
+  /// @brief Check whether two values share the same storage
+  ///
+  [[nodiscard]] bool SharesWith(Shared const& other) const noexcept {
+    return data_ == other.data_;
+  }
+};
@@ -106,6 +106,25 @@ Result<int> IntFromString(std::string_view s) {
   }
 }
 
+std::vector<std::string_view> TypeIdentifiers(std::string_view type) {
+  std::vector<std::string_view> identifiers;
+  std::size_t idx{0};
+  while (idx < type.size()) {
+    if (not AlNum(type[idx])) {
+      ++idx;
+      continue;
+    }
+    std::size_t const start{idx};
+    while (idx < type.size() and AlNum(type[idx])) {
+      ++idx;
+    }
+    if (Alpha(type[start])) {
+      identifiers.push_back(type.substr(start, idx - start));
+    }
+  }
+  return identifiers;
+}
+
 DOCTEST_TEST_SUITE("utils") {
   DOCTEST_TEST_CASE("utils::Alpha") {
     for (auto c = static_cast<char>(-1); c < 127;) {
@@ -196,4 +215,13 @@ DOCTEST_TEST_SUITE("utils") {
     CHECK_FALSE(IntFromString("123 ").has_value());
     CHECK_FALSE(IntFromString(" 123").has_value());
   }
+  DOCTEST_TEST_CASE("utils::TypeIdentifiers") {
+    CHECK(TypeIdentifiers("").empty());
+    CHECK(TypeIdentifiers("<>*").empty());
+    CHECK_EQ(TypeIdentifiers("int"), std::vector<std::string_view>{"int"});
+    CHECK_EQ(TypeIdentifiers("int**"), std::vector<std::string_view>{"int"});
+    CHECK_EQ(TypeIdentifiers("map<Key,vector<Value*>>"),
+             std::vector<std::string_view>{"map", "Key", "vector", "Value"});
+    CHECK_EQ(TypeIdentifiers("A[A,b2(_c)]"), std::vector<std::string_view>{"A", "A", "b2", "_c"});
+  }
 }
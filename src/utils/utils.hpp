@@ -70,3 +70,13 @@ static inline constexpr bool AlNum(char c) noexcept {
 /// @return Error if parsing could not be performed else the held integer
 ///
 [[nodiscard]] Result<int> IntFromString(std::string_view s);
+
+///
+/// @brief Extract every identifier mentioned within a type
+///
+/// e.g. "map<Key,vector<Value*>>" yields {"map", "Key", "vector", "Value"}
+///
+/// @param type the type to scan
+/// @return the identifiers in order of appearance (duplicates included)
+///
+[[nodiscard]] std::vector<std::string_view> TypeIdentifiers(std::string_view type);